@@ -0,0 +1,142 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/BenchmarkMapsCommandlet.h"
+#include "Tools/Core/MapBenchmark.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/Parse.h"
+#include <algorithm>
+
+
+UBenchmarkMapsCommandlet::UBenchmarkMapsCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UBenchmarkMapsCommandlet::Main(const FString& Params)
+{
+	const TCHAR* cmd = *Params;
+	Helpers::MapBenchmark::Options options;
+
+	FString list;
+	if (FParse::Value(cmd, TEXT("sizes="), list))
+	{
+		TArray<FString> sizes;
+		list.ParseIntoArray(sizes, TEXT(","));
+		options.sizes.clear();
+		for (const FString& s : sizes)
+		{
+			options.sizes.push_back(FMath::Max(FCString::Atoi(*s), 1));
+		}
+	}
+	int32 maxRooms = 0;
+	if (FParse::Value(cmd, TEXT("maxrooms="), maxRooms))
+	{
+		options.sizes.erase(std::remove_if(options.sizes.begin(), options.sizes.end(), [maxRooms](int32 n) { return n > maxRooms; }), options.sizes.end());
+	}
+	if (FParse::Value(cmd, TEXT("layouts="), list))
+	{
+		TArray<FString> names;
+		list.ParseIntoArray(names, TEXT(","));
+		options.layouts.clear();
+		for (const FString& name : names)
+		{
+			Helpers::RoomLayout layout;
+			if (Helpers::MapBenchmark::parseLayout(name, layout))
+				options.layouts.push_back(layout);
+			else
+				UE_LOG(LogTemp, Warning, TEXT("BenchmarkMaps: unknown layout %s"), *name);
+		}
+	}
+	FParse::Value(cmd, TEXT("repeat="), options.repeats);
+	FParse::Value(cmd, TEXT("budget="), options.budget);
+	FParse::Value(cmd, TEXT("seed="), options.seed);
+	FParse::Value(cmd, TEXT("threads="), options.maxThreads);
+	FParse::Value(cmd, TEXT("threadrooms="), options.threadRooms);
+	FParse::Value(cmd, TEXT("threadmaps="), options.threadMaps);
+
+	FString outDir = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Benchmarks"));
+	FParse::Value(cmd, TEXT("out="), outDir);
+	IFileManager::Get().MakeDirectory(*outDir, true);
+	FString baselinePath;
+	FParse::Value(cmd, TEXT("baseline="), baselinePath);
+	float threshold = 1.25f;
+	FParse::Value(cmd, TEXT("threshold="), threshold);
+
+	std::vector<Helpers::BenchmarkRow> rows;
+	for (Helpers::RoomLayout layout : options.layouts)
+	{
+		const int32 first = (int32)rows.size();
+		Helpers::MapBenchmark::runStages(options, layout, rows);
+		for (int32 i = first; i < (int32)rows.size(); i++)
+		{
+			const Helpers::BenchmarkRow& r = rows[i];
+			if (r.skipped)
+				UE_LOG(LogTemp, Display, TEXT("BenchmarkMaps: %-13s %-9s %8d rooms  skipped, over budget"), *r.stage, Helpers::MapBenchmark::layoutName(layout), r.rooms);
+			else
+				UE_LOG(LogTemp, Display, TEXT("BenchmarkMaps: %-13s %-9s %8d rooms %10.3f ms %10lld items"), *r.stage, Helpers::MapBenchmark::layoutName(layout), r.rooms, r.seconds * 1000.0, r.items);
+		}
+	}
+
+	const int32 first = (int32)rows.size();
+	Helpers::MapBenchmark::runThroughput(options, rows);
+	for (int32 i = first; i < (int32)rows.size(); i++)
+	{
+		const Helpers::BenchmarkRow& r = rows[i];
+		const double speedup = rows[first].seconds / FMath::Max(r.seconds, 1e-9);
+		UE_LOG(LogTemp, Display, TEXT("BenchmarkMaps: %2d threads %8.1f maps/sec, x%.2f, %.0f%% efficiency"),
+			r.threads, 1.0 / FMath::Max(r.seconds, 1e-9), speedup, speedup * 100.0 / r.threads);
+	}
+
+	FString fits;
+	for (Helpers::RoomLayout layout : options.layouts)
+	{
+		for (const TCHAR* stage : { TEXT("sample"), TEXT("separate"), TEXT("select"), TEXT("distance"),
+			TEXT("triangulate"), TEXT("spanning_tree"), TEXT("hallways"), TEXT("metrics"), TEXT("pipeline") })
+		{
+			const Helpers::ComplexityFit f = Helpers::MapBenchmark::fit(rows, stage, layout);
+			fits += FString::Printf(TEXT("%-13s %-9s n^%.2f  closest %-7s  %d points\n"), stage,
+				Helpers::MapBenchmark::layoutName(layout), f.exponent, f.model, f.points);
+		}
+	}
+	TArray<FString> lines;
+	fits.ParseIntoArrayLines(lines);
+	for (const FString& l : lines)
+	{
+		UE_LOG(LogTemp, Display, TEXT("BenchmarkMaps: %s"), *l);
+	}
+	FFileHelper::SaveStringToFile(fits, *FPaths::Combine(outDir, TEXT("fits.txt")));
+	FFileHelper::SaveStringToFile(Helpers::MapBenchmark::toCsv(rows), *FPaths::Combine(outDir, TEXT("bench.csv")));
+
+	if (baselinePath.IsEmpty())
+		return 0;
+
+	if (FParse::Param(cmd, TEXT("savebaseline")))
+	{
+		const bool saved = Helpers::MapBenchmark::saveBaseline(rows, baselinePath, threshold);
+		UE_LOG(LogTemp, Display, TEXT("BenchmarkMaps: baseline %s %s"), saved ? TEXT("written to") : TEXT("could not be written to"), *baselinePath);
+		return saved ? 0 : 1;
+	}
+
+	std::vector<Helpers::BaselineRow> baseline;
+	if (!Helpers::MapBenchmark::loadBaseline(baselinePath, baseline))
+	{
+		UE_LOG(LogTemp, Error, TEXT("BenchmarkMaps: no baseline at %s"), *baselinePath);
+		return 1;
+	}
+
+	FString report;
+	const int32 regressions = Helpers::MapBenchmark::compare(rows, baseline, threshold, report);
+	lines.Reset();
+	report.ParseIntoArrayLines(lines);
+	for (const FString& l : lines)
+	{
+		UE_LOG(LogTemp, Error, TEXT("BenchmarkMaps: regression %s"), *l);
+	}
+	UE_LOG(LogTemp, Display, TEXT("BenchmarkMaps: %d regressions against %s"), regressions, *baselinePath);
+	return regressions > 0 ? 1 : 0;
+}
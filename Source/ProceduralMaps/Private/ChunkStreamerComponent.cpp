@@ -0,0 +1,239 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/ChunkStreamerComponent.h"
+#include "Public/Room.h"
+#include "Components/LineBatchComponent.h"
+#include "Async/Async.h"
+#include "HAL/PlatformTime.h"
+#include "Tools/Core/MapEventLog.h"
+#include "Engine/World.h"
+
+
+UChunkStreamerComponent::UChunkStreamerComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+}
+
+void UChunkStreamerComponent::OnRegister()
+{
+	Super::OnRegister();
+	if (!m_Lines && GetOwner())
+	{
+		m_Lines = NewObject<ULineBatchComponent>(GetOwner(), NAME_None, RF_Transient);
+		m_Lines->bAbsoluteLocation = true;
+		m_Lines->bAbsoluteRotation = true;
+		m_Lines->bAbsoluteScale = true;
+		m_Lines->RegisterComponentWithWorld(GetWorld());
+	}
+}
+
+void UChunkStreamerComponent::OnUnregister()
+{
+	UnloadAll();
+	if (m_Lines)
+	{
+		m_Lines->DestroyComponent();
+		m_Lines = nullptr;
+	}
+	Super::OnUnregister();
+}
+
+Helpers::ChunkParams UChunkStreamerComponent::params() const
+{
+	Helpers::ChunkParams p;
+	p.seed = m_Seed;
+	p.chunkSize = FMath::Max(m_ChunkSize, 1000.f);
+	p.roomsPerChunk = FMath::Max(m_RoomsPerChunk, 1);
+	return p;
+}
+
+const Helpers::MapChunk* UChunkStreamerComponent::FindChunk(FIntPoint coord) const
+{
+	const LoadedChunk* chunk = m_Loaded.Find(coord);
+	return chunk ? chunk->data.Get() : nullptr;
+}
+
+bool UChunkStreamerComponent::inRadius(FIntPoint coord, FIntPoint center, int32 radius) const
+{
+	return FMath::Abs(coord.X - center.X) <= radius && FMath::Abs(coord.Y - center.Y) <= radius;
+}
+
+void UChunkStreamerComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	if (!m_Enabled || !GetOwner())
+		return;
+
+	const FVector loc = GetOwner()->GetActorLocation();
+	const FIntPoint center = Helpers::ChunkGenerator::chunkOf(params(), FVector2D(loc.X, loc.Y));
+
+	collectFinished(center);
+	unloadFar(center);
+	requestChunks(center);
+
+	if (m_LinesDirty)
+		redrawLines();
+}
+
+// nearest missing chunks first
+void UChunkStreamerComponent::requestChunks(FIntPoint center)
+{
+	const Helpers::ChunkParams p = params();
+	for (int32 ring = 0; ring <= m_LoadRadius && m_Pending.Num() < m_MaxTasks; ring++)
+	{
+		for (int32 y = center.Y - ring; y <= center.Y + ring; y++)
+		{
+			for (int32 x = center.X - ring; x <= center.X + ring; x++)
+			{
+				const FIntPoint coord(x, y);
+				if (!inRadius(coord, center, ring) || inRadius(coord, center, ring - 1))
+					continue;
+				if (m_Loaded.Contains(coord) || m_Pending.Contains(coord) || m_Pending.Num() >= m_MaxTasks)
+					continue;
+
+				m_Pending.Add(coord, Async<TSharedPtr<Helpers::MapChunk>>(EAsyncExecution::ThreadPool, [p, coord]()
+				{
+					const double start = FPlatformTime::Seconds();
+					TSharedPtr<Helpers::MapChunk> chunk = MakeShared<Helpers::MapChunk>(Helpers::ChunkGenerator::generate(p, coord));
+					MAP_EVENT(Info, ChunkLoaded, coord.X, coord.Y, (FPlatformTime::Seconds() - start) * 1000.0);
+					return chunk;
+				}));
+			}
+		}
+	}
+}
+
+void UChunkStreamerComponent::collectFinished(FIntPoint center)
+{
+	for (auto it = m_Pending.CreateIterator(); it; ++it)
+	{
+		if (!it.Value().IsReady())
+			continue;
+
+		TSharedPtr<Helpers::MapChunk> data = it.Value().Get();
+		const FIntPoint coord = it.Key();
+		it.RemoveCurrent();
+
+		// the owner may have walked away while it was generating
+		if (!inRadius(coord, center, m_LoadRadius + 1))
+			continue;
+
+		LoadedChunk& chunk = m_Loaded.Add(coord);
+		chunk.data = data;
+		onChunkLoaded(coord, chunk);
+	}
+}
+
+void UChunkStreamerComponent::unloadFar(FIntPoint center)
+{
+	for (auto it = m_Loaded.CreateIterator(); it; ++it)
+	{
+		if (inRadius(it.Key(), center, m_LoadRadius + 1))
+			continue;
+		MAP_EVENT(Info, ChunkUnloaded, it.Key().X, it.Key().Y);
+		unloadChunk(it.Value());
+		it.RemoveCurrent();
+	}
+}
+
+void UChunkStreamerComponent::onChunkLoaded(FIntPoint coord, LoadedChunk& chunk)
+{
+	m_LinesDirty = true;
+	if (!m_RoomClass || !GetWorld())
+		return;
+
+	// actors by room index of the chunk map, portals leave a null slot
+	const std::vector<Helpers::MapRoom>& rooms = chunk.data->map.rooms;
+	chunk.actors.SetNumZeroed(rooms.size());
+	for (int32 i = 0; i < (int32)rooms.size(); i++)
+	{
+		const Helpers::MapRoom& room = rooms[i];
+		if (room.flags & Helpers::Room_Portal)
+			continue;
+
+		FActorSpawnParameters tParams;
+		tParams.Owner = GetOwner();
+		const FVector loc(room.center.X, room.center.Y, 226.f);
+		ARoom* rm = GetWorld()->SpawnActor<ARoom>(m_RoomClass, loc, FRotator::ZeroRotator, tParams);
+		if (!rm)
+			continue;
+		rm->SetActorScale3D(FVector(room.extent.X / 50.f, room.extent.Y / 50.f, 6.f));
+		rm->m_Scale = room.scale;
+		rm->m_Id = i;
+		chunk.actors[i] = rm;
+	}
+}
+
+void UChunkStreamerComponent::unloadChunk(LoadedChunk& chunk)
+{
+	for (AActor* actor : chunk.actors)
+	{
+		if (actor)
+			actor->Destroy();
+	}
+	chunk.actors.Reset();
+	chunk.data.Reset();
+	m_LinesDirty = true;
+}
+
+void UChunkStreamerComponent::UnloadAll()
+{
+	// results of running tasks are not needed anymore
+	for (auto& kv : m_Pending)
+	{
+		kv.Value.Wait();
+	}
+	m_Pending.Reset();
+
+	for (auto& kv : m_Loaded)
+	{
+		unloadChunk(kv.Value);
+	}
+	m_Loaded.Reset();
+	if (m_Lines)
+		m_Lines->Flush();
+}
+
+// only the loaded square is drawn, so rebuilding it all is cheap
+void UChunkStreamerComponent::redrawLines()
+{
+	m_LinesDirty = false;
+	if (!m_Lines)
+		return;
+	m_Lines->Flush();
+	if (!m_DrawChunks)
+		return;
+
+	const Helpers::ChunkParams p = params();
+	const float z = 250.f;
+	TArray<FBatchedLine> lines;
+	for (const auto& kv : m_Loaded)
+	{
+		const Helpers::GeneratedMap& map = kv.Value.data->map;
+
+		const FBox2D b = Helpers::ChunkGenerator::chunkBounds(p, kv.Key);
+		const FVector c[4] = { FVector(b.Min.X, b.Min.Y, z), FVector(b.Max.X, b.Min.Y, z), FVector(b.Max.X, b.Max.Y, z), FVector(b.Min.X, b.Max.Y, z) };
+		for (int32 i = 0; i < 4; i++)
+		{
+			lines.Add(FBatchedLine(c[i], c[(i + 1) % 4], FLinearColor::White, 0.f, 10.f, SDPG_World));
+		}
+
+		for (const auto& line : map.hallways)
+		{
+			for (size_t i = 1; i < line.size(); i++)
+			{
+				lines.Add(FBatchedLine(FVector(line[i - 1], z), FVector(line[i], z), FLinearColor::Yellow, 0.f, 20.f, SDPG_World));
+			}
+		}
+
+		for (const Helpers::MapRoom& room : map.rooms)
+		{
+			if (!(room.flags & Helpers::Room_Portal))
+				continue;
+			const FVector pos(room.center, z);
+			lines.Add(FBatchedLine(pos - FVector(room.extent.X, 0.f, 0.f), pos + FVector(room.extent.X, 0.f, 0.f), FLinearColor::Green, 0.f, 20.f, SDPG_World));
+			lines.Add(FBatchedLine(pos - FVector(0.f, room.extent.Y, 0.f), pos + FVector(0.f, room.extent.Y, 0.f), FLinearColor::Green, 0.f, 20.f, SDPG_World));
+		}
+	}
+	m_Lines->DrawLines(lines);
+}
@@ -0,0 +1,286 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/GenerateMapsCommandlet.h"
+#include "Tools/Core/MapGenerator.h"
+#include "Tools/Core/MapArena.h"
+#include "Tools/Core/MapStats.h"
+#include "Tools/Core/MapEventLog.h"
+#include "Tools/Core/MapFile.h"
+#include "Tools/Core/MapStream.h"
+#include "Tools/Core/GraphMetrics.h"
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/Parse.h"
+
+
+namespace {
+	const int32 BatchSize = 256;
+
+	struct SeedResult
+	{
+		int32 seed = 0;
+		int32 rooms = 0;
+		int32 edges = 0;
+		bool valid = false;
+		Helpers::MapStageTimes times;
+		FString roles;		// csv line, with -roles
+	};
+
+	// every room reachable through the edges, every edge has a hallway
+	bool validateMap(const Helpers::GeneratedMap& map, bool hallways)
+	{
+		const int32 n = (int32)map.rooms.size();
+		if (n == 0)
+			return false;
+		if (hallways && map.hallways.size() != map.edges.size())
+			return false;
+
+		std::vector<int32> parent(n);
+		for (int32 i = 0; i < n; i++)
+			parent[i] = i;
+		auto root = [&](int32 x)
+		{
+			while (parent[x] != x)
+			{
+				parent[x] = parent[parent[x]];
+				x = parent[x];
+			}
+			return x;
+		};
+
+		int32 groups = n;
+		for (const auto& e : map.edges)
+		{
+			if (e.first < 0 || e.first >= n || e.second < 0 || e.second >= n)
+				return false;
+			const int32 a = root(e.first);
+			const int32 b = root(e.second);
+			if (a != b)
+			{
+				parent[a] = b;
+				groups--;
+			}
+		}
+		return groups == 1;
+	}
+
+	// writes the map as a stream file, then reads the counts back from its End block
+	bool streamMap(const FString& path, const Helpers::MapParams& params, SeedResult& r)
+	{
+		if (!Helpers::MapStreamWriter::generateTo(params, path, &r.times))
+			return false;
+
+		Helpers::MapStreamReader reader;
+		Helpers::MapBlock block;
+		if (!reader.open(path))
+			return false;
+		while (reader.next(block))
+		{
+		}
+		if (reader.failed() || block.type != Helpers::MapBlockType::End)
+			return false;
+
+		r.rooms = (int32)block.totals[0];
+		r.edges = (int32)block.totals[2];
+		return r.rooms > 0 && (!params.routeHallways || block.totals[3] == block.totals[2]);
+	}
+}
+
+UGenerateMapsCommandlet::UGenerateMapsCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UGenerateMapsCommandlet::Main(const FString& Params)
+{
+	const TCHAR* cmd = *Params;
+
+	FString seeds = TEXT("0-99");
+	FParse::Value(cmd, TEXT("seeds="), seeds);
+	FString first, last;
+	if (!seeds.Split(TEXT("-"), &first, &last))
+	{
+		first = last = seeds;
+	}
+	const int32 firstSeed = FCString::Atoi(*first);
+	const int32 lastSeed = FCString::Atoi(*last);
+
+	int32 shard = 0;
+	int32 shards = 1;
+	FString shardText;
+	if (FParse::Value(cmd, TEXT("shard="), shardText))
+	{
+		FString index, count;
+		if (shardText.Split(TEXT("/"), &index, &count))
+		{
+			shard = FCString::Atoi(*index);
+			shards = FMath::Max(FCString::Atoi(*count), 1);
+		}
+	}
+
+	int32 threads = 0;
+	FParse::Value(cmd, TEXT("threads="), threads);
+
+	FString outDir = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("GeneratedMaps"));
+	FParse::Value(cmd, TEXT("out="), outDir);
+	IFileManager::Get().MakeDirectory(*outDir, true);
+
+	Helpers::MapParams params;
+	FParse::Value(cmd, TEXT("rooms="), params.totalRooms);
+	FParse::Value(cmd, TEXT("range="), params.roomRange);
+	FParse::Value(cmd, TEXT("radius="), params.spawnRadius);
+	FParse::Value(cmd, TEXT("spacing="), params.spacing);
+	FParse::Value(cmd, TEXT("loops="), params.loopChance);
+	FParse::Value(cmd, TEXT("cell="), params.cellSize);
+	FParse::Value(cmd, TEXT("cluster="), params.roomsPerCluster);
+	FParse::Value(cmd, TEXT("snap="), params.snapSize);
+	FString graph;
+	if (FParse::Value(cmd, TEXT("graph="), graph))
+	{
+		const TCHAR* modes[] = { TEXT("mst"), TEXT("gabriel"), TEXT("rng"), TEXT("beta"), TEXT("spanner") };
+		int32 mode = INDEX_NONE;
+		for (int32 m = 0; m < ARRAY_COUNT(modes); m++)
+		{
+			if (graph == modes[m])
+				mode = m;
+		}
+		if (mode == INDEX_NONE)
+		{
+			UE_LOG(LogTemp, Error, TEXT("GenerateMaps: unknown -graph=%s, use mst, gabriel, rng, beta or spanner"), *graph);
+			return 1;
+		}
+		params.graphMode = (Helpers::MapGraphMode)mode;
+	}
+	FParse::Value(cmd, TEXT("beta="), params.beta);
+	FParse::Value(cmd, TEXT("stretch="), params.stretch);
+	params.routeHallways = !FParse::Param(cmd, TEXT("nohallways"));
+	const bool writeMaps = FParse::Param(cmd, TEXT("write"));
+	const bool streamMaps = FParse::Param(cmd, TEXT("stream"));
+	const bool roles = FParse::Param(cmd, TEXT("roles")) && !streamMaps;
+
+	if (FParse::Param(cmd, TEXT("events")))
+	{
+		Helpers::MapEventLog::start(Helpers::MapEventLog::Sink_File, FPaths::Combine(outDir, FString::Printf(TEXT("events_%d.log"), shard)));
+	}
+
+	const FString progressPath = FPaths::Combine(outDir, FString::Printf(TEXT("progress_%d.txt"), shard));
+	const FString timingsPath = FPaths::Combine(outDir, FString::Printf(TEXT("timings_%d.csv"), shard));
+	const FString rolesPath = FPaths::Combine(outDir, FString::Printf(TEXT("roles_%d.csv"), shard));
+
+	// first seed of this shard, or where the last run stopped
+	int32 next = firstSeed + shard;
+	FString progress;
+	if (FParse::Param(cmd, TEXT("resume")) && FFileHelper::LoadFileToString(progress, *progressPath))
+	{
+		next = FMath::Max(next, FCString::Atoi(*progress));
+	}
+	else
+	{
+		FFileHelper::SaveStringToFile(TEXT("seed,rooms,edges,valid,spawn_ms,separate_ms,select_ms,distance_ms,triangulate_ms,mst_ms,hallways_ms,total_ms\n"), *timingsPath);
+		if (roles)
+			FFileHelper::SaveStringToFile(TEXT("seed,start,boss,treasures,diameter,dead_ends,articulation_points,metrics_ms\n"), *rolesPath);
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("GenerateMaps: seeds %d-%d shard %d/%d from %d into %s"), firstSeed, lastSeed, shard, shards, next, *outDir);
+
+	const double start = FPlatformTime::Seconds();
+	int32 done = 0;
+	int32 invalid = 0;
+	Helpers::MapStageSummary summary;
+	std::vector<SeedResult> results;
+	while (next <= lastSeed)
+	{
+		results.clear();
+		for (int32 s = next; s <= lastSeed && (int32)results.size() < BatchSize; s += shards)
+		{
+			SeedResult r;
+			r.seed = s;
+			results.push_back(r);
+		}
+
+		// threads > 0 caps the workers by splitting the batch into that many runs
+		const int32 workers = threads > 0 ? FMath::Min(threads, (int32)results.size()) : (int32)results.size();
+		ParallelFor(workers, [&](int32 w)
+		{
+			// scratch and output buffers reused for every seed of this worker
+			Helpers::MapArena arena;
+			Helpers::GeneratedMap map;
+			for (int32 i = w; i < (int32)results.size(); i += workers)
+			{
+				SeedResult& r = results[i];
+				Helpers::MapParams p = params;
+				p.seed = r.seed;
+				if (streamMaps)
+				{
+					r.valid = streamMap(FPaths::Combine(outDir, FString::Printf(TEXT("%d.pms"), r.seed)), p, r);
+					continue;
+				}
+
+				Helpers::MapGenerator::generate(p, map, &r.times, &arena);
+				r.rooms = (int32)map.rooms.size();
+				r.edges = (int32)map.edges.size();
+				r.valid = validateMap(map, p.routeHallways);
+				if (roles)
+				{
+					Helpers::GraphMetrics::Options options;
+					options.seed = r.seed;
+					Helpers::RoomGraphMetrics metrics;
+					Helpers::GraphMetrics::compute(r.rooms, map.edges, options, metrics);
+					FString treasures;
+					for (int32 t : metrics.treasures)
+					{
+						treasures += FString::Printf(TEXT("%s%d"), treasures.IsEmpty() ? TEXT("") : TEXT(" "), t);
+					}
+					r.roles = FString::Printf(TEXT("%d,%d,%d,%s,%d,%d,%d,%.3f\n"), r.seed, metrics.start, metrics.boss, *treasures,
+						metrics.diameter, (int32)metrics.deadEnds.size(), (int32)metrics.articulationPoints.size(), metrics.seconds * 1000.0);
+				}
+				if (writeMaps)
+				{
+					Helpers::MapFile::write(map, FPaths::Combine(outDir, FString::Printf(TEXT("%d.pmap"), r.seed)));
+				}
+			}
+		}, threads == 1);
+
+		FString lines;
+		FString roleLines;
+		for (const SeedResult& r : results)
+		{
+			roleLines += r.roles;
+			const Helpers::MapStageTimes& t = r.times;
+			summary.add(t);
+			lines += FString::Printf(TEXT("%d,%d,%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n"), r.seed, r.rooms, r.edges, r.valid ? 1 : 0,
+				t.spawn * 1000.0, t.separate * 1000.0, t.select * 1000.0, t.distance * 1000.0,
+				t.triangulate * 1000.0, t.spanningTree * 1000.0, t.hallways * 1000.0, t.total() * 1000.0);
+			if (!r.valid)
+			{
+				UE_LOG(LogTemp, Error, TEXT("GenerateMaps: seed %d gave an invalid map"), r.seed);
+				invalid++;
+			}
+		}
+		FFileHelper::SaveStringToFile(lines, *timingsPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+		if (roles)
+			FFileHelper::SaveStringToFile(roleLines, *rolesPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+
+		// only after the batch is on disk, a killed run redoes at most one batch
+		next = results.back().seed + shards;
+		FFileHelper::SaveStringToFile(FString::FromInt(next), *progressPath);
+
+		done += (int32)results.size();
+		const double elapsed = FPlatformTime::Seconds() - start;
+		UE_LOG(LogTemp, Display, TEXT("GenerateMaps: %d maps, %.1f maps/sec"), done, done / FMath::Max(elapsed, 1e-6));
+	}
+
+	const double elapsed = FPlatformTime::Seconds() - start;
+	UE_LOG(LogTemp, Display, TEXT("GenerateMaps: finished %d maps in %.2fs (%.1f maps/sec), %d invalid"),
+		done, elapsed, done / FMath::Max(elapsed, 1e-6), invalid);
+	summary.log();
+	Helpers::MapEventLog::stop();
+	FFileHelper::SaveStringToFile(summary.toString(), *FPaths::Combine(outDir, FString::Printf(TEXT("summary_%d.txt"), shard)));
+	return invalid > 0 ? 1 : 0;
+}
@@ -0,0 +1,152 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/HallwayMeshComponent.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Materials/MaterialInterface.h"
+
+
+UHallwayMeshComponent::UHallwayMeshComponent(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	bUseAsyncCooking = true;
+}
+
+void UHallwayMeshComponent::OnUnregister()
+{
+	// the task reads the builder
+	if (m_Building)
+	{
+		m_Task.Wait();
+		m_Building = false;
+	}
+	Super::OnUnregister();
+}
+
+void UHallwayMeshComponent::BuildHallways(const Helpers::GridFrame& frame, FIntPoint gridSize, const std::vector<FBox2D>& rooms,
+	const std::vector<std::vector<FBox2D>>& hallways)
+{
+	if (m_Building)
+	{
+		// the builder is in use by the task, finish it first
+		m_Task.Wait();
+		m_Building = false;
+	}
+
+	ClearAllMeshSections();
+	m_SectionOfChunk.Reset();
+	m_FreeSections.Reset();
+	m_Ready.Reset();
+	m_PendingEdits.Reset();
+
+	m_Builder.m_WallHeight = m_WallHeight;
+	m_Builder.m_FloorZ = m_FloorZ;
+	m_Builder.init(frame, gridSize.X, gridSize.Y, rooms);
+	m_Builder.setHallways(hallways);
+	startBuild();
+}
+
+void UHallwayMeshComponent::RebuildHallway(int32 index, const std::vector<FBox2D>& rects)
+{
+	if (m_Building)
+	{
+		m_PendingEdits.Add(TPair<int32, std::vector<FBox2D>>(index, rects));
+		return;
+	}
+	m_Builder.setHallway(index, rects);
+	startBuild();
+}
+
+bool UHallwayMeshComponent::IsBuilding() const
+{
+	return m_Building || m_Ready.Num() > 0;
+}
+
+void UHallwayMeshComponent::startBuild()
+{
+	std::vector<FIntPoint> dirty = m_Builder.takeDirtyChunks();
+	if (dirty.empty())
+		return;
+
+	const Helpers::HallwayMeshBuilder* builder = &m_Builder;
+	m_Building = true;
+	m_Task = Async<TArray<Helpers::HallwaySection>>(EAsyncExecution::ThreadPool, [builder, dirty]()
+	{
+		TArray<Helpers::HallwaySection> sections;
+		sections.SetNum((int32)dirty.size());
+		ParallelFor(sections.Num(), [&](int32 i)
+		{
+			builder->buildChunk(dirty[i], sections[i]);
+		});
+		return sections;
+	});
+}
+
+void UHallwayMeshComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (m_Building && m_Task.IsReady())
+	{
+		TArray<Helpers::HallwaySection> sections = m_Task.Get();
+		m_Building = false;
+
+		// a chunk is in a batch only once, drop what an older batch left of it
+		TSet<FIntPoint> rebuilt;
+		for (const Helpers::HallwaySection& section : sections)
+		{
+			rebuilt.Add(section.chunk);
+		}
+		m_Ready.RemoveAll([&rebuilt](const Helpers::HallwaySection& section)
+		{
+			return rebuilt.Contains(section.chunk);
+		});
+		m_Ready.Append(MoveTemp(sections));
+
+		// apply edits that waited for the builder
+		if (m_PendingEdits.Num() > 0)
+		{
+			for (const auto& edit : m_PendingEdits)
+			{
+				m_Builder.setHallway(edit.Key, edit.Value);
+			}
+			m_PendingEdits.Reset();
+			startBuild();
+		}
+	}
+
+	// hand over a few sections per frame
+	int32 budget = m_SectionsPerFrame;
+	while (budget-- > 0 && m_Ready.Num() > 0)
+	{
+		Helpers::HallwaySection section = MoveTemp(m_Ready.Last());
+		m_Ready.Pop(false);
+
+		int32* existing = m_SectionOfChunk.Find(section.chunk);
+		if (section.triangles.Num() == 0)
+		{
+			if (existing)
+			{
+				ClearMeshSection(*existing);
+				m_FreeSections.Add(*existing);
+				m_SectionOfChunk.Remove(section.chunk);
+			}
+			continue;
+		}
+
+		int32 idx;
+		if (existing)
+			idx = *existing;
+		else if (m_FreeSections.Num() > 0)
+			idx = m_FreeSections.Pop();
+		else
+			idx = m_SectionOfChunk.Num() + m_FreeSections.Num();
+		m_SectionOfChunk.Add(section.chunk, idx);
+
+		CreateMeshSection_LinearColor(idx, section.vertices, section.triangles, section.normals, section.uvs,
+			TArray<FLinearColor>(), TArray<FProcMeshTangent>(), m_CreateCollision);
+		if (m_Material)
+			SetMaterial(idx, m_Material);
+	}
+}
@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/MapDebugOverlay.h"
+#include "Components/LineBatchComponent.h"
+#include "Engine/World.h"
+
+
+UMapDebugOverlayComponent::UMapDebugOverlayComponent()
+{
+	// nothing to do per frame, batches are only touched when data changes
+	PrimaryComponentTick.bCanEverTick = false;
+
+	for (int32 i = 0; i < (int32)EOverlayLayer::Count; i++)
+	{
+		m_LineCounts[i] = 0;
+	}
+}
+
+void UMapDebugOverlayComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	UWorld* world = GetWorld();
+	if (!world || m_Batches.Num() > 0)
+		return;
+
+	for (int32 i = 0; i < (int32)EOverlayLayer::Count; i++)
+	{
+		// same setup the world uses for its own line batcher
+		ULineBatchComponent* batch = NewObject<ULineBatchComponent>(this, NAME_None, RF_Transient);
+		batch->bCalculateAccurateBounds = false;
+		batch->RegisterComponentWithWorld(world);
+		m_Batches.Add(batch);
+	}
+	applyVisibility();
+}
+
+void UMapDebugOverlayComponent::OnUnregister()
+{
+	for (ULineBatchComponent* batch : m_Batches)
+	{
+		if (batch)
+			batch->DestroyComponent();
+	}
+	m_Batches.Reset();
+
+	Super::OnUnregister();
+}
+
+#if WITH_EDITOR
+void UMapDebugOverlayComponent::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	applyVisibility();
+}
+#endif
+
+void UMapDebugOverlayComponent::SetLayerVisible(EOverlayLayer layer, bool state)
+{
+	if (layer == EOverlayLayer::Count)
+		return;
+
+	layerFlag(layer) = state;
+	applyVisibility();
+}
+
+void UMapDebugOverlayComponent::ClearLayer(EOverlayLayer layer)
+{
+	int32 idx = (int32)layer;
+	if (!m_Batches.IsValidIndex(idx))
+		return;
+
+	m_Batches[idx]->Flush();
+	m_LineCounts[idx] = 0;
+}
+
+void UMapDebugOverlayComponent::ClearAll()
+{
+	for (int32 i = 0; i < (int32)EOverlayLayer::Count; i++)
+	{
+		ClearLayer((EOverlayLayer)i);
+	}
+}
+
+// upload a whole layer in one go. Lifetime 0 keeps the lines until the next Flush
+void UMapDebugOverlayComponent::SetLayerSegments(EOverlayLayer layer, const std::vector<std::pair<FVector2D, FVector2D>>& segments,
+	float z, FColor color, float thickness)
+{
+	int32 idx = (int32)layer;
+	if (!m_Batches.IsValidIndex(idx))
+		return;
+
+	TArray<FBatchedLine> lines;
+	lines.Reserve(segments.size());
+	for (const auto& s : segments)
+	{
+		lines.Emplace(FVector(s.first, z), FVector(s.second, z), FLinearColor(color), 0.f, thickness, SDPG_World);
+	}
+
+	ULineBatchComponent* batch = m_Batches[idx];
+	batch->Flush();
+	batch->DrawLines(lines);
+	m_LineCounts[idx] = lines.Num();
+}
+
+int32 UMapDebugOverlayComponent::GetLayerLineCount(EOverlayLayer layer) const
+{
+	int32 idx = (int32)layer;
+	return idx < (int32)EOverlayLayer::Count ? m_LineCounts[idx] : 0;
+}
+
+bool& UMapDebugOverlayComponent::layerFlag(EOverlayLayer layer)
+{
+	switch (layer)
+	{
+	case EOverlayLayer::Triangles:
+		return m_ShowTriangles;
+	case EOverlayLayer::MinSpTree:
+		return m_ShowMinSpTree;
+	default:
+		return m_ShowHallways;
+	}
+}
+
+void UMapDebugOverlayComponent::applyVisibility()
+{
+	for (int32 i = 0; i < m_Batches.Num(); i++)
+	{
+		m_Batches[i]->SetVisibility(layerFlag((EOverlayLayer)i));
+	}
+}
@@ -104,9 +104,3 @@ void ARoom::testMatChange()
 	MeshCube->SetMaterial(0, Mat_Green);
 }
 
-void ARoom::updateLocation()
-{
-	m_Loc.X = (double)GetActorLocation().X;
-	m_Loc.Y = (double)GetActorLocation().Y;
-}
-
@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Public/RoomContentComponent.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "Async/Async.h"
+#include "HAL/PlatformTime.h"
+#include "Tools/Core/MapEventLog.h"
+
+
+Helpers::ContentRule FRoomContentRule::toRule() const
+{
+	Helpers::ContentRule r;
+	r.density = density;
+	r.minCount = minCount;
+	r.maxCount = maxCount;
+	r.margin = margin;
+	r.spacing = spacing;
+	r.minScale = minScale;
+	r.maxScale = maxScale;
+	r.roles = (bNormalRooms ? Helpers::Content_Normal : 0) | (bStartRoom ? Helpers::Content_Start : 0)
+		| (bBossRoom ? Helpers::Content_Boss : 0) | (bTreasureRooms ? Helpers::Content_Treasure : 0);
+	return r;
+}
+
+URoomContentComponent::URoomContentComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+}
+
+void URoomContentComponent::OnUnregister()
+{
+	// the task reads its own copies, but the result would land on a dead component
+	if (m_Building)
+	{
+		m_Task.Wait();
+		m_Building = false;
+	}
+	Super::OnUnregister();
+}
+
+void URoomContentComponent::PopulateRooms(const std::vector<FBox2D>& rooms, const std::vector<int32>& ids, const std::vector<uint8>& roles, int32 seed)
+{
+	ClearContent();
+
+	m_BuildRules = m_Rules;
+	std::vector<Helpers::ContentRule> rules;
+	for (const FRoomContentRule& rule : m_BuildRules)
+	{
+		rules.push_back(rule.toRule());
+	}
+	m_Building = true;
+	m_StartTime = FPlatformTime::Seconds();
+	m_Task = Async<Helpers::RoomContent>(EAsyncExecution::ThreadPool, [rules, rooms, ids, roles, seed]()
+	{
+		Helpers::RoomContent content;
+		Helpers::RoomContentBuilder::populate(rules, rooms, ids, roles, seed, content);
+		return content;
+	});
+}
+
+void URoomContentComponent::ClearContent()
+{
+	if (m_Building)
+	{
+		m_Task.Wait();
+		m_Building = false;
+	}
+	for (UHierarchicalInstancedStaticMeshComponent* instances : m_Instances)
+	{
+		if (instances)
+			instances->DestroyComponent();
+	}
+	m_Instances.Reset();
+	for (AActor* actor : m_Actors)
+	{
+		if (actor)
+			actor->Destroy();
+	}
+	m_Actors.Reset();
+	m_SpawnQueue.Reset();
+	m_SpawnNext = 0;
+}
+
+void URoomContentComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (m_Building && m_Task.IsReady())
+	{
+		m_Building = false;
+		applyContent(m_Task.Get());
+	}
+	drainSpawnQueue();
+}
+
+void URoomContentComponent::applyContent(const Helpers::RoomContent& content)
+{
+	// items come grouped by room, sort them out by rule
+	TArray<TArray<FTransform>> meshItems;
+	meshItems.SetNum(m_BuildRules.Num());
+	int32 actors = 0;
+	for (const Helpers::ContentItem& item : content.items)
+	{
+		const FRoomContentRule& rule = m_BuildRules[item.rule];
+		const FTransform transform(FRotator(0.f, item.yaw, 0.f), FVector(item.position.X, item.position.Y, m_FloorZ), FVector(item.scale));
+		if (rule.actorClass)
+		{
+			m_SpawnQueue.Add({ item.rule, transform });
+			actors++;
+		}
+		else if (rule.mesh)
+		{
+			meshItems[item.rule].Add(transform);
+		}
+	}
+
+	int32 instanced = 0;
+	for (int32 r = 0; r < meshItems.Num(); r++)
+	{
+		if (meshItems[r].Num() == 0)
+			continue;
+		UHierarchicalInstancedStaticMeshComponent* instances = NewObject<UHierarchicalInstancedStaticMeshComponent>(GetOwner());
+		instances->SetStaticMesh(m_BuildRules[r].mesh);
+		instances->bAbsoluteLocation = true;
+		instances->bAbsoluteRotation = true;
+		instances->bAbsoluteScale = true;
+		instances->RegisterComponent();
+		instances->AttachToComponent(this, FAttachmentTransformRules::KeepWorldTransform);
+		for (const FTransform& transform : meshItems[r])
+		{
+			instances->AddInstanceWorldSpace(transform);
+		}
+		instanced += meshItems[r].Num();
+		m_Instances.Add(instances);
+	}
+
+	MAP_EVENT(Info, RoomContent, instanced, actors, (FPlatformTime::Seconds() - m_StartTime) * 1000.0);
+}
+
+void URoomContentComponent::drainSpawnQueue()
+{
+	UWorld* world = GetWorld();
+	if (!world || m_SpawnNext >= m_SpawnQueue.Num())
+		return;
+
+	const double end = FPlatformTime::Seconds() + m_SpawnBudgetMs / 1000.0;
+	do
+	{
+		const PendingSpawn& spawn = m_SpawnQueue[m_SpawnNext++];
+		FActorSpawnParameters tParams;
+		tParams.Owner = GetOwner();
+		tParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+		if (AActor* actor = world->SpawnActor<AActor>(m_BuildRules[spawn.rule].actorClass, spawn.transform, tParams))
+			m_Actors.Add(actor);
+	} while (m_SpawnNext < m_SpawnQueue.Num() && FPlatformTime::Seconds() < end);
+
+	if (m_SpawnNext >= m_SpawnQueue.Num())
+	{
+		m_SpawnQueue.Reset();
+		m_SpawnNext = 0;
+	}
+}
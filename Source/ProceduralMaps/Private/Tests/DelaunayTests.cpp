@@ -0,0 +1,148 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Tools/DelTraingle/delaunay.h"
+#include "Tools/DelTraingle/numeric.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace {
+	using Point = dt::Vector2<int32_t>;
+
+	const int64 M = dt::MaxExactCoordinate;
+
+	// twice the area covered by the triangles, each counted once whatever its winding
+	int64 doubleArea(const Helpers::MapVector<dt::Triangle<int32_t>>& triangles)
+	{
+		int64 area = 0;
+		for (const auto& t : triangles)
+		{
+			area += FMath::Abs(dt::orient2d(t.a->x, t.a->y, t.b->x, t.b->y, t.c->x, t.c->y));
+		}
+		return area;
+	}
+
+	// how many of 'points' are a corner of some triangle
+	int32 usedPoints(const std::vector<Point>& points, const Helpers::MapVector<dt::Triangle<int32_t>>& triangles)
+	{
+		int32 used = 0;
+		for (const Point& p : points)
+		{
+			for (const auto& t : triangles)
+			{
+				if (t.containsVertex(p))
+				{
+					used++;
+					break;
+				}
+			}
+		}
+		return used;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDelaunayOrient2dTest, "ProceduralMaps.Delaunay.Orient2d",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FDelaunayOrient2dTest::RunTest(const FString& Parameters)
+{
+	// collinear near MaxExactCoordinate
+	TestEqual(TEXT("diagonal through the origin"), dt::orient2d(-M, -M, M, M, 0, 0), (int64)0);
+	TestEqual(TEXT("diagonal near its end"), dt::orient2d(-M, -M, M, M, M - 1, M - 1), (int64)0);
+	TestEqual(TEXT("anti diagonal"), dt::orient2d(-M, M, M, -M, 3, -3), (int64)0);
+	TestEqual(TEXT("shallow line"), dt::orient2d(-M, -M + 1, M, M - 1, 0, 0), (int64)0);
+
+	// one step off the line
+	TestTrue(TEXT("step left of the diagonal"), dt::orient2d(-M, -M, M, M, M - 1, M) > 0);
+	TestTrue(TEXT("step right of the diagonal"), dt::orient2d(-M, -M, M, M, M, M - 1) < 0);
+	TestTrue(TEXT("step left of the shallow line"), dt::orient2d(-M, -M + 1, M, M - 1, 0, 1) > 0);
+	TestTrue(TEXT("step right of the shallow line"), dt::orient2d(-M, -M + 1, M, M - 1, 1, 0) < 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDelaunayIncircleTest, "ProceduralMaps.Delaunay.Incircle",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FDelaunayIncircleTest::RunTest(const FString& Parameters)
+{
+	// cocircular on the axes
+	TestEqual(TEXT("on the circle"), dt::incircle(M, 0, 0, M, -M, 0, 0, -M), 0);
+	TestTrue(TEXT("one step inside"), dt::incircle(M, 0, 0, M, -M, 0, 0, -M + 1) > 0);
+	TestTrue(TEXT("one step outside"), dt::incircle(M, 0, 0, M, -M, 0, 0, -M - 1) < 0);
+	TestTrue(TEXT("clockwise abc flips the sign"), dt::incircle(-M, 0, 0, M, M, 0, 0, -M + 1) < 0);
+
+	// 3-4-5 points, none on an axis
+	const int64 k = M / 5;
+	TestEqual(TEXT("3-4-5 on the circle"), dt::incircle(3 * k, 4 * k, -4 * k, 3 * k, -3 * k, -4 * k, 4 * k, -3 * k), 0);
+	TestTrue(TEXT("3-4-5 one step inside"), dt::incircle(3 * k, 4 * k, -4 * k, 3 * k, -3 * k, -4 * k, 4 * k - 1, -3 * k) > 0);
+	TestTrue(TEXT("3-4-5 one step outside"), dt::incircle(3 * k, 4 * k, -4 * k, 3 * k, -3 * k, -4 * k, 4 * k, -3 * k - 1) < 0);
+
+	// the same circle moved into a corner of the range
+	const int64 o = M - 5 * k;
+	TestEqual(TEXT("3-4-5 in a corner on the circle"),
+		dt::incircle(o + 3 * k, o + 4 * k, o - 4 * k, o + 3 * k, o - 3 * k, o - 4 * k, o + 4 * k, o - 3 * k), 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDelaunayIntTriangulationTest, "ProceduralMaps.Delaunay.IntTriangulation",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FDelaunayIntTriangulationTest::RunTest(const FString& Parameters)
+{
+	const int32_t m = dt::MaxExactCoordinate;
+	{
+		std::vector<Point> points = { Point(0, 0), Point(1, 0), Point(0, 1) };
+		dt::Delaunay<int32_t> triangulation;
+		TestEqual(TEXT("three points"), (int32)triangulation.triangulate(points).size(), 1);
+	}
+	{
+		// the second copy is on every circle, so it never enters the triangulation
+		std::vector<Point> points = { Point(0, 0), Point(0, 0), Point(1, 0), Point(0, 1) };
+		dt::Delaunay<int32_t> triangulation;
+		TestEqual(TEXT("duplicated point"), (int32)triangulation.triangulate(points).size(), 1);
+	}
+	{
+		// four cocircular points at the edge of the range, either diagonal is fine
+		std::vector<Point> points = { Point(m, 0), Point(0, m), Point(-m, 0), Point(0, -m) };
+		dt::Delaunay<int32_t> triangulation;
+		const auto& triangles = triangulation.triangulate(points);
+		TestEqual(TEXT("cocircular diamond triangles"), (int32)triangles.size(), 2);
+		TestEqual(TEXT("cocircular diamond area"), doubleArea(triangles), 4 * (int64)m * m);
+	}
+	{
+		// a row of collinear points with one apex, every one of them a corner
+		std::vector<Point> points;
+		for (int32 i = 0; i < 8; i++)
+		{
+			points.push_back(Point(-m + i * (m / 4), -m));
+		}
+		points.push_back(Point(0, m));
+		dt::Delaunay<int32_t> triangulation;
+		const auto& triangles = triangulation.triangulate(points);
+		TestEqual(TEXT("collinear row triangles"), (int32)triangles.size(), 7);
+		TestEqual(TEXT("collinear row corners"), usedPoints(points, triangles), (int32)points.size());
+	}
+	{
+		// a lattice is all cocircular squares, it still has to be covered once without gaps
+		const int32 n = 6;
+		const int32_t step = 2 * m / (n - 1);
+		std::vector<Point> points;
+		for (int32 y = 0; y < n; y++)
+		{
+			for (int32 x = 0; x < n; x++)
+			{
+				points.push_back(Point(-m + x * step, -m + y * step));
+			}
+		}
+		dt::Delaunay<int32_t> triangulation;
+		const auto& triangles = triangulation.triangulate(points);
+		const int64 side = (int64)(n - 1) * step;
+		TestEqual(TEXT("lattice triangles"), (int32)triangles.size(), 2 * (n - 1) * (n - 1));
+		TestEqual(TEXT("lattice area"), doubleArea(triangles), 2 * side * side);
+		TestEqual(TEXT("lattice corners"), usedPoints(points, triangles), (int32)points.size());
+	}
+	return true;
+}
+
+#endif
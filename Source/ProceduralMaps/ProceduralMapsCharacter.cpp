@@ -9,14 +9,25 @@
 #include "GameFramework/Controller.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "Public/Room.h"
+#include "Public/MapDebugOverlay.h"
+#include "Public/HallwayMeshComponent.h"
+#include "Public/ChunkStreamerComponent.h"
+#include "Public/RoomContentComponent.h"
 #include "TimerManager.h"
 #include "Engine.h"
 ////////////////////////////////////
 #include "Tools/Generator.h"
-#include "Tools/DelTraingle/vector2.h"
-#include "Tools/DelTraingle/triangle.h"
-#include "Tools/DelTraingle/delaunay.h"
 #include "Tools/MinSpTree/MinSpTree.h"
+#include "Tools/Core/MapGenerator.h"
+#include "Tools/Core/GraphMetrics.h"
+#include "Tools/Core/ProximityGraph.h"
+#include "Tools/Corridors/CorridorRouter.h"
+#include "Tools/Corridors/CorridorUnion.h"
+#include "Tools/Grid/MapRasterizer.h"
+#include "Tools/Core/MapStats.h"
+#include "Tools/Core/MapEventLog.h"
+#include "Tools/Core/MapHash.h"
+#include "Misc/Paths.h"
 #include "DrawDebugHelpers.h"
 
 //////////////////////////////////////////////////////////////////////////
@@ -53,6 +64,26 @@ AProceduralMapsCharacter::AProceduralMapsCharacter()
 	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
 	FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
 
+	// Debug overlay for the generation stages
+	m_DebugOverlay = CreateDefaultSubobject<UMapDebugOverlayComponent>(TEXT("DebugOverlay"));
+	m_DebugOverlay->SetupAttachment(RootComponent);
+
+	// Hallway geometry lives in world space, not attached to the character
+	m_HallwayMesh = CreateDefaultSubobject<UHallwayMeshComponent>(TEXT("HallwayMesh"));
+	m_HallwayMesh->SetupAttachment(RootComponent);
+	m_HallwayMesh->bAbsoluteLocation = true;
+	m_HallwayMesh->bAbsoluteRotation = true;
+	m_HallwayMesh->bAbsoluteScale = true;
+
+	m_ChunkStreamer = CreateDefaultSubobject<UChunkStreamerComponent>(TEXT("ChunkStreamer"));
+
+	// room content is in world space too
+	m_RoomContent = CreateDefaultSubobject<URoomContentComponent>(TEXT("RoomContent"));
+	m_RoomContent->SetupAttachment(RootComponent);
+	m_RoomContent->bAbsoluteLocation = true;
+	m_RoomContent->bAbsoluteRotation = true;
+	m_RoomContent->bAbsoluteScale = true;
+
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named MyCharacter (to avoid direct content references in C++)
 }
@@ -90,6 +121,21 @@ void AProceduralMapsCharacter::BeginPlay()
 {
 	Super::BeginPlay();
 
+	uint8 sinks = 0;
+	if (m_EventLogToFile)
+		sinks |= Helpers::MapEventLog::Sink_File;
+	if (m_EventLogToScreen)
+		sinks |= Helpers::MapEventLog::Sink_Screen;
+	if (sinks)
+		Helpers::MapEventLog::start(sinks, FPaths::Combine(FPaths::ProjectLogDir(), TEXT("MapEvents.log")));
+}
+
+void AProceduralMapsCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (m_EventLogToFile || m_EventLogToScreen)
+		Helpers::MapEventLog::stop();
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void AProceduralMapsCharacter::Tick(float deltaTime)
@@ -98,11 +144,23 @@ void AProceduralMapsCharacter::Tick(float deltaTime)
 	if(m_StartAlgo)
 		RunStates();
 
+	// events flushed since the last frame
+	if (m_EventLogToScreen && GEngine)
+	{
+		TArray<FString> lines;
+		Helpers::MapEventLog::drainScreen(lines);
+		for (const FString& line : lines)
+		{
+			GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::White, line);
+		}
+	}
 }
 
 // simple state machine
 void AProceduralMapsCharacter::RunStates()
 {
+	const Pro_States state = m_State;
+	MAP_EVENT(Verbose, StateEnter, (int64)state);
 	switch (m_State)
 	{
 	case Pro_States::SpawnRooms:	// 1
@@ -137,11 +195,13 @@ void AProceduralMapsCharacter::RunStates()
 		break;
 	}
 
+	// separation and distancing run once per tick until they are done
+	m_StatePasses = m_State == state ? m_StatePasses + 1 : 0;
 }
 
 void AProceduralMapsCharacter::RunSpawnRoom()
 {
-	UE_LOG(LogTemp, Warning, TEXT("Spawning.............."));
+	MAP_SCOPE(STAT_MapSpawn);
 	if (m_SpawningRoom)
 	{
 		for (int i = 0; i < m_TotalRoomsToSpawn; i++)
@@ -164,8 +224,11 @@ void AProceduralMapsCharacter::RunSpawnRoom()
 
 			rm->SetActorScale3D(scale);
 			rm->m_Scale = scaleX + scaleY;
+			// the id is the slot in m_Rooms too
+			rm->m_Id = m_RoomStore.add(FVector2D(loc), FVector2D(scaleX, scaleY) * 50.f, rm->m_Scale);
 			m_Rooms.Add(rm);
 		}
+		MAP_EVENT(Info, RoomsSpawned, m_Rooms.Num());
 	}
 	else // impoertant Error Logging
 	{
@@ -183,18 +246,22 @@ void AProceduralMapsCharacter::RunSpawnRoom()
 // sperate overlapping rooms
 void AProceduralMapsCharacter::RunSperateOverlappingRooms()
 {
-	UE_LOG(LogTemp, Warning, TEXT("Separating.............."));
-
+	MAP_SCOPE(STAT_MapSeparatePass);
 	// do until all are separated
 	bool flag = true;
+	int32 moved = 0;
 	
 	for (auto rm : m_Rooms)
 	{
 		if (!rm->SeparateOverlappingRooms())
 		{
 			flag = false;
+			moved++;
 		}
 	}
+	MAP_EVENT(Verbose, SeparatePass, m_StatePasses, moved);
+	if (flag)
+		MAP_EVENT(Info, Separated, m_StatePasses + 1, m_Rooms.Num());
 
 	if (flag) // chnage if all rooms are done separating
 		m_State = Pro_States::HighlightMainRooms;
@@ -204,33 +271,38 @@ void AProceduralMapsCharacter::RunSperateOverlappingRooms()
 // Highlight main rooms
 void AProceduralMapsCharacter::RunHighlightMainRooms()
 {
-	UE_LOG(LogTemp, Warning, TEXT("Highlighting.............."));
-
+	MAP_SCOPE(STAT_MapSelect);
 	for (auto rm : m_Rooms)
 	{
+		if (!rm)
+			continue;
 		if (rm->m_Scale > 14 && 1 == rand() % 4)
 		{
 			rm->Highlight();	// add
-			rm->m_IsMain = true;
+			m_RoomStore.setFlag(rm->m_Id, Helpers::Room_Main);
+			m_MainIds.push_back(rm->m_Id);
 			m_RoomsMain.Add(rm);
 		}
 		else
 		{
 			if (rand() % 5 > 0)
 			{
+				m_RoomStore.setFlag(rm->m_Id, Helpers::Room_Removed);
+				m_Rooms[rm->m_Id] = nullptr;
 				rm->Destroy();
 			}
 			else
 			{
 				rm->Highlight();	// add
-				rm->m_IsMain = true;
+				m_RoomStore.setFlag(rm->m_Id, Helpers::Room_Main);
+				m_MainIds.push_back(rm->m_Id);
 				m_RoomsMain.Add(rm);
 
 			}
 		}
 	}
 
-	UE_LOG(LogTemp, Warning, TEXT("Remaining Rooms: %d"), m_RoomsMain.Num());
+	MAP_EVENT(Info, MainRooms, m_RoomsMain.Num(), m_Rooms.Num());
 	// change state
 	m_State = Pro_States::DistantiateRooms;
 }
@@ -238,10 +310,10 @@ void AProceduralMapsCharacter::RunHighlightMainRooms()
 // Distantiate rooms with aprticular distance
 void AProceduralMapsCharacter::RunDistantiateRooms(float distacne)
 {
-	UE_LOG(LogTemp, Warning, TEXT("Distancing.............."));
-
+	MAP_SCOPE(STAT_MapDistancePass);
 	FVector selfLoc, thirdLoc;
 	bool flag = true;
+	int32 moved = 0;
 	//for each rooms if distance lees than given
 	for (auto rm : m_RoomsMain)
 	{
@@ -256,6 +328,7 @@ void AProceduralMapsCharacter::RunDistantiateRooms(float distacne)
 				if (FVector::Distance(selfLoc, thirdLoc) < distacne)
 				{
 					flag = false;
+					moved++;
 					// move rooms
 					FVector dir = selfLoc - thirdLoc;
 					dir.Normalize();
@@ -266,6 +339,7 @@ void AProceduralMapsCharacter::RunDistantiateRooms(float distacne)
 			}
 		}
 	}
+	MAP_EVENT(Verbose, DistancePass, m_StatePasses, moved);
 	
 	if (flag)
 		m_State = Pro_States::DrawDelTriangles;
@@ -274,51 +348,58 @@ void AProceduralMapsCharacter::RunDistantiateRooms(float distacne)
 // Draw Deuanay Triangles
 void AProceduralMapsCharacter::RunDrawDelTriangles()
 {
-	UE_LOG(LogTemp, Warning, TEXT("Draw Triangles.............."));
-	for (auto r : m_RoomsMain)
+	MAP_SCOPE(STAT_MapTriangulate);
+	SyncMainRooms();
+
+	// triangles come back in slots of m_MainIds
+	std::vector<Helpers::MapRoom> rooms;
+	m_RoomStore.gather(m_MainIds, rooms);
+	std::vector<std::array<int32, 3>> triangles;
+	Helpers::MapGenerator::triangulate(rooms, triangles, Helpers::MapMemory::heap(), m_TriangleSnap);
+
+	m_Triangles.clear();
+	for (const auto& t : triangles)
 	{
-		r->updateLocation();
+		m_Triangles.push_back({ m_MainIds[t[0]], m_MainIds[t[1]], m_MainIds[t[2]] });
 	}
-	dt::Delaunay<double> triangulation;
-	std::vector<dt::Vector2<double>> points;
+	MAP_EVENT(Info, Triangulated, (int64)m_Triangles.size(), m_RoomsMain.Num());
 
-	for (auto r : m_RoomsMain)
+	// regions around the rooms, out to a few hallway cells past the outer ones
+	std::vector<FVector2D> sites;
+	FBox2D bounds(ForceInit);
+	for (const Helpers::MapRoom& r : rooms)
 	{
-		dt::Vector2<double> tmp;
-		tmp.x = r->m_Loc.X;
-		tmp.y = r->m_Loc.Y;
-		points.push_back(tmp);
+		sites.push_back(r.center);
+		bounds += r.box();
 	}
+	m_Regions.build(sites, triangles, bounds.ExpandBy(m_HallwayCellSize * 4.f));
+	m_MainSlots.build(m_RoomStore, m_MainIds);
 
-	m_dTriangles = triangulation.triangulate(points);
-	UE_LOG(LogTemp, Warning, TEXT("Total Triangles: %d"), m_dTriangles.size());
-
-	// Draw triangles
-	dt::Vector2<double> m;
-	FVector2D a, b, c;
-	float z = 600.f;
-	for (auto t : m_dTriangles) // for each triangle
+	// Draw triangles, shared edges only once
+	std::vector<std::pair<FVector2D, FVector2D>> segments;
+	TSet<TPair<Helpers::RoomId, Helpers::RoomId>> drawn;
+	auto addEdge = [&](Helpers::RoomId u, Helpers::RoomId v)
 	{
-		// get all three rooms
-		m = *(t.a);
-		a = m.vec();
-		m = *(t.b);
-		b = m.vec();
-		m = *(t.c);
-		c = m.vec();
-
-		// draw line for each Edge
-		DrawDebugLine(GetWorld(), FVector(a, z), FVector(b, z), FColor::Black,false, 2.f, 0, 50);
-		DrawDebugLine(GetWorld(), FVector(a, z), FVector(c, z), FColor::Black,false, 2.f, 0, 50);
-		DrawDebugLine(GetWorld(), FVector(b, z), FVector(c, z), FColor::Black,false, 2.f, 0, 50);
-		//DrawCircle(GetWorld(), FVector(a, z), FVector(a, z), FVector(a, z), FColor::Red, 40, 2, true);
+		TPair<Helpers::RoomId, Helpers::RoomId> key = u < v ? MakeTuple(u, v) : MakeTuple(v, u);
+		if (!drawn.Contains(key))
+		{
+			drawn.Add(key);
+			segments.push_back({ m_RoomStore.center(u), m_RoomStore.center(v) });
+		}
+	};
+	for (const auto& t : m_Triangles) // for each triangle
+	{
+		addEdge(t[0], t[1]);
+		addEdge(t[0], t[2]);
+		addEdge(t[1], t[2]);
 	}
+	m_DebugOverlay->SetLayerSegments(EOverlayLayer::Triangles, segments, 600.f, FColor::Black, 50.f);
 
-	//ARoom* s = m_RoomLocMap[a];
+	//ARoom* s = m_Rooms[t[0]];
 	/*s->testMatChange();
-	s = m_RoomLocMap[b];
+	s = m_Rooms[t[1]];
 	s->testMatChange();
-	s = m_RoomLocMap[c];
+	s = m_Rooms[t[2]];
 	s->testMatChange();*/
 	//m_State = Pro_States::DrawMinSpanTree;
 	RunDrawMinSpTree();
@@ -327,87 +408,394 @@ void AProceduralMapsCharacter::RunDrawDelTriangles()
 // Generate and Draw Minimum Spanning Tree
 void AProceduralMapsCharacter::RunDrawMinSpTree()
 {
-	UE_LOG(LogTemp, Warning, TEXT("Draw Min Sp Tree.............."));
-
-	dt::Vector2<double> m;
-	FVector2D aa, bb, cc;
+	MAP_SCOPE(STAT_MapSpanningTree);
 	float z = 600.f;
-	// ********************* MST **************************
-	// create minimum spanning tree
-	MinSpTree Mst;
-	for (auto t : m_dTriangles) // for each triangle
-	{
-		// get all three loc and enter Three as apir
-		m = *(t.a);
-		aa = m.vec();
-		m = *(t.b);
-		bb = m.vec();
-		m = *(t.c);
-		cc = m.vec();
-		GEngine->AddOnScreenDebugMessage(-1, 50.f, FColor::Orange,
-			FString::Printf(TEXT("My Location is: %s"), *cc.ToString()));
-		Mst._costPairs.push_back({ FVector2D::Distance(aa, bb),
-			{aa,bb} });
-		Mst._costPairs.push_back({ FVector2D::Distance(aa, cc),
-			{aa,cc} });
-		Mst._costPairs.push_back({ FVector2D::Distance(bb, cc),
-			{bb,cc} });
+	if (m_GraphMode != EMapGraphMode::Spanning)
+	{
+		// straight from the triangles, in slots of m_MainIds
+		Helpers::MapParams params;
+		params.graphMode = (Helpers::MapGraphMode)m_GraphMode;
+		params.beta = m_GraphBeta;
+		params.stretch = m_GraphStretch;
+		std::vector<Helpers::MapRoom> rooms;
+		m_RoomStore.gather(m_MainIds, rooms);
+		std::vector<std::array<int32, 3>> triangles;
+		for (const auto& t : m_Triangles)
+		{
+			triangles.push_back({ m_MainSlots.slot(t[0]), m_MainSlots.slot(t[1]), m_MainSlots.slot(t[2]) });
+		}
+		std::vector<std::pair<int32, int32>> edges;
+		std::vector<uint8> isLoop;
+		Helpers::ProximityGraph::build(params, rooms, triangles, edges, isLoop);
+		m_MinPairs.clear();
+		for (const auto& e : edges)
+		{
+			m_MinPairs.push_back({ m_MainIds[e.first], m_MainIds[e.second] });
+		}
+		MAP_EVENT(Info, SpanningTree, (int64)m_Triangles.size() * 3, (int64)m_MinPairs.size());
 	}
-	
-	UE_LOG(LogTemp, Warning, TEXT("Total pairs in MST: %d"), Mst._costPairs.size());
+	else
+	{
+		// ********************* MST **************************
+		// create minimum spanning tree over room ids
+		MinSpTree Mst;
+		for (const auto& t : m_Triangles) // for each triangle
+		{
+			// enter all three sides as a pair
+			for (int32 k = 0; k < 3; k++)
+			{
+				const Helpers::RoomId a = t[k];
+				const Helpers::RoomId b = t[(k + 1) % 3];
+				Mst._costPairs.push_back({ FVector2D::Distance(m_RoomStore.center(a), m_RoomStore.center(b)),
+					{a,b} });
+			}
+		}
+		const int64 candidates = (int64)Mst._costPairs.size();
 
-	/*m_MinPairs = Mst.getMinCostPairs();
-	int mp = m_MinPairs.size();
-	UE_LOG(LogTemp, Warning, TEXT("After MST 
+		/*m_MinPairs = Mst.getMinCostPairs();
+		int mp = m_MinPairs.size();
+		UE_LOG(LogTemp, Warning, TEXT("After MST 
 	pairs : %d"), mp);
-	Mst.clear();*/
-	m_MinPairs = Mst.getNaturalCostPairs();
-	UE_LOG(LogTemp, Warning, TEXT("Extra ballancing MST pairs : %d"), m_MinPairs.size());
+		Mst.clear();*/
+		const auto pairs = Mst.getNaturalCostPairs();
+		m_MinPairs.assign(pairs.begin(), pairs.end());
+		MAP_EVENT(Info, SpanningTree, candidates, (int64)m_MinPairs.size());
+	}
 
-	for (auto p : m_MinPairs)
+	std::vector<std::pair<FVector2D, FVector2D>> segments;
+	for (const auto& p : m_MinPairs)
 	{
-		FVector2D a = p.first;
-		FVector2D b = p.second;
-		DrawDebugLine(GetWorld(), FVector(a, z + 300), FVector(b, z + 300), FColor::Green, false, 4.f, 0, 50);
+		segments.push_back({ m_RoomStore.center(p.first), m_RoomStore.center(p.second) });
 	}
+	m_DebugOverlay->SetLayerSegments(EOverlayLayer::MinSpTree, segments, z + 300, FColor::Green, 50.f);
 
+	RunPickRooms();
 	m_State = Pro_States::DrawHallWays;
 }
 
+void AProceduralMapsCharacter::RunPickRooms()
+{
+	// metrics run over slots of m_MainIds
+	Helpers::RoomSubset main;
+	main.build(m_RoomStore, m_MainIds);
+	std::vector<std::pair<int32, int32>> edges;
+	for (const auto& p : m_MinPairs)
+	{
+		edges.push_back({ main.slot(p.first), main.slot(p.second) });
+	}
+
+	Helpers::RoomGraphMetrics metrics;
+	Helpers::GraphMetrics::compute((int32)m_MainIds.size(), edges, Helpers::GraphMetrics::Options(), metrics);
+
+	m_StartRoom = metrics.start >= 0 ? m_MainIds[metrics.start] : INDEX_NONE;
+	m_BossRoom = metrics.boss >= 0 ? m_MainIds[metrics.boss] : INDEX_NONE;
+	m_TreasureRooms.Reset();
+	for (int32 t : metrics.treasures)
+	{
+		m_TreasureRooms.Add(m_MainIds[t]);
+	}
+}
+
 // Generate and Drwa hallways
 void AProceduralMapsCharacter::RunDrawHallways()
 {
-	UE_LOG(LogTemp, Warning, TEXT("Draw Hallways.............."));
+	MAP_SCOPE(STAT_MapHallways);
+	// room rectangles in world space, in slots of m_MainIds
+	Helpers::RoomSubset main;
+	main.build(m_RoomStore, m_MainIds);
+	std::vector<FBox2D> boxes;
+	for (Helpers::RoomId id : m_MainIds)
+	{
+		boxes.push_back(m_RoomStore.box(id));
+	}
 
-	for (auto p : m_MinPairs)
+	// rasterize rooms, with a margin so hallways can go around the outside
+	Helpers::GridFrame frame;
+	FIntPoint size = Helpers::MapRasterizer::computeFrame(boxes, m_HallwayCellSize, 4, frame);
+
+	std::vector<FIntRect> rects;
+	for (const auto& b : boxes)
 	{
-		FVector2D a = p.first;
-		FVector2D b = p.second;
+		rects.push_back(FIntRect(frame.toCell(b.Min), frame.toCell(b.Max)));
+	}
 
-		float xDiff = b.X - a.X;
-		float yDiff = a.Y - b.Y;
-		FVector HorizontalEnd(a.X + xDiff, a.Y, 300);
-		FVector VerticalEnd(b.X, b.Y + yDiff, 300);
+	std::vector<std::pair<int32, int32>> edges;
+	for (const auto& p : m_MinPairs)
+	{
+		edges.push_back({ main.slot(p.first), main.slot(p.second) });
+	}
 
-		DrawDebugLine(GetWorld(), FVector(a, 300), HorizontalEnd, FColor::Blue, true, -1.f, 0, 200);
-		DrawDebugLine(GetWorld(), FVector(b, 300), VerticalEnd, FColor::Blue, true, -1.f, 0, 200);
+	Helpers::CorridorRouter router;
+	router.setRooms(size.X, size.Y, rects);
+	std::vector<Helpers::CorridorRoute> routes = router.routeAll(edges);
+
+	m_Corridors.clear();
+	int32 failed = 0;
+	for (size_t i = 0; i < routes.size(); i++)
+	{
+		std::vector<FVector2D> line;
+		if (routes[i].ok)
+		{
+			for (const FIntPoint& c : routes[i].corners)
+			{
+				line.push_back(frame.toWorld(c));
+			}
+		}
+		else // fall back to the plain L shape
+		{
+			FVector2D a = m_RoomStore.center(m_MinPairs[i].first);
+			FVector2D b = m_RoomStore.center(m_MinPairs[i].second);
+			line = { a, FVector2D(b.X, a.Y), b };
+			failed++;
+		}
+		m_Corridors.push_back(line);
 	}
+	MAP_EVENT(Info, HallwaysRouted, (int32)routes.size() - failed, failed);
+
+	RefreshHallwayLayout();
 
+	// floors and walls, one hallway cell wide
+	std::vector<std::vector<FBox2D>> hallways;
+	for (const auto& line : m_Corridors)
+	{
+		hallways.push_back(Helpers::CorridorUnion::rects(line, m_HallwayCellSize));
+	}
+	m_HallwayMesh->BuildHallways(m_MapFrame, FIntPoint(m_MapGrid.width(), m_MapGrid.height()), boxes, hallways);
+
+	RunBuildFlowFields();
+	RunPopulateRooms();
 	m_State = Pro_States::None;
 }
 
+void AProceduralMapsCharacter::SetHallway(int32 index, const TArray<FVector>& points)
+{
+	if (index < 0 || index >= (int32)m_Corridors.size())
+	{
+		UE_LOG(LogTemp, Error, TEXT("SetHallway: there is no hallway %d"), index);
+		return;
+	}
+	std::vector<FVector2D> line;
+	for (const FVector& p : points)
+	{
+		line.push_back(FVector2D(p));
+	}
+	m_Corridors[index] = line;
+
+	// the mesh only redoes the chunks of this hallway, pieces and flow fields follow the new layout
+	m_HallwayMesh->RebuildHallway(index, Helpers::CorridorUnion::rects(line, m_HallwayCellSize));
+	RefreshHallwayLayout();
+	RunBuildFlowFields();
+}
+
+void AProceduralMapsCharacter::RefreshHallwayLayout()
+{
+	std::vector<FBox2D> boxes;
+	for (Helpers::RoomId id : m_MainIds)
+	{
+		boxes.push_back(m_RoomStore.box(id));
+	}
+
+	std::vector<std::pair<FVector2D, FVector2D>> segments;
+	for (const auto& line : m_Corridors)
+	{
+		for (size_t i = 1; i < line.size(); i++)
+		{
+			segments.push_back({ line[i - 1], line[i] });
+		}
+	}
+	m_DebugOverlay->SetLayerSegments(EOverlayLayer::Hallways, segments, 300.f, FColor::Blue, 200.f);
+
+	// one set of non-overlapping hallway pieces, cut out of the rooms
+	m_HallwayLayout = Helpers::CorridorUnion::build(m_Corridors, m_HallwayCellSize, boxes);
+	MAP_EVENT(Info, HallwayPieces, (int64)m_HallwayLayout.pieces.size(), (int64)m_HallwayLayout.junctions.size());
+
+	// cell level view of the final map
+	FIntPoint mapSize = Helpers::MapRasterizer::computeFrame(boxes, m_HallwayCellSize, 4, m_MapFrame);
+	m_MapGrid.init(mapSize.X, mapSize.Y);
+	Helpers::MapRasterizer::rasterizeRooms(m_MapGrid, m_MapFrame, boxes);
+	Helpers::MapRasterizer::rasterizeRooms(m_MapGrid, m_MapFrame, m_HallwayLayout.pieces);
+	MAP_EVENT(Info, MapGrid, m_MapGrid.width(), m_MapGrid.height(), (double)(m_MapGrid.memoryBytes() >> 10));
+
+	// rooms and hallway pieces for point queries
+	std::vector<FBox2D> areas = boxes;
+	areas.insert(areas.end(), m_HallwayLayout.pieces.begin(), m_HallwayLayout.pieces.end());
+	m_AreaIndex.build(areas);
+	MAP_EVENT(Info, AreaIndex, m_AreaIndex.num(), (int64)(m_AreaIndex.memoryBytes() >> 10));
+}
+
+void AProceduralMapsCharacter::RunPopulateRooms()
+{
+	std::vector<FBox2D> boxes;
+	std::vector<uint8> roles;
+	// the layout is rolled fresh every run, so its rooms are the seed
+	Helpers::MapHasher layout;
+	for (Helpers::RoomId id : m_MainIds)
+	{
+		boxes.push_back(m_RoomStore.box(id));
+		layout.add((int32)id);
+		layout.add(boxes.back().Min);
+		layout.add(boxes.back().Max);
+		uint8 role = Helpers::Content_Normal;
+		if (id == m_StartRoom)
+			role = Helpers::Content_Start;
+		else if (id == m_BossRoom)
+			role = Helpers::Content_Boss;
+		else if (m_TreasureRooms.Contains(id))
+			role = Helpers::Content_Treasure;
+		roles.push_back(role);
+	}
+	m_RoomContent->PopulateRooms(boxes, m_MainIds, roles, (int32)(layout.h ^ (layout.h >> 32)));
+}
+
+void AProceduralMapsCharacter::RunBuildFlowFields()
+{
+	MAP_SCOPE(STAT_MapFlowFields);
+	const double start = FPlatformTime::Seconds();
+
+	// every cell of a goal room is a target
+	auto addRoom = [&](std::vector<FIntPoint>& cells, int32 id)
+	{
+		if (!m_RoomStore.isValid(id))
+			return;
+		const FBox2D box = m_RoomStore.box(id);
+		const FIntPoint a = m_MapFrame.toCell(box.Min);
+		const FIntPoint b = m_MapFrame.toCell(box.Max);
+		for (int32 y = a.Y; y <= b.Y; y++)
+		{
+			for (int32 x = a.X; x <= b.X; x++)
+			{
+				cells.push_back(FIntPoint(x, y));
+			}
+		}
+	};
+	std::vector<std::vector<FIntPoint>> targets((int32)EMapGoal::Count);
+	addRoom(targets[(int32)EMapGoal::Start], m_StartRoom);
+	addRoom(targets[(int32)EMapGoal::Boss], m_BossRoom);
+	for (int32 id : m_TreasureRooms)
+	{
+		addRoom(targets[(int32)EMapGoal::Treasure], id);
+	}
+
+	Helpers::FlowField::buildAll(m_MapGrid, targets, m_FlowFields);
+	size_t bytes = 0;
+	for (const Helpers::FlowField& f : m_FlowFields)
+	{
+		bytes += f.memoryBytes();
+	}
+	MAP_EVENT(Info, FlowFields, (int64)m_FlowFields.size(), (int64)(bytes >> 10), (FPlatformTime::Seconds() - start) * 1000.0);
+}
+
+FVector AProceduralMapsCharacter::GetFlowStep(EMapGoal goal, FVector from) const
+{
+	if ((int32)goal >= (int32)m_FlowFields.size())
+		return from;
+	const FVector2D next = m_FlowFields[(int32)goal].nextWaypoint(m_MapFrame, FVector2D(from));
+	return FVector(next.X, next.Y, from.Z);
+}
+
+float AProceduralMapsCharacter::GetGoalDistance(EMapGoal goal, FVector from) const
+{
+	if ((int32)goal >= (int32)m_FlowFields.size())
+		return -1.f;
+	const FIntPoint c = m_MapFrame.toCell(FVector2D(from));
+	const float cells = m_FlowFields[(int32)goal].distance(c.X, c.Y);
+	return cells < 0.f ? -1.f : cells * m_MapFrame.cellSize;
+}
+
+int32 AProceduralMapsCharacter::FindAreaAt(FVector point, bool& bHallway) const
+{
+	const int32 item = m_AreaIndex.findAt(FVector2D(point));
+	bHallway = item >= (int32)m_MainIds.size();
+	if (item == INDEX_NONE)
+		return INDEX_NONE;
+	return bHallway ? item - (int32)m_MainIds.size() : m_MainIds[item];
+}
+
+void AProceduralMapsCharacter::FindAreasAt(const TArray<FVector>& points, TArray<int32>& areas) const
+{
+	std::vector<FVector2D> flat(points.Num());
+	for (int32 i = 0; i < points.Num(); i++)
+	{
+		flat[i] = FVector2D(points[i]);
+	}
+	areas.SetNumUninitialized(points.Num());
+	m_AreaIndex.findAtBatch(flat.data(), points.Num(), areas.GetData());
+
+	const int32 rooms = (int32)m_MainIds.size();
+	for (int32& a : areas)
+	{
+		if (a != INDEX_NONE)
+			a = a < rooms ? m_MainIds[a] : -2 - (a - rooms);
+	}
+}
+
+TArray<int32> AProceduralMapsCharacter::GetRoomsInBox(FVector min, FVector max) const
+{
+	std::vector<int32> items;
+	m_AreaIndex.queryBox(FBox2D(FVector2D(min), FVector2D(max)), items);
+	TArray<int32> ids;
+	for (int32 item : items)
+	{
+		if (item < (int32)m_MainIds.size())
+			ids.Add(m_MainIds[item]);
+	}
+	return ids;
+}
+
+TArray<int32> AProceduralMapsCharacter::GetRoomsInRadius(FVector center, float radius) const
+{
+	std::vector<int32> items;
+	m_AreaIndex.queryRadius(FVector2D(center), radius, items);
+	TArray<int32> ids;
+	for (int32 item : items)
+	{
+		if (item < (int32)m_MainIds.size())
+			ids.Add(m_MainIds[item]);
+	}
+	return ids;
+}
+
+int32 AProceduralMapsCharacter::GetRegionAt(FVector point) const
+{
+	const int32 cell = m_Regions.findCell(FVector2D(point));
+	return cell == INDEX_NONE ? INDEX_NONE : m_MainSlots.ids[cell];
+}
+
+TArray<int32> AProceduralMapsCharacter::GetRegionNeighbours(int32 room) const
+{
+	TArray<int32> ids;
+	const int32 cell = m_MainSlots.slot(room);
+	if (cell == INDEX_NONE || cell >= m_Regions.num())
+		return ids;
+	const Helpers::RoomGraph& graph = m_Regions.adjacency();
+	for (const int32* n = graph.begin(cell); n != graph.end(cell); ++n)
+	{
+		ids.Add(m_MainSlots.ids[*n]);
+	}
+	return ids;
+}
+
+bool AProceduralMapsCharacter::IsPointOnMap(FVector point) const
+{
+	FIntPoint c = m_MapFrame.toCell(FVector2D(point));
+	return m_MapGrid.get(c.X, c.Y);
+}
+
 // Timer End after moving rooms
 void AProceduralMapsCharacter::OnTimerEnd()
 {
 	// make sure rooms are done moving
 	RunHighlightMainRooms();
-	// Fill map
-	for (auto r : m_RoomsMain)
+	SyncMainRooms();
+}
+
+void AProceduralMapsCharacter::SyncMainRooms()
+{
+	for (Helpers::RoomId id : m_MainIds)
 	{
-		r->updateLocation();
-		m_RoomLocMap.Add(r->m_Loc, r);
+		if (ARoom* r = m_Rooms[id])
+			m_RoomStore.setCenter(id, FVector2D(r->GetActorLocation()));
 	}
-	FVector2D g;
 }
 
 void AProceduralMapsCharacter::OnResetVR()
@@ -5,14 +5,23 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
 ///////////////////////////////
-#include "Tools/DelTraingle/vector2.h"
 #include "vector"
+#include "array"
 #include "Tools/ProceduralState.h"
-#include "Tools/DelTraingle/triangle.h"
+#include "Tools/Core/RoomStore.h"
+#include "Tools/Grid/OccupancyGrid.h"
+#include "Tools/Grid/FlowField.h"
+#include "Tools/Core/MapSpatialIndex.h"
+#include "Tools/Core/MapVoronoi.h"
+#include "Tools/Corridors/CorridorUnion.h"
 
 #include "ProceduralMapsCharacter.generated.h"
 
 class ARoom;
+class UMapDebugOverlayComponent;
+class UHallwayMeshComponent;
+class UChunkStreamerComponent;
+class URoomContentComponent;
 
 UCLASS(config=Game)
 class AProceduralMapsCharacter : public ACharacter
@@ -72,6 +81,7 @@ protected:
 	// End of APawn interface
 	
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
 	/** Returns CameraBoom subobject **/
@@ -104,26 +114,100 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = Room)
 		bool m_StartAlgo = false;
 
+	// spawned rooms by room id, null once destroyed
 	UPROPERTY(VisibleAnywhere)
 	TArray<ARoom*> m_Rooms;
 	// main rooms
 	TArray<ARoom*> m_RoomsMain;
-	// pair with loc and and room for triangle
-	TMap<FVector2D, ARoom*> m_RoomLocMap;
-	// location pairs generated from MinimumSpanning Tree
-	std::vector<std::pair<FVector2D, FVector2D>> m_MinPairs;
+	// position, size and flags of every spawned room, by room id
+	Helpers::RoomStore m_RoomStore;
+	// ids of the main rooms, same order as m_RoomsMain
+	std::vector<Helpers::RoomId> m_MainIds;
+	// room id pairs generated from MinimumSpanning Tree
+	std::vector<std::pair<Helpers::RoomId, Helpers::RoomId>> m_MinPairs;
+
+	std::vector<std::array<Helpers::RoomId, 3>> m_Triangles;
+	// m_MainIds and back, rebuilt with the triangles
+	Helpers::RoomSubset m_MainSlots;
+	// Voronoi region of every main room, in slots of m_MainIds
+	Helpers::MapVoronoi m_Regions;
+
+	// picked from the room graph once the spanning tree is done
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Room)
+		int32 m_StartRoom = INDEX_NONE;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Room)
+		int32 m_BossRoom = INDEX_NONE;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Room)
+		TArray<int32> m_TreasureRooms;
+
+	// routed hallways as world space polylines, one per pair
+	std::vector<std::vector<FVector2D>> m_Corridors;
+	// merged hallway pieces and junctions
+	Helpers::CorridorLayout m_HallwayLayout;
+
+	// > 0 snaps room centres to this grid and triangulates them exactly
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = Room)
+		float m_TriangleSnap = 0.f;
+
+	// how the hallway pairs are picked from the triangles
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = Room)
+		EMapGraphMode m_GraphMode = EMapGraphMode::Spanning;
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = Room)
+		float m_GraphBeta = 1.5f;
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = Room)
+		float m_GraphStretch = 2.f;
 
-	std::vector<dt::Triangle<double>> m_dTriangles;
+	// size of a grid cell used for routing hallways
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = Room)
+		float m_HallwayCellSize = 100.f;
+
+	// rooms and hallways rasterized once the map is done
+	Helpers::OccupancyGrid m_MapGrid;
+	Helpers::GridFrame m_MapFrame;
+	// next step toward each EMapGoal from every cell of m_MapGrid
+	std::vector<Helpers::FlowField> m_FlowFields;
+	// main room boxes in m_MainIds order, then the hallway pieces
+	Helpers::MapSpatialIndex m_AreaIndex;
 
 	UPROPERTY(EditAnywhere)
 	TSubclassOf<class ARoom> m_SpawningRoom;
 
+	// batched debug lines for triangles, mst and hallways
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Room)
+		UMapDebugOverlayComponent* m_DebugOverlay;
+
+	// floors and walls of the routed hallways
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Room)
+		UHallwayMeshComponent* m_HallwayMesh;
+
+	// endless chunked map around the character, off by default
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Room)
+		UChunkStreamerComponent* m_ChunkStreamer;
+
+	// props, enemies and pickups of the main rooms
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Room)
+		URoomContentComponent* m_RoomContent;
+
+	// generation events to Saved/Logs/MapEvents.log and/or the screen
+	UPROPERTY(EditAnywhere, Category = Debug)
+		bool m_EventLogToFile = false;
+	UPROPERTY(EditAnywhere, Category = Debug)
+		bool m_EventLogToScreen = false;
+
+	// ticks spent in the current state
+	int32 m_StatePasses = 0;
+
 
 	UFUNCTION()
 		void OnTimerEnd();
 
 	void RunStates();
 
+	// copies actor positions of the main rooms into m_RoomStore
+	void SyncMainRooms();
+	// hallway pieces, map grid and area index from m_Corridors
+	void RefreshHallwayLayout();
+
 	// State func
 	UFUNCTION(BlueprintCallable)
 		void RunSpawnRoom(); // spawn rooms
@@ -146,5 +230,56 @@ public:
 	UFUNCTION(BlueprintCallable) // select main rooms
 		void RunDrawHallways();
 
+	// new path for one routed hallway after the map is edited, only its part of the mesh is rebuilt
+	UFUNCTION(BlueprintCallable)
+		void SetHallway(int32 index, const TArray<FVector>& points);
+
+	// start, boss and treasure rooms from the graph metrics
+	UFUNCTION(BlueprintCallable)
+		void RunPickRooms();
+
+	// flow fields toward the picked rooms over m_MapGrid
+	UFUNCTION(BlueprintCallable)
+		void RunBuildFlowFields();
+
+	// fills the main rooms through m_RoomContent, by their role
+	UFUNCTION(BlueprintCallable)
+		void RunPopulateRooms();
+
+	// where to walk next from 'from' toward the goal, 'from' itself when there or without a path
+	UFUNCTION(BlueprintCallable)
+		FVector GetFlowStep(EMapGoal goal, FVector from) const;
+
+	// path length to the goal in world units, -1 without a path
+	UFUNCTION(BlueprintCallable)
+		float GetGoalDistance(EMapGoal goal, FVector from) const;
+
+	// room id under the point, or the hallway piece when bHallway. INDEX_NONE off the map
+	UFUNCTION(BlueprintCallable)
+		int32 FindAreaAt(FVector point, bool& bHallway) const;
+
+	// FindAreaAt for many agents at once. Rooms give their id, hallway
+	// piece n gives -2 - n, off the map gives INDEX_NONE
+	UFUNCTION(BlueprintCallable)
+		void FindAreasAt(const TArray<FVector>& points, TArray<int32>& areas) const;
+
+	// ids of the rooms overlapping the box / within 'radius' of the centre
+	UFUNCTION(BlueprintCallable)
+		TArray<int32> GetRoomsInBox(FVector min, FVector max) const;
+	UFUNCTION(BlueprintCallable)
+		TArray<int32> GetRoomsInRadius(FVector center, float radius) const;
+
+	// id of the main room whose region holds the point, INDEX_NONE off the map
+	UFUNCTION(BlueprintCallable)
+		int32 GetRegionAt(FVector point) const;
+
+	// ids of the rooms whose regions share a side with the room's region
+	UFUNCTION(BlueprintCallable)
+		TArray<int32> GetRegionNeighbours(int32 room) const;
+
+	// true if the point is inside a room or hallway of the finished map
+	UFUNCTION(BlueprintCallable)
+		bool IsPointOnMap(FVector point) const;
+
 };
 
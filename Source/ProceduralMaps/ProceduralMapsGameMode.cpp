@@ -2,6 +2,7 @@
 
 #include "ProceduralMapsGameMode.h"
 #include "ProceduralMapsCharacter.h"
+#include "ProceduralMapsGameState.h"
 #include "UObject/ConstructorHelpers.h"
 
 AProceduralMapsGameMode::AProceduralMapsGameMode()
@@ -12,4 +13,6 @@ AProceduralMapsGameMode::AProceduralMapsGameMode()
 	{
 		DefaultPawnClass = PlayerPawnBPClass.Class;
 	}
+	// seed only map sync, see AProceduralMapsGameState
+	GameStateClass = AProceduralMapsGameState::StaticClass();
 }
@@ -0,0 +1,156 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ProceduralMapsGameState.h"
+#include "Public/Room.h"
+#include "Net/UnrealNetwork.h"
+#include "Engine/World.h"
+#include "HAL/PlatformTime.h"
+#include "Tools/Core/MapEventLog.h"
+
+Helpers::MapParams FMapSeedParams::toParams() const
+{
+	Helpers::MapParams p;
+	p.seed = seed;
+	p.totalRooms = totalRooms;
+	p.roomRange = roomRange;
+	p.spawnRadius = spawnRadius;
+	p.spacing = spacing;
+	p.loopChance = loopChance;
+	p.cellSize = cellSize;
+	p.routeHallways = routeHallways;
+	p.roomsPerCluster = roomsPerCluster;
+	// the double triangulation can flip near degenerate cases between compilers
+	p.snapSize = snapSize > 0.f ? snapSize : 1.f;
+	p.graphMode = (Helpers::MapGraphMode)graphMode;
+	p.beta = beta;
+	p.stretch = stretch;
+	return p;
+}
+
+Helpers::MapFitnessWeights FMapFitness::toWeights() const
+{
+	Helpers::MapFitnessWeights w;
+	w.diameter = diameter;
+	w.loops = loops;
+	w.deadEnds = deadEnds;
+	w.coverage = coverage;
+	return w;
+}
+
+void AProceduralMapsGameState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	DOREPLIFETIME(AProceduralMapsGameState, m_SeedMap);
+}
+
+void AProceduralMapsGameState::StartSeedMap(const FMapSeedParams& params)
+{
+	if (!HasAuthority())
+		return;
+
+	sendMap(params);
+	// the server's layout is the reference clients check against
+	m_SeedMap.layoutHash = (int64)buildMap();
+	acceptMap(true);
+}
+
+void AProceduralMapsGameState::StartBestSeedMap(const FMapSeedParams& params, const FMapFitness& fitness, int32 candidates, float stopScore)
+{
+	if (!HasAuthority())
+		return;
+
+	Helpers::MapSelector::Options options;
+	options.candidates = candidates;
+	options.stopScore = stopScore;
+	const Helpers::MapCandidate best = Helpers::MapSelector::select(params.toParams(), options, fitness.toWeights(), m_Map);
+	UE_LOG(LogTemp, Display, TEXT("Seed map %d scored best of %d candidates from %d (%.3f)"), best.seed, candidates, params.seed, best.score);
+
+	// clients only ever see the winning seed
+	FMapSeedParams chosen = params;
+	chosen.seed = best.seed;
+	sendMap(chosen);
+	m_SeedMap.layoutHash = (int64)buildMap(false);
+	acceptMap(true);
+}
+
+void AProceduralMapsGameState::sendMap(const FMapSeedParams& params)
+{
+	const int32 generation = m_SeedMap.generation + 1;
+	m_SeedMap = params;
+	m_SeedMap.generation = generation;
+}
+
+void AProceduralMapsGameState::OnRep_SeedMap()
+{
+	const uint64 hash = buildMap();
+	const bool matches = hash == (uint64)m_SeedMap.layoutHash;
+	if (!matches)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Seed map %d built a different layout than the server (%llx, server %llx), dropping it"),
+			m_SeedMap.seed, hash, (uint64)m_SeedMap.layoutHash);
+	}
+	acceptMap(matches);
+}
+
+uint64 AProceduralMapsGameState::buildMap(bool generate)
+{
+	const double start = FPlatformTime::Seconds();
+	if (generate)
+		Helpers::MapGenerator::generate(m_SeedMap.toParams(), m_Map);
+	const uint64 hash = Helpers::MapGenerator::layoutHash(m_Map);
+	MAP_EVENT(Info, SeedMap, m_SeedMap.seed, (HasAuthority() || hash == (uint64)m_SeedMap.layoutHash) ? 1 : 0,
+		(FPlatformTime::Seconds() - start) * 1000.0);
+	return hash;
+}
+
+void AProceduralMapsGameState::acceptMap(bool matches)
+{
+	// a client with another layout would play a different map than the
+	// server thinks it does, so it gets none at all
+	clearRooms();
+	m_LayoutMatches = matches;
+	m_Built = matches;
+	if (!matches)
+	{
+		m_Map = Helpers::GeneratedMap();
+		OnSeedMapBuilt.Broadcast(false);
+		return;
+	}
+
+	if (m_RoomClass && GetWorld())
+	{
+		for (int32 i = 0; i < (int32)m_Map.rooms.size(); i++)
+		{
+			const Helpers::MapRoom& room = m_Map.rooms[i];
+			FActorSpawnParameters tParams;
+			tParams.Owner = this;
+			const FVector loc(room.center.X, room.center.Y, 226.f);
+			ARoom* rm = GetWorld()->SpawnActor<ARoom>(m_RoomClass, loc, FRotator::ZeroRotator, tParams);
+			if (!rm)
+				continue;
+			// every machine spawns its own
+			rm->SetReplicates(false);
+			rm->SetActorScale3D(FVector(room.extent.X / 50.f, room.extent.Y / 50.f, 6.f));
+			rm->m_Scale = room.scale;
+			rm->m_Id = i;
+			m_RoomActors.Add(rm);
+		}
+	}
+	OnSeedMapBuilt.Broadcast(true);
+}
+
+void AProceduralMapsGameState::clearRooms()
+{
+	for (AActor* actor : m_RoomActors)
+	{
+		if (actor)
+			actor->Destroy();
+	}
+	m_RoomActors.Reset();
+}
+
+void AProceduralMapsGameState::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	clearRooms();
+	Super::EndPlay(EndPlayReason);
+}
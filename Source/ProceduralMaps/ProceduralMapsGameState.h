@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/GameStateBase.h"
+#include "Tools/Core/MapGenerator.h"
+#include "Tools/Core/MapSelector.h"
+#include "Tools/ProceduralState.h"
+
+#include "ProceduralMapsGameState.generated.h"
+
+class ARoom;
+
+// everything a client needs to rebuild the server's map, mirrors Helpers::MapParams
+USTRUCT(BlueprintType)
+struct FMapSeedParams
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SeedMap")
+		int32 seed = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SeedMap")
+		int32 totalRooms = 150;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SeedMap")
+		int32 roomRange = 10;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SeedMap")
+		float spawnRadius = 500.f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SeedMap")
+		float spacing = 1000.f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SeedMap")
+		float loopChance = 1.f / 9.f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SeedMap")
+		float cellSize = 100.f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SeedMap")
+		bool routeHallways = true;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SeedMap")
+		int32 roomsPerCluster = 0;
+	// always > 0 for seed maps, the exact integer triangulation is the same on every machine
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SeedMap", meta = (ClampMin = "0.01"))
+		float snapSize = 1.f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SeedMap")
+		EMapGraphMode graphMode = EMapGraphMode::Spanning;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SeedMap")
+		float beta = 1.5f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SeedMap")
+		float stretch = 2.f;
+
+	// filled in by the server, Helpers::MapGenerator::layoutHash of its map
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "SeedMap")
+		int64 layoutHash = 0;
+	// bumped for every map so the same params twice still replicate
+	UPROPERTY()
+		int32 generation = 0;
+
+	Helpers::MapParams toParams() const;
+};
+
+// weights of the score StartBestSeedMap ranks candidates by, mirrors Helpers::MapFitnessWeights
+USTRUCT(BlueprintType)
+struct FMapFitness
+{
+	GENERATED_BODY()
+
+	// diameter over rooms, below 0 keeps long thin maps out
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SeedMap")
+		float diameter = -1.f;
+	// loop edges over rooms
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SeedMap")
+		float loops = 1.f;
+	// dead ends over rooms
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SeedMap")
+		float deadEnds = -0.5f;
+	// room area over the area of their bounds
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SeedMap")
+		float coverage = 1.f;
+
+	Helpers::MapFitnessWeights toWeights() const;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnSeedMapBuilt, bool, bLayoutMatches);
+
+// Seed only map sync. The server generates the map with the data only
+// generator and replicates just the params and a hash of the layout, a few
+// dozen bytes instead of an actor per room. Every machine, the listen server
+// included, regenerates the same layout and spawns its own non replicated
+// room actors from it. Clients compare their hash with the server's and
+// drop a map that does not match instead of playing on a different layout.
+UCLASS()
+class PROCEDURALMAPS_API AProceduralMapsGameState : public AGameStateBase
+{
+	GENERATED_BODY()
+
+public:
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// spawned locally for every room of the map when set
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SeedMap")
+		TSubclassOf<ARoom> m_RoomClass;
+
+	// fired on every machine once its copy of the map is built, false when a
+	// client's layout did not match the server's and it has no map
+	UPROPERTY(BlueprintAssignable, Category = "SeedMap")
+		FOnSeedMapBuilt OnSeedMapBuilt;
+
+	//**********************************************************
+	// Functions
+	// server only, generates the map and sends the params to every client
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly)
+		void StartSeedMap(const FMapSeedParams& params);
+
+	// server only, scores 'candidates' seeds from params.seed on and sends the best one.
+	// Stops starting new seeds once one scores 'stopScore' or more
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly)
+		void StartBestSeedMap(const FMapSeedParams& params, const FMapFitness& fitness, int32 candidates = 16, float stopScore = 1.f);
+
+	// false on a client whose layout did not match the server's
+	UFUNCTION(BlueprintCallable)
+		bool IsSeedMapBuilt() const { return m_Built; }
+
+	// false when this machine built a different layout than the server
+	UFUNCTION(BlueprintCallable)
+		bool DoesLayoutMatch() const { return m_LayoutMatches; }
+
+	const Helpers::GeneratedMap& GetSeedMap() const { return m_Map; }
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	UPROPERTY(ReplicatedUsing = OnRep_SeedMap, VisibleAnywhere, BlueprintReadOnly, Category = "SeedMap")
+		FMapSeedParams m_SeedMap;
+
+	UFUNCTION()
+		void OnRep_SeedMap();
+
+private:
+	// regenerates m_Map from m_SeedMap unless it is already there, returns the local hash
+	uint64 buildMap(bool generate = true);
+	// spawns the room actors of m_Map when its layout matched, drops it otherwise
+	void acceptMap(bool matches);
+	void sendMap(const FMapSeedParams& params);
+	void clearRooms();
+
+	Helpers::GeneratedMap m_Map;
+	bool m_Built = false;
+	bool m_LayoutMatches = false;
+
+	UPROPERTY(Transient)
+		TArray<AActor*> m_RoomActors;
+};
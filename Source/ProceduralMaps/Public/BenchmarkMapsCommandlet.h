@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "BenchmarkMapsCommandlet.generated.h"
+
+// Scaling benchmark of every generation stage, see Helpers::MapBenchmark.
+//
+// UE4Editor-Cmd ProceduralMaps.uproject -run=BenchmarkMaps -out=Saved/Bench -baseline=Bench/baseline.csv
+// (Engine/Binaries/Linux/UE4Editor-Cmd on Linux, no window or GPU needed)
+//   -sizes=10,100,1000      room counts, 10 to 1000000 by default
+//   -maxrooms=100000        drop bigger sizes
+//   -layouts=uniform,ring   uniform, clustered, ring, all by default
+//   -repeat=3 -budget=30    repeats under a second, seconds per stage and size
+//   -threads=16             throughput runs for 1, 2, 4 .. 16 workers, all cores by default
+//   -threadrooms=150 -threadmaps=64
+//   -baseline=path          compare with a baseline, returns 1 on a regression
+//   -threshold=1.25         slow down allowed where the baseline has no threshold
+//   -savebaseline           write this run to the -baseline path instead
+//
+// Results go to bench.csv and the fitted complexity of every stage to fits.txt.
+UCLASS()
+class PROCEDURALMAPS_API UBenchmarkMapsCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UBenchmarkMapsCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+///////////////////////////////
+#include "Tools/Core/ChunkGenerator.h"
+#include "Async/Future.h"
+
+#include "ChunkStreamerComponent.generated.h"
+
+class ARoom;
+class ULineBatchComponent;
+
+// Keeps the chunks around the owner loaded. Chunks are generated on the
+// thread pool and only handed to the game thread when done. Chunks further
+// than the load radius plus one are dropped with their actors, so only a
+// fixed square of chunks is ever alive no matter how far the owner walks.
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class PROCEDURALMAPS_API UChunkStreamerComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UChunkStreamerComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (DisplayName = "Enabled"))
+		bool m_Enabled = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (DisplayName = "Seed"))
+		int32 m_Seed = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (DisplayName = "ChunkSize"))
+		float m_ChunkSize = 8000.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (DisplayName = "RoomsPerChunk"))
+		int32 m_RoomsPerChunk = 9;
+
+	// chunks loaded in each direction around the owner's chunk
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (DisplayName = "LoadRadius"))
+		int32 m_LoadRadius = 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (DisplayName = "MaxTasksInFlight"))
+		int32 m_MaxTasks = 4;
+
+	// spawned for every non portal room when set
+	UPROPERTY(EditAnywhere, Category = "Streaming")
+		TSubclassOf<ARoom> m_RoomClass;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Streaming", meta = (DisplayName = "DrawChunks"))
+		bool m_DrawChunks = true;
+
+	//**********************************************************
+	// Functions
+	UFUNCTION(BlueprintCallable)
+		void UnloadAll();
+
+	UFUNCTION(BlueprintCallable)
+		int32 GetLoadedChunkCount() const { return m_Loaded.Num(); }
+
+	const Helpers::MapChunk* FindChunk(FIntPoint coord) const;
+
+protected:
+	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
+
+private:
+	struct LoadedChunk
+	{
+		TSharedPtr<Helpers::MapChunk> data;
+		TArray<AActor*> actors;	// by room index, null for portals
+	};
+
+	Helpers::ChunkParams params() const;
+	void requestChunks(FIntPoint center);
+	void collectFinished(FIntPoint center);
+	void unloadFar(FIntPoint center);
+	void onChunkLoaded(FIntPoint coord, LoadedChunk& chunk);
+	void unloadChunk(LoadedChunk& chunk);
+	void redrawLines();
+	bool inRadius(FIntPoint coord, FIntPoint center, int32 radius) const;
+
+	TMap<FIntPoint, LoadedChunk> m_Loaded;
+	TMap<FIntPoint, TFuture<TSharedPtr<Helpers::MapChunk>>> m_Pending;
+
+	UPROPERTY(Transient)
+		ULineBatchComponent* m_Lines = nullptr;
+
+	bool m_LinesDirty = false;
+};
@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "GenerateMapsCommandlet.generated.h"
+
+// Generates and checks maps for a range of seeds without a level.
+//
+// UE4Editor-Cmd ProceduralMaps.uproject -run=GenerateMaps -seeds=0-9999 -out=Saved/Maps
+//   -shard=0/4      only seeds where (seed - first) % 4 == 0, one process per shard
+//   -threads=8      worker threads, all cores by default
+//   -rooms= -range= -radius= -spacing= -loops= -cell=   MapParams, defaults otherwise
+//   -cluster=256    rooms per district for the two level graph, flat graph when 0
+//   -snap=10        exact integer triangulation on a grid this size, see MapGenerator::triangulate
+//   -graph=rng      hallway graph: mst (default), gabriel, rng, beta or spanner, see ProximityGraph
+//   -beta=1.5 -stretch=2   lune size for -graph=beta, max detour for -graph=spanner
+//   -nohallways     skip hallway routing
+//   -write          also write every map as a map file
+//   -stream         write every map as a stream file, each stage as soon as it is done
+//   -resume         continue after the last finished batch of an earlier run
+//   -events         generation events to events_<shard>.log, see Helpers::MapEventLog
+//   -roles          start, boss and treasure rooms of every map to roles_<shard>.csv, not with -stream
+//
+// Per seed stage timings go to timings_<shard>.csv, the next seed to do goes
+// to progress_<shard>.txt after every batch, per stage totals of this run go to
+// summary_<shard>.txt and the log. Returns 1 if any map was invalid or an
+// argument was not understood.
+UCLASS()
+class PROCEDURALMAPS_API UGenerateMapsCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UGenerateMapsCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProceduralMeshComponent.h"
+///////////////////////////////
+#include "Tools/Hallways/HallwayMeshBuilder.h"
+#include "Async/Future.h"
+#include <vector>
+
+#include "HallwayMeshComponent.generated.h"
+
+class UMaterialInterface;
+
+// Hallway floors and walls as a handful of large mesh sections, one per grid
+// chunk. Geometry is built on the thread pool and the sections are handed to
+// the mesh a few per frame, so big maps and edits do not hitch.
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class PROCEDURALMAPS_API UHallwayMeshComponent : public UProceduralMeshComponent
+{
+	GENERATED_BODY()
+
+public:
+	UHallwayMeshComponent(const FObjectInitializer& ObjectInitializer);
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hallways", meta = (DisplayName = "WallHeight"))
+		float m_WallHeight = 300.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hallways", meta = (DisplayName = "FloorZ"))
+		float m_FloorZ = 0.f;
+
+	// sections handed to the mesh per frame
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hallways", meta = (DisplayName = "SectionsPerFrame"))
+		int32 m_SectionsPerFrame = 4;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hallways", meta = (DisplayName = "CreateCollision"))
+		bool m_CreateCollision = true;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hallways", meta = (DisplayName = "Material"))
+		UMaterialInterface* m_Material = nullptr;
+
+	//**********************************************************
+	// Functions
+
+	// full rebuild, one list of CorridorUnion::rects per hallway, frame cell size is the hallway width
+	void BuildHallways(const Helpers::GridFrame& frame, FIntPoint gridSize, const std::vector<FBox2D>& rooms,
+		const std::vector<std::vector<FBox2D>>& hallways);
+
+	// rebuild only the chunks one hallway touches
+	void RebuildHallway(int32 index, const std::vector<FBox2D>& rects);
+
+	UFUNCTION(BlueprintCallable)
+		bool IsBuilding() const;
+
+protected:
+	virtual void OnUnregister() override;
+
+private:
+	void startBuild();
+
+	Helpers::HallwayMeshBuilder m_Builder;
+	TMap<FIntPoint, int32> m_SectionOfChunk;
+	TArray<int32> m_FreeSections;
+
+	// finished sections waiting to be applied
+	TArray<Helpers::HallwaySection> m_Ready;
+	TFuture<TArray<Helpers::HallwaySection>> m_Task;
+	bool m_Building = false;
+
+	// edits that came in while a build was running
+	TArray<TPair<int32, std::vector<FBox2D>>> m_PendingEdits;
+};
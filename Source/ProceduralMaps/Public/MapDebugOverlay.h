@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+///////////////////////////////
+#include <vector>
+#include <utility>
+
+#include "MapDebugOverlay.generated.h"
+
+class ULineBatchComponent;
+
+// debug layers drawn while generating the map
+UENUM(BlueprintType)
+enum class EOverlayLayer : uint8
+{
+	Triangles = 0  UMETA(DisplayName = "Delaunay Triangles"),
+	MinSpTree = 1  UMETA(DisplayName = "Minimum Spanning Tree"),
+	Hallways = 2  UMETA(DisplayName = "Hallways"),
+	Count = 3  UMETA(Hidden)
+};
+
+// Keeps one line batch per layer. Segments are uploaded once when the data
+// changes and persist until the layer is replaced or cleared, so drawing the
+// overlay costs nothing per frame beyond rendering the batches.
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class PROCEDURALMAPS_API UMapDebugOverlayComponent : public USceneComponent
+{
+	GENERATED_BODY()
+
+public:
+	UMapDebugOverlayComponent();
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Overlay", meta = (DisplayName = "ShowTriangles"))
+		bool m_ShowTriangles = true;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Overlay", meta = (DisplayName = "ShowMinSpTree"))
+		bool m_ShowMinSpTree = true;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Overlay", meta = (DisplayName = "ShowHallways"))
+		bool m_ShowHallways = true;
+
+	//**********************************************************
+	// Functions
+	UFUNCTION(BlueprintCallable)
+		void SetLayerVisible(EOverlayLayer layer, bool state);
+
+	UFUNCTION(BlueprintCallable)
+		void ClearLayer(EOverlayLayer layer);
+
+	UFUNCTION(BlueprintCallable)
+		void ClearAll();
+
+	// replace all segments of a layer, drawn at height z
+	void SetLayerSegments(EOverlayLayer layer, const std::vector<std::pair<FVector2D, FVector2D>>& segments,
+		float z, FColor color, float thickness);
+
+	int32 GetLayerLineCount(EOverlayLayer layer) const;
+
+protected:
+	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+private:
+	bool& layerFlag(EOverlayLayer layer);
+	void applyVisibility();
+
+	// one batch per layer, indexed by EOverlayLayer
+	UPROPERTY(Transient)
+		TArray<ULineBatchComponent*> m_Batches;
+
+	int32 m_LineCounts[(int32)EOverlayLayer::Count];
+};
@@ -54,11 +54,9 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "System", meta = (DisplayName = "ScaleOfRoom"))
 		int m_Scale = 0;
 
-	// Is Main Room
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "System", meta = (DisplayName = "IsMain"))
-		int m_IsMain = false;
-
-	FVector2D m_Loc;
+	// slot in the owner's RoomStore, position and flags such as main live there
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "System", meta = (DisplayName = "RoomId"))
+		int32 m_Id = INDEX_NONE;
 
 	//**********************************************************
 	// Functions
@@ -73,7 +71,6 @@ public:
 
 	void Highlight();
 	void testMatChange();
-	void updateLocation();
 
 //		void OnComponentBeginOverlap(UPrimitiveComponent* OverlappedComponent,AActor* OtherActor,UPrimitiveComponent* OtherComp,
 	//		int OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+///////////////////////////////
+#include "Tools/Core/RoomContent.h"
+#include "Async/Future.h"
+#include <vector>
+
+#include "RoomContentComponent.generated.h"
+
+class UStaticMesh;
+class UHierarchicalInstancedStaticMeshComponent;
+
+// one kind of prop, enemy or pickup, mirrors Helpers::ContentRule
+USTRUCT(BlueprintType)
+struct FRoomContentRule
+{
+	GENERATED_BODY()
+
+	// drawn as instances of this mesh, one instanced mesh component per rule
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Content")
+		UStaticMesh* mesh = nullptr;
+	// spawned as real actors instead when set, a few per frame. For things that move or think
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Content")
+		TSubclassOf<AActor> actorClass;
+
+	// items per 100x100 of floor
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Content")
+		float density = 0.1f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Content")
+		int32 minCount = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Content")
+		int32 maxCount = 8;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Content")
+		float margin = 50.f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Content")
+		float spacing = 100.f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Content")
+		float minScale = 1.f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Content")
+		float maxScale = 1.f;
+
+	// which rooms get it
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Content")
+		bool bNormalRooms = true;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Content")
+		bool bStartRoom = true;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Content")
+		bool bBossRoom = true;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Content")
+		bool bTreasureRooms = true;
+
+	Helpers::ContentRule toRule() const;
+};
+
+// Props, enemies and pickups of the main rooms. What goes where is decided
+// on the thread pool, every room from its own sub seed. Mesh rules end up as
+// one hierarchical instanced mesh each, added in one go. Actor rules go to
+// a queue that is spawned from under a time budget every frame, so a big
+// map never spawns all its actors in one frame.
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class PROCEDURALMAPS_API URoomContentComponent : public USceneComponent
+{
+	GENERATED_BODY()
+
+public:
+	URoomContentComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Content", meta = (DisplayName = "Rules"))
+		TArray<FRoomContentRule> m_Rules;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Content", meta = (DisplayName = "FloorZ"))
+		float m_FloorZ = 0.f;
+
+	// milliseconds of actor spawning per frame, at least one actor always goes
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Content", meta = (DisplayName = "SpawnBudgetMs"))
+		float m_SpawnBudgetMs = 2.f;
+
+	//**********************************************************
+	// Functions
+
+	// replaces all content, 'ids' and 'roles' (Helpers::ContentRoomRole bits) line up with 'rooms'.
+	// 'seed' should come from the map, the same map and seed always get the same content
+	void PopulateRooms(const std::vector<FBox2D>& rooms, const std::vector<int32>& ids, const std::vector<uint8>& roles, int32 seed);
+
+	UFUNCTION(BlueprintCallable)
+		void ClearContent();
+
+	// still deciding or spawning
+	UFUNCTION(BlueprintCallable)
+		bool IsPopulating() const { return m_Building || m_SpawnNext < m_SpawnQueue.Num(); }
+
+	UFUNCTION(BlueprintCallable)
+		int32 GetPendingActorCount() const { return m_SpawnQueue.Num() - m_SpawnNext; }
+
+protected:
+	virtual void OnUnregister() override;
+
+private:
+	struct PendingSpawn
+	{
+		int32 rule;
+		FTransform transform;
+	};
+
+	void applyContent(const Helpers::RoomContent& content);
+	void drainSpawnQueue();
+
+	TFuture<Helpers::RoomContent> m_Task;
+	bool m_Building = false;
+	double m_StartTime = 0.0;
+	// copied when the task started, m_Rules may change while it runs
+	UPROPERTY(Transient)
+		TArray<FRoomContentRule> m_BuildRules;
+
+	// drained in order from m_SpawnNext, emptied once all are out
+	TArray<PendingSpawn> m_SpawnQueue;
+	int32 m_SpawnNext = 0;
+
+	UPROPERTY(Transient)
+		TArray<UHierarchicalInstancedStaticMeshComponent*> m_Instances;
+	UPROPERTY(Transient)
+		TArray<AActor*> m_Actors;
+};
@@ -0,0 +1,110 @@
+#include "ChunkGenerator.h"
+
+namespace Helpers {
+
+	namespace {
+		inline uint32 mix(uint32 h)
+		{
+			// murmur3 finalizer
+			h ^= h >> 16;
+			h *= 0x85ebca6b;
+			h ^= h >> 13;
+			h *= 0xc2b2ae35;
+			h ^= h >> 16;
+			return h;
+		}
+
+		const float PortalExtent = 100.f;
+	}
+
+	uint32 ChunkGenerator::hash(uint32 a, uint32 b, uint32 c, uint32 d)
+	{
+		uint32 h = mix(a + 0x9e3779b9);
+		h = mix(h ^ (b + 0x7f4a7c15));
+		h = mix(h ^ (c + 0x632be5ab));
+		return mix(h ^ (d + 0x1b873593));
+	}
+
+	FIntPoint ChunkGenerator::chunkOf(const ChunkParams& params, const FVector2D& pos)
+	{
+		return FIntPoint(FMath::FloorToInt(pos.X / params.chunkSize), FMath::FloorToInt(pos.Y / params.chunkSize));
+	}
+
+	FBox2D ChunkGenerator::chunkBounds(const ChunkParams& params, FIntPoint coord)
+	{
+		const FVector2D min(coord.X * params.chunkSize, coord.Y * params.chunkSize);
+		return FBox2D(min, min + FVector2D(params.chunkSize, params.chunkSize));
+	}
+
+	FVector2D ChunkGenerator::portal(const ChunkParams& params, FIntPoint coord, bool vertical)
+	{
+		// middle half of the side, snapped to the hallway grid
+		FRandomStream stream((int32)hash(params.seed, coord.X, coord.Y, vertical ? 1 : 2));
+		const float along = FMath::GridSnap(params.chunkSize * (0.25f + 0.5f * stream.FRand()), params.cellSize);
+		const FBox2D bounds = chunkBounds(params, coord);
+		if (vertical)
+			return FVector2D(bounds.Max.X, bounds.Min.Y + along);
+		return FVector2D(bounds.Min.X + along, bounds.Max.Y);
+	}
+
+	MapChunk ChunkGenerator::generate(const ChunkParams& params, FIntPoint coord)
+	{
+		MapChunk chunk;
+		chunk.coord = coord;
+		std::vector<MapRoom>& rooms = chunk.map.rooms;
+
+		FRandomStream stream((int32)hash(params.seed, coord.X, coord.Y));
+		const FBox2D bounds = chunkBounds(params, coord);
+
+		// one room per grid cell, cells picked at random when there are more than rooms
+		const int32 count = FMath::Max(params.roomsPerChunk, 1);
+		const int32 side = FMath::CeilToInt(FMath::Sqrt((float)count));
+		std::vector<int32> cells(side * side);
+		for (int32 i = 0; i < (int32)cells.size(); i++)
+			cells[i] = i;
+		for (int32 i = (int32)cells.size() - 1; i > 0; i--)
+			std::swap(cells[i], cells[stream.RandRange(0, i)]);
+		cells.resize(count);
+		std::sort(cells.begin(), cells.end());
+
+		// keep a gap to the border so portals have room to connect
+		const float inner = params.chunkSize - 4.f * PortalExtent;
+		const float cell = inner / side;
+		const float maxExtent = cell * 0.35f;
+		for (int32 c : cells)
+		{
+			MapRoom room;
+			const int32 scaleX = stream.RandRange(4, params.roomRange);
+			const int32 scaleY = stream.RandRange(4, params.roomRange);
+			room.extent = FVector2D(FMath::Min(scaleX * 50.f, maxExtent), FMath::Min(scaleY * 50.f, maxExtent));
+			room.scale = scaleX + scaleY;
+			room.flags = Room_Main;
+
+			const FVector2D cellMin = bounds.Min + FVector2D(2.f * PortalExtent + (c % side) * cell, 2.f * PortalExtent + (c / side) * cell);
+			const FVector2D slack = FVector2D(cell, cell) - room.extent * 2.f;
+			room.center = cellMin + room.extent + FVector2D(stream.FRand() * slack.X, stream.FRand() * slack.Y);
+			rooms.push_back(room);
+		}
+
+		// the four sides, each shared with one neighbour
+		const FVector2D portals[4] = {
+			portal(params, coord, true),
+			portal(params, coord - FIntPoint(1, 0), true),
+			portal(params, coord, false),
+			portal(params, coord - FIntPoint(0, 1), false),
+		};
+		for (const FVector2D& p : portals)
+		{
+			MapRoom room;
+			room.center = p;
+			room.extent = FVector2D(PortalExtent, PortalExtent);
+			room.flags = Room_Portal;
+			rooms.push_back(room);
+		}
+
+		MapGenerator::triangulate(rooms, chunk.map.triangles, MapMemory::heap(), params.snapSize);
+		MapGenerator::spanningTree(rooms, chunk.map.triangles, stream, params.loopChance, chunk.map.edges, chunk.map.edgeIsLoop);
+		MapGenerator::routeHallways(rooms, chunk.map.edges, params.cellSize, chunk.map.hallways);
+		return chunk;
+	}
+}
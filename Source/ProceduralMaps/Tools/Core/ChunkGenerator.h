@@ -0,0 +1,46 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MapGenerator.h"
+
+namespace Helpers {
+
+	struct ChunkParams
+	{
+		int32 seed = 0;
+		float chunkSize = 8000.f;	// world units per chunk side
+		int32 roomsPerChunk = 9;
+		int32 roomRange = 10;		// max room scale, min is 4
+		float loopChance = 1.f / 9.f;
+		float cellSize = 100.f;		// hallway grid
+		float snapSize = 0.f;		// > 0 triangulates exactly, see MapGenerator::triangulate
+	};
+
+	struct MapChunk
+	{
+		FIntPoint coord;
+		GeneratedMap map;	// rooms in world space, portals flagged Room_Portal
+	};
+
+	// Generates the world one square chunk at a time. A chunk only depends on
+	// (seed, x, y): rooms sit in a jittered grid inside the chunk, away from its
+	// border. Every chunk side gets one portal, a small room placed on the
+	// border from a hash of (seed, side) so both chunks that share the side put
+	// it in the same spot. Each chunk connects its rooms and its four portals,
+	// so hallways from both sides end on the same point and the seams join
+	// without either chunk knowing about the other.
+	class ChunkGenerator {
+
+	public:
+		static MapChunk generate(const ChunkParams& params, FIntPoint coord);
+
+		static FIntPoint chunkOf(const ChunkParams& params, const FVector2D& pos);
+		static FBox2D chunkBounds(const ChunkParams& params, FIntPoint coord);
+
+		// portal on the side between (x, y) and (x + 1, y) when vertical, else (x, y + 1)
+		static FVector2D portal(const ChunkParams& params, FIntPoint coord, bool vertical);
+
+		// stable across platforms and engine versions
+		static uint32 hash(uint32 a, uint32 b, uint32 c, uint32 d = 0);
+	};
+}
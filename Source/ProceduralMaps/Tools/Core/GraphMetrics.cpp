@@ -0,0 +1,591 @@
+#include "GraphMetrics.h"
+#include "MapStats.h"
+#include "MapEventLog.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include <algorithm>
+
+namespace Helpers {
+
+	namespace {
+		// switch points from Beamer et al: bottom up once the frontier has more
+		// than 1/Alpha of the unexplored edges, back once it has under 1/Beta of the rooms
+		const int64 Alpha = 14;
+		const int64 Beta = 24;
+
+		// levels smaller than this stay on the calling thread
+		const int32 ParallelRooms = 4096;
+		// frontier rooms per top down task, and bitset words per bottom up task
+		const int32 RoomsPerTask = 1024;
+		const int32 WordsPerTask = 64;
+		// tasks of the searches from many sources, each with scratch for the
+		// whole graph. Fixed so betweenness sums in the same order every time
+		const int32 SourceTasks = 16;
+
+		inline bool test(const std::vector<uint64>& bits, int32 i)
+		{
+			return (bits[i >> 6] >> (i & 63)) & 1;
+		}
+
+		inline void set(std::vector<uint64>& bits, int32 i)
+		{
+			bits[i >> 6] |= 1ull << (i & 63);
+		}
+
+		inline int32 lowestBit(uint64 bits)
+		{
+			const uint32 low = (uint32)bits;
+			return low ? (int32)FMath::CountTrailingZeros(low) : 32 + (int32)FMath::CountTrailingZeros((uint32)(bits >> 32));
+		}
+
+		// plain search for small components, resets only the rooms it reached
+		int32 localSearch(const RoomGraph& graph, int32 source, std::vector<int32>& dist, std::vector<int32>& order)
+		{
+			order.clear();
+			order.push_back(source);
+			dist[source] = 0;
+			for (size_t k = 0; k < order.size(); k++)
+			{
+				const int32 v = order[k];
+				for (const int32* u = graph.begin(v); u != graph.end(v); ++u)
+				{
+					if (dist[*u] < 0)
+					{
+						dist[*u] = dist[v] + 1;
+						order.push_back(*u);
+					}
+				}
+			}
+			const int32 deepest = dist[order.back()];
+			for (int32 v : order)
+			{
+				dist[v] = -1;
+			}
+			return deepest;
+		}
+	}
+
+	void RoomGraph::build(int32 rooms, const std::vector<std::pair<int32, int32>>& edges)
+	{
+		// both directions of every edge, sorted so duplicates sit next to each other
+		std::vector<std::pair<int32, int32>> arcs;
+		arcs.reserve(edges.size() * 2);
+		for (const auto& e : edges)
+		{
+			if (e.first == e.second || e.first < 0 || e.second < 0 || e.first >= rooms || e.second >= rooms)
+				continue;
+			arcs.push_back({ e.first, e.second });
+			arcs.push_back({ e.second, e.first });
+		}
+		std::sort(arcs.begin(), arcs.end());
+		arcs.erase(std::unique(arcs.begin(), arcs.end()), arcs.end());
+
+		offsets.assign(rooms + 1, 0);
+		adjacency.resize(arcs.size());
+		for (size_t i = 0; i < arcs.size(); i++)
+		{
+			offsets[arcs[i].first + 1]++;
+			adjacency[i] = arcs[i].second;
+		}
+		for (int32 r = 0; r < rooms; r++)
+		{
+			offsets[r + 1] += offsets[r];
+		}
+	}
+
+	int32 RoomBfs::run(int32 source, std::vector<int32>& depth, bool parallel)
+	{
+		const int32 n = m_Graph.num();
+		depth.assign(n, -1);
+		m_BottomUpLevels = 0;
+		if (source < 0 || source >= n)
+			return -1;
+
+		const int32 words = (n + 63) / 64;
+		m_Visited.assign(words, 0);
+		m_Queue.clear();
+		m_Queue.push_back(source);
+		depth[source] = 0;
+		set(m_Visited, source);
+
+		int64 frontierEdges = m_Graph.degree(source);
+		int64 unexplored = (int64)m_Graph.adjacency.size() - frontierEdges;
+		int32 frontierRooms = 1;
+		bool bottomUp = false;
+		int32 level = 0;
+		while (true)
+		{
+			if (!bottomUp && frontierEdges > unexplored / Alpha)
+			{
+				m_Front.assign(words, 0);
+				for (int32 r : m_Queue)
+				{
+					set(m_Front, r);
+				}
+				bottomUp = true;
+			}
+			else if (bottomUp && frontierRooms < n / Beta)
+			{
+				m_Queue.clear();
+				for (int32 w = 0; w < words; w++)
+				{
+					for (uint64 bits = m_Front[w]; bits; bits &= bits - 1)
+					{
+						m_Queue.push_back(w * 64 + lowestBit(bits));
+					}
+				}
+				bottomUp = false;
+			}
+
+			int32 rooms = 0;
+			int64 edges = 0;
+			if (bottomUp)
+			{
+				this->bottomUp(level, depth, parallel, rooms, edges);
+				m_BottomUpLevels++;
+			}
+			else
+			{
+				topDown(level, depth, parallel, rooms, edges);
+			}
+			if (rooms == 0)
+				break;
+
+			level++;
+			frontierRooms = rooms;
+			frontierEdges = edges;
+			unexplored -= edges;
+		}
+		return level;
+	}
+
+	void RoomBfs::topDown(int32 level, std::vector<int32>& depth, bool parallel, int32& rooms, int64& edges)
+	{
+		m_NextQueue.clear();
+		auto visit = [&](int32 r)
+		{
+			if (test(m_Visited, r))
+				return;
+			set(m_Visited, r);
+			depth[r] = level + 1;
+			m_NextQueue.push_back(r);
+			edges += m_Graph.degree(r);
+		};
+
+		const int32 count = (int32)m_Queue.size();
+		if (!parallel || count < ParallelRooms)
+		{
+			for (int32 v : m_Queue)
+			{
+				for (const int32* u = m_Graph.begin(v); u != m_Graph.end(v); ++u)
+				{
+					visit(*u);
+				}
+			}
+		}
+		else
+		{
+			// tasks only read the visited set, the merge claims rooms in task order
+			const int32 tasks = FMath::DivideAndRoundUp(count, RoomsPerTask);
+			if ((int32)m_Found.size() < tasks)
+				m_Found.resize(tasks);
+			ParallelFor(tasks, [&](int32 t)
+			{
+				std::vector<int32>& found = m_Found[t];
+				found.clear();
+				const int32 last = FMath::Min(count, (t + 1) * RoomsPerTask);
+				for (int32 i = t * RoomsPerTask; i < last; i++)
+				{
+					const int32 v = m_Queue[i];
+					for (const int32* u = m_Graph.begin(v); u != m_Graph.end(v); ++u)
+					{
+						if (!test(m_Visited, *u))
+							found.push_back(*u);
+					}
+				}
+			});
+			for (int32 t = 0; t < tasks; t++)
+			{
+				for (int32 r : m_Found[t])
+				{
+					visit(r);
+				}
+			}
+		}
+		rooms = (int32)m_NextQueue.size();
+		m_Queue.swap(m_NextQueue);
+	}
+
+	void RoomBfs::bottomUp(int32 level, std::vector<int32>& depth, bool parallel, int32& rooms, int64& edges)
+	{
+		const int32 n = m_Graph.num();
+		const int32 words = (int32)m_Visited.size();
+		m_Next.assign(words, 0);
+
+		// every task owns whole words of the bitsets, so nothing is shared
+		const int32 tasks = parallel && n >= ParallelRooms ? FMath::DivideAndRoundUp(words, WordsPerTask) : 1;
+		const int32 wordsPerTask = tasks == 1 ? words : WordsPerTask;
+		m_TaskRooms.assign(tasks, 0);
+		m_TaskEdges.assign(tasks, 0);
+		ParallelFor(tasks, [&](int32 t)
+		{
+			const int32 last = FMath::Min(words, (t + 1) * wordsPerTask);
+			for (int32 w = t * wordsPerTask; w < last; w++)
+			{
+				uint64 todo = ~m_Visited[w];
+				if (w == words - 1 && (n & 63))
+					todo &= (1ull << (n & 63)) - 1;
+				for (; todo; todo &= todo - 1)
+				{
+					const int32 v = w * 64 + lowestBit(todo);
+					for (const int32* u = m_Graph.begin(v); u != m_Graph.end(v); ++u)
+					{
+						if (test(m_Front, *u))
+						{
+							m_Next[w] |= 1ull << (v & 63);
+							depth[v] = level + 1;
+							m_TaskRooms[t]++;
+							m_TaskEdges[t] += m_Graph.degree(v);
+							break;
+						}
+					}
+				}
+			}
+		}, tasks == 1);
+
+		rooms = 0;
+		edges = 0;
+		for (int32 t = 0; t < tasks; t++)
+		{
+			rooms += m_TaskRooms[t];
+			edges += m_TaskEdges[t];
+		}
+		for (int32 w = 0; w < words; w++)
+		{
+			m_Visited[w] |= m_Next[w];
+		}
+		m_Front.swap(m_Next);
+	}
+
+	int32 GraphMetrics::components(const RoomGraph& graph, std::vector<int32>& componentOf)
+	{
+		const int32 n = graph.num();
+		componentOf.assign(n, INDEX_NONE);
+		std::vector<int32> stack;
+		int32 count = 0;
+		for (int32 s = 0; s < n; s++)
+		{
+			if (componentOf[s] != INDEX_NONE)
+				continue;
+			componentOf[s] = count;
+			stack.push_back(s);
+			while (!stack.empty())
+			{
+				const int32 v = stack.back();
+				stack.pop_back();
+				for (const int32* u = graph.begin(v); u != graph.end(v); ++u)
+				{
+					if (componentOf[*u] == INDEX_NONE)
+					{
+						componentOf[*u] = count;
+						stack.push_back(*u);
+					}
+				}
+			}
+			count++;
+		}
+		return count;
+	}
+
+	bool GraphMetrics::eccentricity(const RoomGraph& graph, const std::vector<int32>& componentOf, int32 componentCount,
+		int32 exactRooms, int32 sweeps, std::vector<int32>& out)
+	{
+		const int32 n = graph.num();
+		out.assign(n, 0);
+
+		std::vector<std::vector<int32>> members(componentCount);
+		for (int32 r = 0; r < n; r++)
+		{
+			members[componentOf[r]].push_back(r);
+		}
+
+		// small components, a search from every room
+		std::vector<int32> sources;
+		for (const auto& m : members)
+		{
+			if ((int32)m.size() <= exactRooms)
+				sources.insert(sources.end(), m.begin(), m.end());
+		}
+		const int32 count = (int32)sources.size();
+		const int32 tasks = FMath::Min(SourceTasks, count);
+		ParallelFor(tasks, [&](int32 t)
+		{
+			std::vector<int32> dist(n, -1);
+			std::vector<int32> order;
+			for (int32 i = t; i < count; i += tasks)
+			{
+				out[sources[i]] = localSearch(graph, sources[i], dist, order);
+			}
+		});
+
+		// big ones, lower bounds from sweeps that each start at the room
+		// farthest from every sweep so far, exact for the sweep roots
+		bool exact = true;
+		RoomBfs bfs(graph);
+		std::vector<int32> depth;
+		std::vector<int32> nearest;
+		for (const auto& m : members)
+		{
+			if ((int32)m.size() <= exactRooms)
+				continue;
+			exact = false;
+			nearest.assign(n, MAX_int32);
+			int32 root = m[0];
+			for (int32 s = 0; s < FMath::Max(sweeps, 1); s++)
+			{
+				bfs.run(root, depth);
+				int32 next = root;
+				for (int32 r : m)
+				{
+					out[r] = FMath::Max(out[r], depth[r]);
+					nearest[r] = FMath::Min(nearest[r], depth[r]);
+					if (nearest[r] > nearest[next])
+						next = r;
+				}
+				if (nearest[next] == 0)
+					break;
+				root = next;
+			}
+		}
+		return exact;
+	}
+
+	void GraphMetrics::articulationPoints(const RoomGraph& graph, std::vector<int32>& points)
+	{
+		// Tarjan's low links with an explicit stack, maps can be too deep to recurse
+		const int32 n = graph.num();
+		points.clear();
+		std::vector<int32> order(n, -1);
+		std::vector<int32> low(n, 0);
+		std::vector<int32> parent(n, -1);
+		std::vector<uint8> cut(n, 0);
+		std::vector<std::pair<int32, int32>> stack;	// room, next neighbour offset
+		int32 time = 0;
+		for (int32 s = 0; s < n; s++)
+		{
+			if (order[s] >= 0)
+				continue;
+			int32 rootChildren = 0;
+			order[s] = low[s] = time++;
+			stack.push_back({ s, graph.offsets[s] });
+			while (!stack.empty())
+			{
+				const int32 v = stack.back().first;
+				int32& i = stack.back().second;
+				if (i < graph.offsets[v + 1])
+				{
+					const int32 u = graph.adjacency[i++];
+					if (order[u] < 0)
+					{
+						parent[u] = v;
+						order[u] = low[u] = time++;
+						if (v == s)
+							rootChildren++;
+						stack.push_back({ u, graph.offsets[u] });
+					}
+					else if (u != parent[v])
+					{
+						low[v] = FMath::Min(low[v], order[u]);
+					}
+					continue;
+				}
+				stack.pop_back();
+				const int32 p = parent[v];
+				if (p >= 0)
+				{
+					low[p] = FMath::Min(low[p], low[v]);
+					if (p != s && low[v] >= order[p])
+						cut[p] = 1;
+				}
+			}
+			if (rootChildren > 1)
+				cut[s] = 1;
+		}
+		for (int32 r = 0; r < n; r++)
+		{
+			if (cut[r])
+				points.push_back(r);
+		}
+	}
+
+	bool GraphMetrics::betweenness(const RoomGraph& graph, int32 sources, int32 seed, std::vector<float>& out)
+	{
+		const int32 n = graph.num();
+		out.assign(n, 0.f);
+		if (n < 3)
+			return true;
+
+		// a partial shuffle picks the sampled sources
+		std::vector<int32> picked(n);
+		for (int32 r = 0; r < n; r++)
+			picked[r] = r;
+		const bool exact = sources <= 0 || sources >= n;
+		if (!exact)
+		{
+			FRandomStream stream(seed);
+			for (int32 i = 0; i < sources; i++)
+			{
+				std::swap(picked[i], picked[stream.RandRange(i, n - 1)]);
+			}
+			picked.resize(sources);
+		}
+
+		const int32 count = (int32)picked.size();
+		const int32 tasks = FMath::Min(SourceTasks, count);
+		std::vector<std::vector<double>> sums(tasks);
+		ParallelFor(tasks, [&](int32 t)
+		{
+			std::vector<double>& sum = sums[t];
+			sum.assign(n, 0.0);
+			std::vector<int32> dist(n, -1);
+			std::vector<double> paths(n, 0.0);
+			std::vector<double> delta(n, 0.0);
+			std::vector<int32> order;
+			for (int32 i = t; i < count; i += tasks)
+			{
+				const int32 s = picked[i];
+				order.clear();
+				order.push_back(s);
+				dist[s] = 0;
+				paths[s] = 1.0;
+				for (size_t k = 0; k < order.size(); k++)
+				{
+					const int32 v = order[k];
+					for (const int32* u = graph.begin(v); u != graph.end(v); ++u)
+					{
+						if (dist[*u] < 0)
+						{
+							dist[*u] = dist[v] + 1;
+							order.push_back(*u);
+						}
+						if (dist[*u] == dist[v] + 1)
+							paths[*u] += paths[v];
+					}
+				}
+				for (size_t k = order.size(); k-- > 0;)
+				{
+					const int32 v = order[k];
+					for (const int32* u = graph.begin(v); u != graph.end(v); ++u)
+					{
+						if (dist[*u] == dist[v] + 1)
+							delta[v] += paths[v] / paths[*u] * (1.0 + delta[*u]);
+					}
+					if (v != s)
+						sum[v] += delta[v];
+				}
+				// only what this search touched
+				for (int32 v : order)
+				{
+					dist[v] = -1;
+					paths[v] = 0.0;
+					delta[v] = 0.0;
+				}
+			}
+		});
+
+		// every pair is seen from both ends, scaled up when sampled
+		const double scale = ((double)n / count) / ((double)(n - 1) * (n - 2));
+		for (int32 r = 0; r < n; r++)
+		{
+			double total = 0.0;
+			for (int32 t = 0; t < tasks; t++)
+				total += sums[t][r];
+			out[r] = (float)FMath::Min(total * scale, 1.0);
+		}
+		return exact;
+	}
+
+	void GraphMetrics::compute(int32 rooms, const std::vector<std::pair<int32, int32>>& edges, const Options& options, RoomGraphMetrics& out)
+	{
+		RoomGraph graph;
+		graph.build(rooms, edges);
+		compute(graph, options, out);
+	}
+
+	void GraphMetrics::compute(const RoomGraph& graph, const Options& options, RoomGraphMetrics& out)
+	{
+		MAP_SCOPE(STAT_MapGraphMetrics);
+		const double startTime = FPlatformTime::Seconds();
+		const int32 n = graph.num();
+		out = RoomGraphMetrics();
+		if (n == 0)
+			return;
+
+		for (int32 r = 0; r < n; r++)
+		{
+			if (graph.degree(r) == 1)
+				out.deadEnds.push_back(r);
+		}
+
+		std::vector<int32> componentOf;
+		out.components = components(graph, componentOf);
+		out.exactEccentricity = eccentricity(graph, componentOf, out.components, options.exactRooms, options.sweeps, out.eccentricity);
+		articulationPoints(graph, out.articulationPoints);
+		out.exactBetweenness = betweenness(graph, options.betweennessSources, options.seed, out.betweenness);
+
+		// diameter from its lowest room, the other end is the farthest from there
+		int32 a = 0;
+		for (int32 r = 1; r < n; r++)
+		{
+			if (out.eccentricity[r] > out.eccentricity[a])
+				a = r;
+		}
+		RoomBfs bfs(graph);
+		bfs.run(a, out.depth);
+		int32 b = a;
+		for (int32 r = 0; r < n; r++)
+		{
+			if (out.depth[r] > out.depth[b])
+				b = r;
+		}
+		out.diameter = out.depth[b];
+		out.eccentricity[a] = out.diameter;
+		out.diameterEnds = { a, b };
+
+		// start at a diameter end, a dead end one if either is
+		out.start = options.start;
+		if (out.start < 0 || out.start >= n)
+			out.start = graph.degree(a) != 1 && graph.degree(b) == 1 ? b : a;
+		if (out.start != a)
+			bfs.run(out.start, out.depth);
+
+		// boss the deepest room, dead ends first on ties
+		auto deeper = [&](int32 x, int32 y)
+		{
+			if (out.depth[x] != out.depth[y])
+				return out.depth[x] > out.depth[y];
+			if ((graph.degree(x) == 1) != (graph.degree(y) == 1))
+				return graph.degree(x) == 1;
+			return x < y;
+		};
+		out.boss = out.start;
+		for (int32 r = 0; r < n; r++)
+		{
+			if (deeper(r, out.boss))
+				out.boss = r;
+		}
+
+		for (int32 r : out.deadEnds)
+		{
+			if (r != out.start && r != out.boss && out.depth[r] > 0)
+				out.treasures.push_back(r);
+		}
+		std::sort(out.treasures.begin(), out.treasures.end(), deeper);
+		if ((int32)out.treasures.size() > options.treasures)
+			out.treasures.resize(FMath::Max(options.treasures, 0));
+
+		out.seconds = FPlatformTime::Seconds() - startTime;
+		MAP_EVENT(Info, GraphMetrics, out.diameter, (int64)out.articulationPoints.size(), out.seconds * 1000.0);
+	}
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <vector>
+#include <utility>
+
+namespace Helpers {
+
+	// Undirected room graph in compressed rows, the neighbours of room r are
+	// adjacency[offsets[r] .. offsets[r + 1]). Duplicate edges and self loops
+	// are dropped.
+	struct RoomGraph
+	{
+		std::vector<int32> offsets;
+		std::vector<int32> adjacency;
+
+		void build(int32 rooms, const std::vector<std::pair<int32, int32>>& edges);
+
+		inline int32 num() const { return offsets.empty() ? 0 : (int32)offsets.size() - 1; }
+		inline int32 degree(int32 r) const { return offsets[r + 1] - offsets[r]; }
+		inline const int32* begin(int32 r) const { return adjacency.data() + offsets[r]; }
+		inline const int32* end(int32 r) const { return adjacency.data() + offsets[r + 1]; }
+	};
+
+	// Direction optimizing breadth first search. A level is expanded top down
+	// from a list while the frontier is small, and bottom up over bitsets,
+	// every unvisited room looking for a parent in the frontier, once the
+	// frontier holds enough of the unexplored edges. Wide levels are split
+	// over worker threads. Keeps its scratch, use one per thread.
+	class RoomBfs {
+
+	public:
+		explicit RoomBfs(const RoomGraph& graph) : m_Graph(graph) {}
+
+		// hops from 'source' to every room, -1 where unreachable. Returns the deepest level.
+		int32 run(int32 source, std::vector<int32>& depth, bool parallel = true);
+
+		// levels of the last run done bottom up
+		inline int32 bottomUpLevels() const { return m_BottomUpLevels; }
+
+	private:
+		void topDown(int32 level, std::vector<int32>& depth, bool parallel, int32& rooms, int64& edges);
+		void bottomUp(int32 level, std::vector<int32>& depth, bool parallel, int32& rooms, int64& edges);
+
+		const RoomGraph& m_Graph;
+		std::vector<uint64> m_Visited;
+		std::vector<uint64> m_Front;
+		std::vector<uint64> m_Next;
+		std::vector<int32> m_Queue;
+		std::vector<int32> m_NextQueue;
+		std::vector<std::vector<int32>> m_Found;	// per task, top down
+		std::vector<int32> m_TaskRooms;			// per task, bottom up
+		std::vector<int64> m_TaskEdges;
+		int32 m_BottomUpLevels = 0;
+	};
+
+	struct RoomGraphMetrics
+	{
+		// gameplay rooms
+		int32 start = INDEX_NONE;
+		int32 boss = INDEX_NONE;		// deepest room from start
+		std::vector<int32> treasures;		// dead ends, deepest first
+
+		std::vector<int32> depth;		// hops from start, -1 unreachable
+		std::vector<int32> eccentricity;	// within the room's component
+		int32 diameter = 0;
+		std::pair<int32, int32> diameterEnds = { INDEX_NONE, INDEX_NONE };
+		std::vector<int32> deadEnds;		// rooms with one neighbour
+		std::vector<int32> articulationPoints;	// rooms that split the map when removed
+		std::vector<float> betweenness;		// share of shortest paths through a room, 0..1
+		int32 components = 0;
+
+		bool exactEccentricity = true;		// else lower bounds from far apart sweeps
+		bool exactBetweenness = true;		// else sampled from some sources and scaled
+		double seconds = 0.0;
+	};
+
+	// Metrics of the room graph of a finished map and the rooms picked from
+	// them: start at an end of the diameter, boss the room deepest from
+	// start, treasures the deepest other dead ends. Samples are drawn from a
+	// stream on 'seed' and every parallel sum is in a fixed order, so the
+	// same graph always gives the same result.
+	class GraphMetrics {
+
+	public:
+		struct Options
+		{
+			int32 start = INDEX_NONE;	// INDEX_NONE picks an end of the diameter
+			int32 exactRooms = 2048;	// components up to this size get a search from every room
+			int32 sweeps = 8;		// searches for the eccentricity bounds of bigger ones
+			int32 betweennessSources = 64;	// every room when there are fewer
+			int32 treasures = 3;
+			int32 seed = 0;
+		};
+
+		static void compute(const RoomGraph& graph, const Options& options, RoomGraphMetrics& out);
+		static void compute(int32 rooms, const std::vector<std::pair<int32, int32>>& edges, const Options& options, RoomGraphMetrics& out);
+
+		// component of every room, ids 0..count-1 in order of their lowest room
+		static int32 components(const RoomGraph& graph, std::vector<int32>& componentOf);
+		// returns true when every value is exact
+		static bool eccentricity(const RoomGraph& graph, const std::vector<int32>& componentOf, int32 componentCount,
+			int32 exactRooms, int32 sweeps, std::vector<int32>& out);
+		static void articulationPoints(const RoomGraph& graph, std::vector<int32>& points);
+		// Brandes over 'sources' rooms drawn from 'seed', all rooms when that is not fewer. Returns true when exact
+		static bool betweenness(const RoomGraph& graph, int32 sources, int32 seed, std::vector<float>& out);
+	};
+}
@@ -0,0 +1,233 @@
+#include "HierarchicalGraph.h"
+#include "ChunkGenerator.h"
+#include "MapSpatialIndex.h"
+#include "MapArena.h"
+#include "MapStats.h"
+#include "../ExactFloat.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+
+MAP_EXACT_FLOAT
+
+namespace Helpers {
+
+	namespace {
+		// a few hundred rooms need far less, the arena grows if not
+		const size_t DistrictScratchBytes = 64 << 10;
+
+		struct District
+		{
+			std::vector<int32> members;		// global room indices
+			std::vector<MapRoom> local;
+			MapSpatialIndex centers;		// room centres as points, items index 'members'
+			FBox2D bounds{ ForceInit };		// of the centres
+			std::vector<std::array<int32, 3>> triangles;
+			std::vector<std::pair<int32, int32>> edges;
+			std::vector<uint8> isLoop;
+			int32 representative = -1;
+		};
+
+		// stream for a level of the graph that only depends on the seed
+		inline FRandomStream streamFor(int32 seed, uint32 district, uint32 level)
+		{
+			return FRandomStream((int32)ChunkGenerator::hash((uint32)seed, district, level, 0x48474750));
+		}
+
+		inline float distSquared(const FBox2D& box, const FVector2D& p)
+		{
+			const float dx = FMath::Max(FMath::Max(box.Min.X - p.X, p.X - box.Max.X), 0.f);
+			const float dy = FMath::Max(FMath::Max(box.Min.Y - p.Y, p.Y - box.Max.Y), 0.f);
+			return dx * dx + dy * dy;
+		}
+
+		// closest pair of rooms of two districts. Rooms of the smaller one farther
+		// from the other's bounds than the best so far are skipped, the rest only
+		// look at the other's rooms within that distance. Ties go to the lower
+		// room indices, the order of a plain double loop
+		std::pair<int32, int32> closestPair(const std::vector<MapRoom>& rooms, const District& a, const District& b)
+		{
+			const bool swapped = b.members.size() < a.members.size();
+			const District& small = swapped ? b : a;
+			const District& big = swapped ? a : b;
+
+			std::pair<int32, int32> best(a.members[0], b.members[0]);
+			float bestDist = FVector2D::DistSquared(rooms[best.first].center, rooms[best.second].center);
+			std::vector<int32> near;
+			for (int32 i : small.members)
+			{
+				const FVector2D& p = rooms[i].center;
+				if (distSquared(big.bounds, p) > bestDist)
+					continue;
+				big.centers.queryRadius(p, FMath::Sqrt(bestDist), near);
+				for (int32 k : near)
+				{
+					const int32 j = big.members[k];
+					const float dist = FVector2D::DistSquared(p, rooms[j].center);
+					const std::pair<int32, int32> pair = swapped ? std::make_pair(j, i) : std::make_pair(i, j);
+					if (dist < bestDist || (dist == bestDist && pair < best))
+					{
+						bestDist = dist;
+						best = pair;
+					}
+				}
+			}
+			return best;
+		}
+	}
+
+	int32 HierarchicalGraph::cluster(const std::vector<MapRoom>& rooms, int32 roomsPerCluster, std::vector<int32>& clusterOf)
+	{
+		const int32 n = (int32)rooms.size();
+		clusterOf.assign(n, 0);
+		if (n == 0)
+			return 0;
+
+		FVector2D min = rooms[0].center;
+		FVector2D max = rooms[0].center;
+		for (const MapRoom& r : rooms)
+		{
+			min = min.ComponentMin(r.center);
+			max = max.ComponentMax(r.center);
+		}
+
+		const int32 side = FMath::Max(1, FMath::RoundToInt(FMath::Sqrt((float)n / FMath::Max(roomsPerCluster, 1))));
+		const FVector2D size = (max - min).ComponentMax(FVector2D(1.f, 1.f));
+
+		// grid cell of every room, then renumbered so only used cells get ids
+		std::vector<int32> cellId(side * side, -1);
+		int32 count = 0;
+		for (int32 i = 0; i < n; i++)
+		{
+			const int32 x = FMath::Clamp((int32)((rooms[i].center.X - min.X) / size.X * side), 0, side - 1);
+			const int32 y = FMath::Clamp((int32)((rooms[i].center.Y - min.Y) / size.Y * side), 0, side - 1);
+			int32& id = cellId[y * side + x];
+			if (id < 0)
+				id = count++;
+			clusterOf[i] = id;
+		}
+		return count;
+	}
+
+	void HierarchicalGraph::build(const std::vector<MapRoom>& rooms, int32 seed, int32 roomsPerCluster, float loopChance, float snap,
+		std::vector<std::array<int32, 3>>& triangles, std::vector<std::pair<int32, int32>>& edges, std::vector<uint8>& isLoop,
+		MapStageTimes* times, MapMemory* mem)
+	{
+		triangles.clear();
+		edges.clear();
+		isLoop.clear();
+
+		std::vector<int32> clusterOf;
+		const int32 count = cluster(rooms, roomsPerCluster, clusterOf);
+		std::vector<District> districts(count);
+		for (int32 i = 0; i < (int32)rooms.size(); i++)
+		{
+			districts[clusterOf[i]].members.push_back(i);
+		}
+
+		// each district on its own, all triangulations first so the stages can be timed
+		double start = FPlatformTime::Seconds();
+		ParallelFor(count, [&](int32 c)
+		{
+			MAP_SCOPE(STAT_MapDistrict);
+			District& d = districts[c];
+			d.local.reserve(d.members.size());
+			FVector2D centroid = FVector2D::ZeroVector;
+			std::vector<FBox2D> points;
+			points.reserve(d.members.size());
+			for (int32 m : d.members)
+			{
+				d.local.push_back(rooms[m]);
+				centroid += rooms[m].center;
+				points.push_back(FBox2D(rooms[m].center, rooms[m].center));
+				d.bounds += rooms[m].center;
+			}
+			centroid = centroid / (float)d.members.size();
+			d.centers.build(points);
+
+			float best = MAX_flt;
+			for (int32 m : d.members)
+			{
+				const float dist = FVector2D::DistSquared(rooms[m].center, centroid);
+				if (dist < best)
+				{
+					best = dist;
+					d.representative = m;
+				}
+			}
+
+			// the map's arena is not thread safe
+			MapArena scratch(DistrictScratchBytes);
+			MapGenerator::triangulate(d.local, d.triangles, &scratch, snap);
+		});
+		double triangulateTime = FPlatformTime::Seconds() - start;
+
+		start = FPlatformTime::Seconds();
+		ParallelFor(count, [&](int32 c)
+		{
+			MAP_SCOPE(STAT_MapDistrict);
+			District& d = districts[c];
+			FRandomStream stream = streamFor(seed, (uint32)c, 0);
+			MapArena scratch(DistrictScratchBytes);
+			MapGenerator::spanningTree(d.local, d.triangles, stream, loopChance, d.edges, d.isLoop, &scratch);
+			std::vector<MapRoom>().swap(d.local);
+		});
+		double spanTime = FPlatformTime::Seconds() - start;
+		if (times)
+		{
+			times->triangulate = triangulateTime;
+			times->spanningTree = spanTime;
+		}
+
+		// back to global indices, in district order so the output is stable
+		for (const District& d : districts)
+		{
+			for (const auto& t : d.triangles)
+			{
+				triangles.push_back({ d.members[t[0]], d.members[t[1]], d.members[t[2]] });
+			}
+			for (size_t i = 0; i < d.edges.size(); i++)
+			{
+				edges.push_back({ d.members[d.edges[i].first], d.members[d.edges[i].second] });
+				isLoop.push_back(d.isLoop[i]);
+			}
+		}
+		if (count < 2)
+			return;
+
+		// coarse level over the representatives
+		std::vector<MapRoom> reps(count);
+		for (int32 c = 0; c < count; c++)
+		{
+			reps[c] = rooms[districts[c].representative];
+		}
+		std::vector<std::array<int32, 3>> coarseTriangles;
+		std::vector<std::pair<int32, int32>> coarseEdges;
+		std::vector<uint8> coarseLoop;
+		FRandomStream stream = streamFor(seed, 0, 1);
+		start = FPlatformTime::Seconds();
+		MapGenerator::triangulate(reps, coarseTriangles, mem, snap);
+		triangulateTime += FPlatformTime::Seconds() - start;
+
+		start = FPlatformTime::Seconds();
+		MapGenerator::spanningTree(reps, coarseTriangles, stream, loopChance, coarseEdges, coarseLoop, mem);
+
+		// districts are joined where they come closest
+		std::vector<std::pair<int32, int32>> links(coarseEdges.size());
+		ParallelFor((int32)coarseEdges.size(), [&](int32 e)
+		{
+			links[e] = closestPair(rooms, districts[coarseEdges[e].first], districts[coarseEdges[e].second]);
+		});
+		spanTime += FPlatformTime::Seconds() - start;
+		if (times)
+		{
+			times->triangulate = triangulateTime;
+			times->spanningTree = spanTime;
+		}
+
+		for (size_t e = 0; e < links.size(); e++)
+		{
+			edges.push_back(links[e]);
+			isLoop.push_back(coarseLoop[e]);
+		}
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MapGenerator.h"
+
+namespace Helpers {
+
+	// Two level room graph for big maps. Rooms are bucketed into a square grid
+	// of districts holding about 'roomsPerCluster' rooms each. Every district
+	// is triangulated and spanned on its own, in parallel, with a stream seeded
+	// from (seed, district) so the result does not depend on thread timing.
+	// Districts are then joined by a coarse triangulation and MST over one
+	// representative room each, every coarse edge becoming a hallway between
+	// the closest pair of rooms of the two districts, found with a spatial
+	// index over each district's room centres.
+	class HierarchicalGraph {
+
+	public:
+		// 'snap' as for MapGenerator::triangulate. 'mem' is only used by the coarse level,
+		// districts run in parallel and each uses a scratch arena of its own
+		static void build(const std::vector<MapRoom>& rooms, int32 seed, int32 roomsPerCluster, float loopChance, float snap,
+			std::vector<std::array<int32, 3>>& triangles, std::vector<std::pair<int32, int32>>& edges, std::vector<uint8>& isLoop,
+			MapStageTimes* times = nullptr, MapMemory* mem = MapMemory::heap());
+
+		// district of every room, ids are 0..count-1 with no empty district
+		static int32 cluster(const std::vector<MapRoom>& rooms, int32 roomsPerCluster, std::vector<int32>& clusterOf);
+	};
+}
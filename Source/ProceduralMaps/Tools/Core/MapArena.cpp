@@ -0,0 +1,68 @@
+#include "MapArena.h"
+
+namespace Helpers {
+
+	MapArena::MapArena(size_t initialBytes)
+	{
+		m_Blocks.reserve(16);
+		addBlock(FMath::Max<size_t>(initialBytes, 4096));
+	}
+
+	MapArena::~MapArena()
+	{
+		for (const Block& b : m_Blocks)
+		{
+			FMemory::Free(b.data);
+		}
+	}
+
+	void MapArena::addBlock(size_t size)
+	{
+		m_Blocks.push_back({ (uint8*)FMemory::Malloc(size, 64), size });
+		m_BlockAllocations++;
+	}
+
+	void* MapArena::allocate(size_t bytes, size_t alignment)
+	{
+		for (;;)
+		{
+			const Block& b = m_Blocks[m_Current];
+			const size_t start = Align(m_Offset, alignment);
+			if (start + bytes <= b.size)
+			{
+				m_Offset = start + bytes;
+				m_Used += bytes;
+				m_HighWater = FMath::Max(m_HighWater, m_Used);
+				return b.data + start;
+			}
+
+			// next block, or a new one at least twice the last
+			if (m_Current + 1 == (int32)m_Blocks.size())
+				addBlock(FMath::Max(b.size * 2, bytes + alignment));
+			m_Current++;
+			m_Offset = 0;
+		}
+	}
+
+	void MapArena::deallocate(void* p, size_t bytes, size_t alignment)
+	{
+	}
+
+	void MapArena::reset()
+	{
+		if (m_Blocks.size() > 1)
+		{
+			size_t total = 0;
+			for (const Block& b : m_Blocks)
+			{
+				total += b.size;
+				FMemory::Free(b.data);
+			}
+			m_Blocks.clear();
+			addBlock(total);
+		}
+		m_Current = 0;
+		m_Offset = 0;
+		m_Used = 0;
+	}
+}
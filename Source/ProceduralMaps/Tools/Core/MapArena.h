@@ -0,0 +1,49 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "../MapMemory.h"
+#include <vector>
+
+namespace Helpers {
+
+	// Bump allocator for one generation job. Frees are ignored, everything is
+	// given back at once by reset(). After a reset that needed more than one
+	// block the blocks are swapped for a single one of the combined size, so a
+	// job that runs the same work again does not touch the global heap.
+	// Not thread safe, use one per worker.
+	class MapArena : public MapMemory {
+
+	public:
+		explicit MapArena(size_t initialBytes = 1 << 20);
+		~MapArena();
+
+		MapArena(const MapArena&) = delete;
+		MapArena& operator=(const MapArena&) = delete;
+
+		void reset();
+
+		inline size_t used() const { return m_Used; }
+		inline size_t highWater() const { return m_HighWater; }
+		// blocks taken from the global heap since construction
+		inline int32 blockAllocations() const { return m_BlockAllocations; }
+
+		virtual void* allocate(size_t bytes, size_t alignment) override;
+		virtual void deallocate(void* p, size_t bytes, size_t alignment) override;
+
+	private:
+		struct Block
+		{
+			uint8* data;
+			size_t size;
+		};
+
+		void addBlock(size_t size);
+
+		std::vector<Block> m_Blocks;
+		int32 m_Current = 0;	// block being bumped
+		size_t m_Offset = 0;	// into the current block
+		size_t m_Used = 0;
+		size_t m_HighWater = 0;
+		int32 m_BlockAllocations = 0;
+	};
+}
@@ -0,0 +1,424 @@
+#include "MapBenchmark.h"
+#include "MapArena.h"
+#include "GraphMetrics.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/PlatformMisc.h"
+#include "Misc/FileHelper.h"
+#include <algorithm>
+
+namespace Helpers {
+
+	namespace {
+		// disc radius per sqrt(room count), rooms cover about a quarter of the
+		// disc so separation has work to do at every size but can finish
+		const float RoomSpread = 800.f;
+
+		enum Stage
+		{
+			Stage_Sample,
+			Stage_Separate,
+			Stage_Select,
+			Stage_Distance,
+			Stage_Triangulate,
+			Stage_SpanningTree,
+			Stage_Hallways,
+			Stage_Metrics,
+			Stage_Count
+		};
+
+		const TCHAR* StageNames[Stage_Count] = {
+			TEXT("sample"), TEXT("separate"), TEXT("select"), TEXT("distance"),
+			TEXT("triangulate"), TEXT("spanning_tree"), TEXT("hallways"), TEXT("metrics")
+		};
+
+		double median(std::vector<double>& times)
+		{
+			std::sort(times.begin(), times.end());
+			return times[times.size() / 2];
+		}
+
+		// median time of 'run' on a fresh copy of 'map', which then holds the output of the last run
+		template<typename Func>
+		double timeStage(int32 repeats, GeneratedMap& map, Func run)
+		{
+			std::vector<double> times;
+			GeneratedMap work;
+			for (int32 r = 0; r < FMath::Max(repeats, 1); r++)
+			{
+				work = map;
+				const double start = FPlatformTime::Seconds();
+				run(work);
+				times.push_back(FPlatformTime::Seconds() - start);
+				if (times.back() > 1.0)
+					break;
+			}
+			map = std::move(work);
+			return median(times);
+		}
+
+		FVector2D gaussian(FRandomStream& stream, float sigma)
+		{
+			// Box-Muller
+			const float u = FMath::Max(stream.FRand(), 1e-7f);
+			const float r = sigma * FMath::Sqrt(-2.f * FMath::Loge(u));
+			const float theta = stream.FRand() * 2 * PI;
+			return FVector2D(r * FMath::Cos(theta), r * FMath::Sin(theta));
+		}
+
+		FString rowKey(const FString& stage, RoomLayout layout, int32 rooms, int32 threads)
+		{
+			return FString::Printf(TEXT("%s|%d|%d|%d"), *stage, (int32)layout, rooms, threads);
+		}
+	}
+
+	const TCHAR* MapBenchmark::layoutName(RoomLayout layout)
+	{
+		switch (layout)
+		{
+		case RoomLayout::Clustered: return TEXT("clustered");
+		case RoomLayout::Ring: return TEXT("ring");
+		default: return TEXT("uniform");
+		}
+	}
+
+	bool MapBenchmark::parseLayout(const FString& name, RoomLayout& layout)
+	{
+		for (RoomLayout l : { RoomLayout::Uniform, RoomLayout::Clustered, RoomLayout::Ring })
+		{
+			if (name == layoutName(l))
+			{
+				layout = l;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void MapBenchmark::makeRooms(RoomLayout layout, int32 count, int32 seed, std::vector<MapRoom>& rooms)
+	{
+		FRandomStream stream(seed);
+		MapParams params;
+		params.totalRooms = count;
+		params.spawnRadius = RoomSpread * FMath::Sqrt((float)count);
+		if (layout == RoomLayout::Uniform)
+		{
+			MapGenerator::spawnRooms(params, stream, rooms);
+			return;
+		}
+
+		const float radius = params.spawnRadius;
+		std::vector<FVector2D> clusters;
+		float sigma = 0.f;
+		if (layout == RoomLayout::Clustered)
+		{
+			const int32 k = FMath::Max(1, count / 500);
+			for (int32 i = 0; i < k; i++)
+			{
+				const float r = radius * FMath::Sqrt(stream.FRand());
+				const float theta = stream.FRand() * 2 * PI;
+				clusters.push_back(FVector2D(r * FMath::Cos(theta), r * FMath::Sin(theta)));
+			}
+			sigma = radius / FMath::Sqrt((float)k) * 0.6f;
+		}
+
+		rooms.clear();
+		rooms.reserve(count);
+		for (int32 i = 0; i < count; i++)
+		{
+			MapRoom room;
+			if (layout == RoomLayout::Clustered)
+			{
+				room.center = clusters[stream.RandHelper((int32)clusters.size())] + gaussian(stream, sigma);
+			}
+			else
+			{
+				// a tenth of the radius thick, sqrt(5) wider so the area matches the disc
+				const float r = radius * 2.236f * (0.9f + 0.1f * stream.FRand());
+				const float theta = stream.FRand() * 2 * PI;
+				room.center = FVector2D(r * FMath::Cos(theta), r * FMath::Sin(theta));
+			}
+			const int32 scaleX = stream.RandRange(4, params.roomRange);
+			const int32 scaleY = stream.RandRange(4, params.roomRange);
+			room.extent = FVector2D(scaleX * 50.f, scaleY * 50.f);
+			room.scale = scaleX + scaleY;
+			rooms.push_back(room);
+		}
+	}
+
+	void MapBenchmark::runStages(const Options& options, RoomLayout layout, std::vector<BenchmarkRow>& rows)
+	{
+		const MapParams defaults;
+		bool dead[Stage_Count] = {};
+
+		for (int32 n : options.sizes)
+		{
+			MapArena arena;
+			GeneratedMap map;
+			double stageTimes[Stage_Count] = {};
+			bool ran[Stage_Count] = {};
+
+			auto stage = [&](Stage s, auto run)
+			{
+				BenchmarkRow row;
+				row.stage = StageNames[s];
+				row.layout = layout;
+				row.rooms = n;
+
+				// extrapolate from the sizes done so far, at least linear
+				if (!dead[s])
+				{
+					for (auto it = rows.rbegin(); it != rows.rend(); ++it)
+					{
+						if (it->stage == row.stage && it->layout == layout && !it->skipped)
+						{
+							const ComplexityFit f = fit(rows, row.stage, layout);
+							const double e = f.points >= 2 ? FMath::Max(f.exponent, 1.0) : 2.0;
+							dead[s] = it->seconds * FMath::Pow((double)n / it->rooms, e) > options.budget;
+							break;
+						}
+					}
+				}
+
+				row.skipped = dead[s];
+				if (!row.skipped)
+				{
+					row.seconds = timeStage(options.repeats, map, [&](GeneratedMap& work) { row.items = run(work); });
+					stageTimes[s] = row.seconds;
+					ran[s] = true;
+					arena.reset();
+				}
+				rows.push_back(row);
+			};
+
+			stage(Stage_Sample, [&](GeneratedMap& work)
+			{
+				makeRooms(layout, n, options.seed, work.rooms);
+				return (int64)work.rooms.size();
+			});
+			stage(Stage_Separate, [&](GeneratedMap& work)
+			{
+				return (int64)MapGenerator::separateRooms(work.rooms, 2000, &arena);
+			});
+			stage(Stage_Select, [&](GeneratedMap& work)
+			{
+				FRandomStream stream(options.seed);
+				MapGenerator::selectMainRooms(stream, work.rooms);
+				return (int64)work.rooms.size();
+			});
+			stage(Stage_Distance, [&](GeneratedMap& work)
+			{
+				return (int64)MapGenerator::distanceRooms(work.rooms, defaults.spacing, 2000, &arena);
+			});
+
+			// these need the output of the stage before them
+			stage(Stage_Triangulate, [&](GeneratedMap& work)
+			{
+				MapGenerator::triangulate(work.rooms, work.triangles, &arena);
+				return (int64)work.triangles.size();
+			});
+			dead[Stage_SpanningTree] |= !ran[Stage_Triangulate];
+			stage(Stage_SpanningTree, [&](GeneratedMap& work)
+			{
+				FRandomStream stream(options.seed);
+				MapGenerator::spanningTree(work.rooms, work.triangles, stream, defaults.loopChance, work.edges, work.edgeIsLoop, &arena);
+				return (int64)work.edges.size();
+			});
+			dead[Stage_Hallways] |= !ran[Stage_SpanningTree];
+			stage(Stage_Hallways, [&](GeneratedMap& work)
+			{
+				MapGenerator::routeHallways(work.rooms, work.edges, defaults.cellSize, work.hallways);
+				int64 points = 0;
+				for (const auto& line : work.hallways)
+					points += line.size();
+				return points;
+			});
+			dead[Stage_Metrics] |= !ran[Stage_SpanningTree];
+			stage(Stage_Metrics, [&](GeneratedMap& work)
+			{
+				RoomGraphMetrics metrics;
+				GraphMetrics::compute((int32)work.rooms.size(), work.edges, GraphMetrics::Options(), metrics);
+				return (int64)metrics.diameter;
+			});
+
+			BenchmarkRow pipeline;
+			pipeline.stage = TEXT("pipeline");
+			pipeline.layout = layout;
+			pipeline.rooms = n;
+			pipeline.items = (int64)map.rooms.size();
+			for (int32 s = 0; s < Stage_Count; s++)
+			{
+				pipeline.seconds += stageTimes[s];
+				pipeline.skipped |= !ran[s];
+			}
+			if (pipeline.skipped)
+				pipeline.seconds = 0.0;
+			rows.push_back(pipeline);
+		}
+	}
+
+	void MapBenchmark::runThroughput(const Options& options, std::vector<BenchmarkRow>& rows)
+	{
+		const int32 maxThreads = options.maxThreads > 0 ? options.maxThreads : FPlatformMisc::NumberOfCoresIncludingHyperthreads();
+		for (int32 threads = 1; ; threads = FMath::Min(threads * 2, maxThreads))
+		{
+			// the shipped map settings apart from the room count
+			const double start = FPlatformTime::Seconds();
+			ParallelFor(threads, [&](int32 w)
+			{
+				MapArena arena;
+				GeneratedMap map;
+				MapParams params;
+				params.totalRooms = options.threadRooms;
+				for (int32 i = w; i < options.threadMaps; i += threads)
+				{
+					params.seed = options.seed + i;
+					MapGenerator::generate(params, map, nullptr, &arena);
+				}
+			}, threads == 1);
+
+			BenchmarkRow row;
+			row.stage = TEXT("throughput");
+			row.rooms = options.threadRooms;
+			row.threads = threads;
+			row.seconds = (FPlatformTime::Seconds() - start) / FMath::Max(options.threadMaps, 1);
+			row.items = options.threadMaps;
+			rows.push_back(row);
+
+			if (threads >= maxThreads)
+				break;
+		}
+	}
+
+	ComplexityFit MapBenchmark::fit(const std::vector<BenchmarkRow>& rows, const FString& stage, RoomLayout layout)
+	{
+		std::vector<std::pair<double, double>> points;
+		for (const BenchmarkRow& r : rows)
+		{
+			// below the timer resolution the point is noise
+			if (r.stage == stage && r.layout == layout && !r.skipped && r.rooms > 1 && r.seconds > 1e-6)
+				points.push_back({ (double)r.rooms, r.seconds });
+		}
+
+		ComplexityFit result;
+		result.points = (int32)points.size();
+		if (points.size() < 2)
+			return result;
+
+		double sx = 0, sy = 0, sxx = 0, sxy = 0;
+		for (const auto& p : points)
+		{
+			const double x = FMath::Loge(p.first);
+			const double y = FMath::Loge(p.second);
+			sx += x;
+			sy += y;
+			sxx += x * x;
+			sxy += x * y;
+		}
+		const double m = (double)points.size();
+		const double d = m * sxx - sx * sx;
+		result.exponent = d != 0.0 ? (m * sxy - sx * sy) / d : 0.0;
+		result.scale = FMath::Exp((sy - result.exponent * sx) / m);
+
+		// c minimizing sum((t - c f(n)) / t)^2 for each model
+		const TCHAR* names[] = { TEXT("n"), TEXT("n log n"), TEXT("n^2") };
+		double best = MAX_dbl;
+		for (int32 model = 0; model < 3; model++)
+		{
+			auto f = [model](double n) { return model == 0 ? n : model == 1 ? n * FMath::Log2(n) : n * n; };
+			double num = 0, den = 0;
+			for (const auto& p : points)
+			{
+				num += f(p.first) / p.second;
+				den += FMath::Square(f(p.first) / p.second);
+			}
+			const double c = num / den;
+			double err = 0;
+			for (const auto& p : points)
+				err += FMath::Square(1.0 - c * f(p.first) / p.second);
+			if (err < best)
+			{
+				best = err;
+				result.model = names[model];
+			}
+		}
+		return result;
+	}
+
+	FString MapBenchmark::toCsv(const std::vector<BenchmarkRow>& rows)
+	{
+		FString out = TEXT("stage,layout,rooms,threads,seconds,items,skipped\n");
+		for (const BenchmarkRow& r : rows)
+		{
+			out += FString::Printf(TEXT("%s,%s,%d,%d,%.6f,%lld,%d\n"), *r.stage, layoutName(r.layout), r.rooms, r.threads,
+				r.seconds, r.items, r.skipped ? 1 : 0);
+		}
+		return out;
+	}
+
+	bool MapBenchmark::saveBaseline(const std::vector<BenchmarkRow>& rows, const FString& path, float threshold)
+	{
+		FString out = TEXT("stage,layout,rooms,threads,seconds,threshold\n");
+		for (const BenchmarkRow& r : rows)
+		{
+			if (!r.skipped)
+				out += FString::Printf(TEXT("%s,%s,%d,%d,%.6f,%.2f\n"), *r.stage, layoutName(r.layout), r.rooms, r.threads, r.seconds, threshold);
+		}
+		return FFileHelper::SaveStringToFile(out, *path);
+	}
+
+	bool MapBenchmark::loadBaseline(const FString& path, std::vector<BaselineRow>& baseline)
+	{
+		baseline.clear();
+		FString text;
+		if (!FFileHelper::LoadFileToString(text, *path))
+			return false;
+
+		TArray<FString> lines;
+		text.ParseIntoArrayLines(lines);
+		for (int32 i = 1; i < lines.Num(); i++)
+		{
+			TArray<FString> cols;
+			lines[i].ParseIntoArray(cols, TEXT(","), false);
+			BaselineRow row;
+			if (cols.Num() < 5 || !parseLayout(cols[1], row.layout))
+				continue;
+			row.stage = cols[0];
+			row.rooms = FCString::Atoi(*cols[2]);
+			row.threads = FCString::Atoi(*cols[3]);
+			row.seconds = FCString::Atod(*cols[4]);
+			row.threshold = cols.Num() > 5 ? FCString::Atof(*cols[5]) : 0.f;
+			baseline.push_back(row);
+		}
+		return true;
+	}
+
+	int32 MapBenchmark::compare(const std::vector<BenchmarkRow>& rows, const std::vector<BaselineRow>& baseline,
+		float threshold, FString& report)
+	{
+		TMap<FString, const BaselineRow*> byKey;
+		for (const BaselineRow& b : baseline)
+		{
+			byKey.Add(rowKey(b.stage, b.layout, b.rooms, b.threads), &b);
+		}
+
+		int32 regressions = 0;
+		for (const BenchmarkRow& r : rows)
+		{
+			const BaselineRow* const* found = byKey.Find(rowKey(r.stage, r.layout, r.rooms, r.threads));
+			if (r.skipped || !found)
+				continue;
+
+			// half a millisecond of slack so tiny stages do not fail on timer noise
+			const BaselineRow& b = **found;
+			const float limit = b.threshold > 0.f ? b.threshold : threshold;
+			if (r.seconds > b.seconds * limit && r.seconds - b.seconds > 0.0005)
+			{
+				report += FString::Printf(TEXT("%s %s %d rooms %d threads: %.4fs, baseline %.4fs (x%.2f, limit x%.2f)\n"),
+					*r.stage, layoutName(r.layout), r.rooms, r.threads, r.seconds, b.seconds, r.seconds / FMath::Max(b.seconds, 1e-9), limit);
+				regressions++;
+			}
+		}
+		return regressions;
+	}
+}
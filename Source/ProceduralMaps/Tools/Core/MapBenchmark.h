@@ -0,0 +1,87 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MapGenerator.h"
+
+namespace Helpers {
+
+	enum class RoomLayout : uint8
+	{
+		Uniform,	// MapGenerator::spawnRooms over a disc
+		Clustered,	// gaussian blobs of about 500 rooms
+		Ring,		// thin annulus, long skinny triangulations
+	};
+
+	struct BenchmarkRow
+	{
+		FString stage;		// sample, separate, ..., pipeline, throughput
+		RoomLayout layout = RoomLayout::Uniform;
+		int32 rooms = 0;	// rooms sampled, the input size of the run
+		int32 threads = 1;
+		double seconds = 0.0;	// median of the repeats, per map for throughput
+		int64 items = 0;	// what the stage produced
+		bool skipped = false;	// over the time budget, not run
+	};
+
+	struct BaselineRow
+	{
+		FString stage;
+		RoomLayout layout = RoomLayout::Uniform;
+		int32 rooms = 0;
+		int32 threads = 1;
+		double seconds = 0.0;
+		float threshold = 0.f;	// allowed slow down factor, 0 uses the default
+	};
+
+	// t ~ scale * n^exponent by least squares in log space, plus the closest
+	// of n, n log n and n^2 by relative error
+	struct ComplexityFit
+	{
+		double exponent = 0.0;
+		double scale = 0.0;
+		const TCHAR* model = TEXT("-");
+		int32 points = 0;
+	};
+
+	// Scaling runs of every generation stage over growing room counts and
+	// several input layouts. Stages run one after the other on the output of
+	// the previous one, with the room count scaled so density stays the same.
+	// A stage whose time at the next size, extrapolated from its fit so far,
+	// is over the budget is skipped there and at every bigger size; stages
+	// after a skipped one get its input unchanged.
+	class MapBenchmark {
+
+	public:
+		struct Options
+		{
+			std::vector<int32> sizes = { 10, 100, 1000, 10000, 100000, 1000000 };
+			std::vector<RoomLayout> layouts = { RoomLayout::Uniform, RoomLayout::Clustered, RoomLayout::Ring };
+			int32 repeats = 3;		// runs under a second only
+			double budget = 30.0;		// seconds per stage and size
+			int32 seed = 1;
+			int32 maxThreads = 0;		// throughput runs for 1, 2, 4 .. maxThreads
+			int32 threadRooms = 150;	// rooms per map of the throughput runs
+			int32 threadMaps = 64;
+		};
+
+		static const TCHAR* layoutName(RoomLayout layout);
+		static bool parseLayout(const FString& name, RoomLayout& layout);
+
+		// 'count' rooms with the size rules of spawnRooms
+		static void makeRooms(RoomLayout layout, int32 count, int32 seed, std::vector<MapRoom>& rooms);
+
+		static void runStages(const Options& options, RoomLayout layout, std::vector<BenchmarkRow>& rows);
+		static void runThroughput(const Options& options, std::vector<BenchmarkRow>& rows);
+
+		// over the rows of one stage and layout, skipped ones left out
+		static ComplexityFit fit(const std::vector<BenchmarkRow>& rows, const FString& stage, RoomLayout layout);
+
+		static FString toCsv(const std::vector<BenchmarkRow>& rows);
+		static bool saveBaseline(const std::vector<BenchmarkRow>& rows, const FString& path, float threshold);
+		static bool loadBaseline(const FString& path, std::vector<BaselineRow>& baseline);
+
+		// rows slower than baseline * threshold, returns how many and adds a line for each to 'report'
+		static int32 compare(const std::vector<BenchmarkRow>& rows, const std::vector<BaselineRow>& baseline,
+			float threshold, FString& report);
+	};
+}
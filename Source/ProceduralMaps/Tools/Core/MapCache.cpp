@@ -0,0 +1,180 @@
+#include "MapCache.h"
+#include "MapFile.h"
+#include "MapHash.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTLS.h"
+
+namespace Helpers {
+
+	MapCache::MapCache(int64 maxBytes, const FString& dir)
+		: m_MaxBytes(maxBytes)
+		, m_Dir(dir)
+	{
+	}
+
+	uint64 MapCache::keyOf(const MapParams& params)
+	{
+		MapHasher k;
+		k.add(GeneratorVersion);
+		k.add((uint32)MapFile::Version);
+		k.add(params.seed);
+		k.add(params.totalRooms);
+		k.add(params.roomRange);
+		k.add(params.spawnRadius);
+		k.add(params.spacing);
+		k.add(params.loopChance);
+		k.add(params.cellSize);
+		k.add(params.routeHallways);
+		k.add(params.roomsPerCluster);
+		k.add(params.snapSize);
+		// districts always span, the graph settings only change flat maps
+		if (params.roomsPerCluster <= 0)
+		{
+			k.add((uint8)params.graphMode);
+			if (params.graphMode == MapGraphMode::BetaSkeleton)
+				k.add(params.beta);
+			if (params.graphMode == MapGraphMode::Spanner)
+				k.add(params.stretch);
+		}
+		return k.h;
+	}
+
+	int64 MapCache::bytesOf(const GeneratedMap& map)
+	{
+		int64 bytes = sizeof(GeneratedMap);
+		bytes += map.rooms.capacity() * sizeof(MapRoom);
+		bytes += map.triangles.capacity() * sizeof(map.triangles[0]);
+		bytes += map.edges.capacity() * sizeof(map.edges[0]);
+		bytes += map.edgeIsLoop.capacity();
+		for (const auto& line : map.hallways)
+		{
+			bytes += sizeof(line) + line.capacity() * sizeof(FVector2D);
+		}
+		return bytes;
+	}
+
+	FString MapCache::pathOf(uint64 key) const
+	{
+		// two hex digits of fan out keeps directories small
+		const FString name = FString::Printf(TEXT("%016llx"), key);
+		return FPaths::Combine(m_Dir, name.Left(2), name + TEXT(".pmap"));
+	}
+
+	MapCache::MapPtr MapCache::findInMemory(uint64 key)
+	{
+		Entry* entry = m_Entries.Find(key);
+		if (!entry)
+			return nullptr;
+		m_Use.splice(m_Use.begin(), m_Use, entry->use);
+		return entry->map;
+	}
+
+	void MapCache::addToMemory(uint64 key, const MapPtr& map)
+	{
+		if (Entry* old = m_Entries.Find(key))
+		{
+			m_Stats.bytes -= old->bytes;
+			m_Use.erase(old->use);
+			m_Entries.Remove(key);
+			m_Stats.entries = m_Entries.Num();
+		}
+
+		const int64 bytes = bytesOf(*map);
+		if (bytes > m_MaxBytes)
+			return;
+
+		m_Use.push_front(key);
+		m_Entries.Add(key, Entry{ map, bytes, m_Use.begin() });
+		m_Stats.bytes += bytes;
+
+		while (m_Stats.bytes > m_MaxBytes && !m_Use.empty())
+		{
+			const uint64 last = m_Use.back();
+			m_Use.pop_back();
+			m_Stats.bytes -= m_Entries[last].bytes;
+			m_Entries.Remove(last);
+			m_Stats.evictions++;
+		}
+		m_Stats.entries = m_Entries.Num();
+	}
+
+	MapCache::MapPtr MapCache::find(const MapParams& params)
+	{
+		const uint64 key = keyOf(params);
+		{
+			FScopeLock lock(&m_Lock);
+			if (MapPtr map = findInMemory(key))
+			{
+				m_Stats.memoryHits++;
+				return map;
+			}
+		}
+
+		if (!m_Dir.IsEmpty())
+		{
+			MapView view;
+			if (view.open(pathOf(key)) && view.header().key == key)
+			{
+				TSharedPtr<GeneratedMap, ESPMode::ThreadSafe> map = MakeShared<GeneratedMap, ESPMode::ThreadSafe>();
+				view.toMap(*map);
+
+				FScopeLock lock(&m_Lock);
+				m_Stats.diskHits++;
+				addToMemory(key, map);
+				return map;
+			}
+		}
+
+		FScopeLock lock(&m_Lock);
+		m_Stats.misses++;
+		return nullptr;
+	}
+
+	void MapCache::add(const MapParams& params, const MapPtr& map)
+	{
+		if (!map.IsValid())
+			return;
+
+		const uint64 key = keyOf(params);
+		if (!m_Dir.IsEmpty())
+		{
+			// written under a temp name and moved, readers never see half a file
+			const FString path = pathOf(key);
+			const FString temp = path + FString::Printf(TEXT(".%u.tmp"), FPlatformTLS::GetCurrentThreadId());
+			if (MapFile::write(*map, temp, key))
+			{
+				IFileManager::Get().Move(*path, *temp, true, true);
+			}
+		}
+
+		FScopeLock lock(&m_Lock);
+		addToMemory(key, map);
+	}
+
+	MapCache::MapPtr MapCache::getOrGenerate(const MapParams& params)
+	{
+		if (MapPtr map = find(params))
+			return map;
+
+		MapPtr map = MakeShared<GeneratedMap, ESPMode::ThreadSafe>(MapGenerator::generate(params));
+		add(params, map);
+		return map;
+	}
+
+	void MapCache::clearMemory()
+	{
+		FScopeLock lock(&m_Lock);
+		m_Entries.Reset();
+		m_Use.clear();
+		m_Stats.bytes = 0;
+		m_Stats.entries = 0;
+	}
+
+	MapCacheStats MapCache::stats() const
+	{
+		FScopeLock lock(&m_Lock);
+		return m_Stats;
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MapGenerator.h"
+#include "HAL/CriticalSection.h"
+#include <list>
+
+namespace Helpers {
+
+	struct MapCacheStats
+	{
+		int64 memoryHits = 0;
+		int64 diskHits = 0;
+		int64 misses = 0;
+		int64 evictions = 0;
+		int64 bytes = 0;		// held in memory
+		int32 entries = 0;
+	};
+
+	// Generated maps by params. Recently used maps stay in memory up to a byte
+	// budget, every map is also written to 'dir' as a map file named after its
+	// key, so other processes and later runs skip generation too. Safe to use
+	// from several threads, generation itself runs outside the lock.
+	class MapCache {
+
+	public:
+		// bump when the generator changes its output for the same params
+		static const uint32 GeneratorVersion = 3;
+
+		// handed out to any thread, so the reference count has to be atomic
+		using MapPtr = TSharedPtr<const GeneratedMap, ESPMode::ThreadSafe>;
+
+		MapCache(int64 maxBytes, const FString& dir = FString());
+
+		// stable over runs and platforms, covers every field of MapParams that changes the map
+		static uint64 keyOf(const MapParams& params);
+
+		MapPtr find(const MapParams& params);
+		void add(const MapParams& params, const MapPtr& map);
+
+		// cached map or a freshly generated one that is then cached
+		MapPtr getOrGenerate(const MapParams& params);
+
+		void clearMemory();
+		MapCacheStats stats() const;
+		FString pathOf(uint64 key) const;
+
+		static int64 bytesOf(const GeneratedMap& map);
+
+	private:
+		struct Entry
+		{
+			MapPtr map;
+			int64 bytes;
+			std::list<uint64>::iterator use;
+		};
+
+		MapPtr findInMemory(uint64 key);
+		void addToMemory(uint64 key, const MapPtr& map);
+
+		int64 m_MaxBytes;
+		FString m_Dir;
+
+		mutable FCriticalSection m_Lock;
+		TMap<uint64, Entry> m_Entries;
+		std::list<uint64> m_Use;	// most recent first
+		MapCacheStats m_Stats;
+	};
+}
@@ -0,0 +1,235 @@
+#include "MapEventLog.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTLS.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/Archive.h"
+#include <algorithm>
+#include <vector>
+
+namespace Helpers {
+
+	std::atomic<bool> MapEventLog::s_Running{ false };
+	thread_local MapEventRing* MapEventLog::t_Ring = nullptr;
+
+	namespace {
+		struct EventInfo
+		{
+			const TCHAR* name;
+			const TCHAR* a;		// labels, null when unused
+			const TCHAR* b;
+			const TCHAR* value;
+		};
+
+		const EventInfo Events[(int32)MapEvent::Count] = {
+			{ TEXT("StateEnter"), TEXT("state"), nullptr, nullptr },
+			{ TEXT("RoomsSpawned"), TEXT("rooms"), nullptr, nullptr },
+			{ TEXT("SeparatePass"), TEXT("pass"), TEXT("moved"), nullptr },
+			{ TEXT("Separated"), TEXT("passes"), TEXT("rooms"), nullptr },
+			{ TEXT("MainRooms"), TEXT("kept"), TEXT("of"), nullptr },
+			{ TEXT("DistancePass"), TEXT("pass"), TEXT("moved"), nullptr },
+			{ TEXT("Triangulated"), TEXT("triangles"), TEXT("rooms"), nullptr },
+			{ TEXT("SpanningTree"), TEXT("pairs"), TEXT("kept"), nullptr },
+			{ TEXT("HallwaysRouted"), TEXT("routed"), TEXT("failed"), nullptr },
+			{ TEXT("HallwayPieces"), TEXT("pieces"), TEXT("junctions"), nullptr },
+			{ TEXT("MapGrid"), TEXT("width"), TEXT("height"), TEXT("kb") },
+			{ TEXT("MapGenerated"), TEXT("seed"), TEXT("rooms"), TEXT("ms") },
+			{ TEXT("ChunkLoaded"), TEXT("x"), TEXT("y"), TEXT("ms") },
+			{ TEXT("ChunkUnloaded"), TEXT("x"), TEXT("y"), nullptr },
+			{ TEXT("GraphMetrics"), TEXT("diameter"), TEXT("cuts"), TEXT("ms") },
+			{ TEXT("FlowFields"), TEXT("fields"), TEXT("kb"), TEXT("ms") },
+			{ TEXT("AreaIndex"), TEXT("areas"), TEXT("kb"), nullptr },
+			{ TEXT("SeedMap"), TEXT("seed"), TEXT("match"), TEXT("ms") },
+			{ TEXT("MapSelected"), TEXT("seed"), TEXT("candidates"), TEXT("ms") },
+			{ TEXT("RoomContent"), TEXT("instances"), TEXT("actors"), TEXT("ms") },
+			{ TEXT("SnapNudged"), TEXT("rooms"), TEXT("cells"), TEXT("snap") },
+		};
+
+		const TCHAR* LevelNames[] = { TEXT(""), TEXT("Error"), TEXT("Warning"), TEXT("Info"), TEXT("Verbose") };
+
+		// screen lines nobody drained are dropped past this
+		const int32 MaxScreenLines = 256;
+
+		struct Record
+		{
+			MapEventRecord r;
+			uint32 threadId;
+		};
+
+		// rings live until the process ends, a finished thread just leaves an empty one
+		FCriticalSection RingsLock;
+		TArray<MapEventRing*> Rings;
+
+		// one consumer at a time, also guards the sinks
+		FCriticalSection FlushLock;
+		TUniquePtr<FArchive> File;
+		uint8 Sinks = 0;
+		uint64 StartCycles = 0;
+		TArray<FString> ScreenLines;
+		std::vector<Record> Pending;
+
+		class FMapEventFlusher : public FRunnable
+		{
+		public:
+			explicit FMapEventFlusher(float interval) : m_Interval(interval) {}
+
+			virtual uint32 Run() override
+			{
+				while (!m_Stop.load())
+				{
+					FPlatformProcess::Sleep(m_Interval);
+					MapEventLog::flush();
+				}
+				return 0;
+			}
+
+			virtual void Stop() override { m_Stop = true; }
+
+		private:
+			std::atomic<bool> m_Stop{ false };
+			float m_Interval;
+		};
+
+		TUniquePtr<FMapEventFlusher> Flusher;
+		TUniquePtr<FRunnableThread> FlushThread;
+
+		FString format(const Record& rec)
+		{
+			const MapEventRecord& r = rec.r;
+			const EventInfo& info = Events[FMath::Min((int32)r.event, (int32)MapEvent::Count - 1)];
+			FString line = FString::Printf(TEXT("%10.3f ms  t%-6u %-7s %s"),
+				FPlatformTime::ToMilliseconds64(r.cycles - StartCycles), rec.threadId, LevelNames[(int32)r.level], info.name);
+			if (info.a)
+				line += FString::Printf(TEXT(" %s=%lld"), info.a, r.a);
+			if (info.b)
+				line += FString::Printf(TEXT(" %s=%lld"), info.b, r.b);
+			if (info.value)
+				line += FString::Printf(TEXT(" %s=%.3f"), info.value, r.value);
+			return line;
+		}
+	}
+
+	MapEventRing* MapEventLog::addThread()
+	{
+		MapEventRing* ring = new MapEventRing();
+		ring->threadId = FPlatformTLS::GetCurrentThreadId();
+		{
+			FScopeLock lock(&RingsLock);
+			Rings.Add(ring);
+		}
+		t_Ring = ring;
+		return ring;
+	}
+
+	void MapEventLog::start(uint8 sinks, const FString& path, float interval)
+	{
+		stop();
+
+		FScopeLock lock(&FlushLock);
+		Sinks = sinks;
+		if ((sinks & Sink_File) && !path.IsEmpty())
+			File.Reset(IFileManager::Get().CreateFileWriter(*path));
+		StartCycles = FPlatformTime::Cycles64();
+		s_Running = true;
+
+		Flusher = MakeUnique<FMapEventFlusher>(interval);
+		FlushThread.Reset(FRunnableThread::Create(Flusher.Get(), TEXT("MapEventLog"), 0, TPri_BelowNormal));
+	}
+
+	void MapEventLog::stop()
+	{
+		s_Running = false;
+		if (FlushThread)
+		{
+			FlushThread->Kill(true);
+			FlushThread.Reset();
+			Flusher.Reset();
+		}
+		flush();
+
+		FScopeLock lock(&FlushLock);
+		if (File)
+		{
+			File->Close();
+			File.Reset();
+		}
+		Sinks = 0;
+	}
+
+	void MapEventLog::flush()
+	{
+		FScopeLock lock(&FlushLock);
+		Pending.clear();
+		{
+			FScopeLock ringsLock(&RingsLock);
+			for (MapEventRing* ring : Rings)
+			{
+				const uint32 t = ring->tail.load(std::memory_order_relaxed);
+				const uint32 h = ring->head.load(std::memory_order_acquire);
+				for (uint32 i = t; i != h; i++)
+				{
+					Pending.push_back({ ring->records[i & (MapEventRing::Capacity - 1)], ring->threadId });
+				}
+				ring->tail.store(h, std::memory_order_release);
+			}
+		}
+		if (Pending.empty() || Sinks == 0)
+			return;
+
+		// one timeline over all threads
+		std::stable_sort(Pending.begin(), Pending.end(), [](const Record& x, const Record& y) { return x.r.cycles < y.r.cycles; });
+
+		for (const Record& rec : Pending)
+		{
+			const FString line = format(rec);
+			if (File)
+			{
+				const FString text = line + LINE_TERMINATOR;
+				FTCHARToUTF8 utf8(*text);
+				File->Serialize((void*)utf8.Get(), utf8.Length());
+			}
+			if (Sinks & Sink_Log)
+			{
+				switch (rec.r.level)
+				{
+				case MapLogLevel::Error: UE_LOG(LogTemp, Error, TEXT("%s"), *line); break;
+				case MapLogLevel::Warning: UE_LOG(LogTemp, Warning, TEXT("%s"), *line); break;
+				default: UE_LOG(LogTemp, Log, TEXT("%s"), *line); break;
+				}
+			}
+			if (Sinks & Sink_Screen)
+			{
+				if (ScreenLines.Num() >= MaxScreenLines)
+					ScreenLines.RemoveAt(0, ScreenLines.Num() - MaxScreenLines + 1, false);
+				ScreenLines.Add(line);
+			}
+		}
+		if (File)
+			File->Flush();
+	}
+
+	void MapEventLog::drainScreen(TArray<FString>& lines)
+	{
+		FScopeLock lock(&FlushLock);
+		lines = MoveTemp(ScreenLines);
+		ScreenLines.Reset();
+	}
+
+	const TCHAR* MapEventLog::eventName(MapEvent event)
+	{
+		return (int32)event < (int32)MapEvent::Count ? Events[(int32)event].name : TEXT("?");
+	}
+
+	int64 MapEventLog::dropped()
+	{
+		FScopeLock lock(&RingsLock);
+		int64 total = 0;
+		for (const MapEventRing* ring : Rings)
+		{
+			total += ring->dropped.load(std::memory_order_relaxed);
+		}
+		return total;
+	}
+}
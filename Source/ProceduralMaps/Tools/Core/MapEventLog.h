@@ -0,0 +1,145 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformTime.h"
+#include <atomic>
+
+// Highest level compiled in, events above it are stripped. Override from
+// Build.cs with PublicDefinitions.Add("MAP_LOG_LEVEL=4").
+#ifndef MAP_LOG_LEVEL
+	#if UE_BUILD_SHIPPING
+		#define MAP_LOG_LEVEL 0
+	#elif UE_BUILD_DEBUG
+		#define MAP_LOG_LEVEL 4
+	#else
+		#define MAP_LOG_LEVEL 3
+	#endif
+#endif
+
+// MAP_EVENT(Info, SeparatePass, pass, moved) - level and event without their
+// enum names, then up to two integers and a double
+#if MAP_LOG_LEVEL > 0
+	#define MAP_EVENT(Level, Event, ...) \
+		do { \
+			if ((int32)Helpers::MapLogLevel::Level <= MAP_LOG_LEVEL) \
+				Helpers::MapEventLog::write(Helpers::MapLogLevel::Level, Helpers::MapEvent::Event, ##__VA_ARGS__); \
+		} while (0)
+#else
+	#define MAP_EVENT(Level, Event, ...) do {} while (0)
+#endif
+
+namespace Helpers {
+
+	enum class MapLogLevel : uint8
+	{
+		Error = 1,
+		Warning,
+		Info,
+		Verbose,
+	};
+
+	// what the integers and the double mean is in the name table in the .cpp
+	enum class MapEvent : uint16
+	{
+		StateEnter,		// state
+		RoomsSpawned,		// rooms
+		SeparatePass,		// pass, moved
+		Separated,		// passes, rooms
+		MainRooms,		// kept, of
+		DistancePass,		// pass, moved
+		Triangulated,		// triangles, rooms
+		SpanningTree,		// candidate pairs, kept
+		HallwaysRouted,		// routed, failed
+		HallwayPieces,		// pieces, junctions
+		MapGrid,		// width, height, KB
+		MapGenerated,		// seed, rooms, ms
+		ChunkLoaded,		// x, y, ms
+		ChunkUnloaded,		// x, y
+		GraphMetrics,		// diameter, articulation points, ms
+		FlowFields,		// fields, KB, ms
+		AreaIndex,		// rooms and hallway pieces, KB
+		SeedMap,		// seed, 1 if the layout hash matched the server, ms
+		MapSelected,		// best seed, candidates, ms
+		RoomContent,		// instances, actors, ms
+		SnapNudged,		// rooms moved off a taken snap point, farthest in snap cells, snap size
+		Count
+	};
+
+	struct MapEventRecord
+	{
+		uint64 cycles;
+		int64 a;
+		int64 b;
+		double value;
+		MapEvent event;
+		MapLogLevel level;
+	};
+
+	// Single producer single consumer ring, the producer is the thread that
+	// owns it. A full ring drops the new event instead of waiting.
+	struct MapEventRing
+	{
+		static const uint32 Capacity = 4096;	// power of two
+
+		MapEventRecord records[Capacity];
+		std::atomic<uint32> head{ 0 };		// next write, owner only
+		std::atomic<uint32> tail{ 0 };		// next read, flusher only
+		std::atomic<uint32> dropped{ 0 };
+		uint32 threadId = 0;
+
+		FORCEINLINE void push(const MapEventRecord& r)
+		{
+			const uint32 h = head.load(std::memory_order_relaxed);
+			if (h - tail.load(std::memory_order_acquire) >= Capacity)
+			{
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			records[h & (Capacity - 1)] = r;
+			head.store(h + 1, std::memory_order_release);
+		}
+	};
+
+	// Generation events for any thread at the cost of a few stores. Every
+	// thread writes to a ring of its own, a background thread formats and
+	// writes them out every 'interval' seconds. Nothing is kept while the
+	// log is stopped.
+	class MapEventLog {
+
+	public:
+		enum Sink : uint8
+		{
+			Sink_File = 1,
+			Sink_Log = 2,		// UE_LOG, from the flush thread
+			Sink_Screen = 4,	// lines for drainScreen on the game thread
+		};
+
+		static void start(uint8 sinks, const FString& path = FString(), float interval = 0.05f);
+		// flushes what is left, safe to call when not started
+		static void stop();
+		static bool running() { return s_Running.load(std::memory_order_relaxed); }
+
+		FORCEINLINE static void write(MapLogLevel level, MapEvent event, int64 a = 0, int64 b = 0, double value = 0.0)
+		{
+			if (!running())
+				return;
+			MapEventRing* ring = t_Ring ? t_Ring : addThread();
+			ring->push({ FPlatformTime::Cycles64(), a, b, value, event, level });
+		}
+
+		// drains every ring into the sinks now, the flush thread calls this too
+		static void flush();
+
+		// formatted lines for the on screen console since the last call
+		static void drainScreen(TArray<FString>& lines);
+
+		static const TCHAR* eventName(MapEvent event);
+		static int64 dropped();
+
+	private:
+		static MapEventRing* addThread();
+
+		static std::atomic<bool> s_Running;
+		static thread_local MapEventRing* t_Ring;
+	};
+}
@@ -0,0 +1,297 @@
+#include "MapFile.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/FileHelper.h"
+
+// the file is written and read as raw memory
+static_assert(PLATFORM_LITTLE_ENDIAN, "map files are little endian");
+static_assert(sizeof(FVector2D) == 8, "hallway points are stored as two floats");
+
+namespace Helpers {
+
+	namespace {
+		const uint64 Align = 16;
+
+		inline uint64 alignUp(uint64 v)
+		{
+			return (v + Align - 1) & ~(Align - 1);
+		}
+
+		struct SectionData
+		{
+			const void* data;
+			uint32 stride;
+			uint64 count;
+		};
+	}
+
+	void MapFile::serialize(const GeneratedMap& map, TArray<uint8>& out, uint64 key)
+	{
+		const int32 rooms = (int32)map.rooms.size();
+		const int32 edges = (int32)map.edges.size();
+		const int32 hallways = (int32)map.hallways.size();
+
+		// rooms and edges are split into one array per field
+		std::vector<float> cx(rooms), cy(rooms), ex(rooms), ey(rooms);
+		std::vector<int32> scale(rooms);
+		std::vector<uint8> flags(rooms);
+		for (int32 i = 0; i < rooms; i++)
+		{
+			const MapRoom& r = map.rooms[i];
+			cx[i] = r.center.X;
+			cy[i] = r.center.Y;
+			ex[i] = r.extent.X;
+			ey[i] = r.extent.Y;
+			scale[i] = r.scale;
+			flags[i] = r.flags;
+		}
+
+		std::vector<int32> from(edges), to(edges);
+		std::vector<uint8> loop(edges, 0);
+		for (int32 i = 0; i < edges; i++)
+		{
+			from[i] = map.edges[i].first;
+			to[i] = map.edges[i].second;
+			if (i < (int32)map.edgeIsLoop.size())
+				loop[i] = map.edgeIsLoop[i];
+		}
+
+		std::vector<uint32> offsets(hallways + 1, 0);
+		std::vector<FVector2D> points;
+		for (int32 i = 0; i < hallways; i++)
+		{
+			points.insert(points.end(), map.hallways[i].begin(), map.hallways[i].end());
+			offsets[i + 1] = (uint32)points.size();
+		}
+
+		const SectionData sections[(uint32)MapSection::Count] = {
+			{ cx.data(), sizeof(float), (uint64)rooms },
+			{ cy.data(), sizeof(float), (uint64)rooms },
+			{ ex.data(), sizeof(float), (uint64)rooms },
+			{ ey.data(), sizeof(float), (uint64)rooms },
+			{ scale.data(), sizeof(int32), (uint64)rooms },
+			{ flags.data(), sizeof(uint8), (uint64)rooms },
+			{ map.triangles.data(), sizeof(int32) * 3, (uint64)map.triangles.size() },
+			{ from.data(), sizeof(int32), (uint64)edges },
+			{ to.data(), sizeof(int32), (uint64)edges },
+			{ loop.data(), sizeof(uint8), (uint64)edges },
+			{ offsets.data(), sizeof(uint32), (uint64)offsets.size() },
+			{ points.data(), sizeof(FVector2D), (uint64)points.size() },
+		};
+
+		const uint32 count = (uint32)MapSection::Count;
+		uint64 offset = alignUp(sizeof(MapFileHeader) + sizeof(MapFileSection) * count);
+		MapFileSection table[(uint32)MapSection::Count];
+		for (uint32 i = 0; i < count; i++)
+		{
+			table[i] = { i, sections[i].stride, offset, sections[i].count };
+			offset = alignUp(offset + sections[i].stride * sections[i].count);
+		}
+
+		MapFileHeader header;
+		FMemory::Memzero(header);
+		header.magic = Magic;
+		header.version = Version;
+		header.sectionCount = (uint16)count;
+		header.fileSize = offset;
+		header.key = key;
+		header.roomCount = (uint32)rooms;
+		header.triangleCount = (uint32)map.triangles.size();
+		header.edgeCount = (uint32)edges;
+		header.hallwayCount = (uint32)hallways;
+
+		out.Reset();
+		out.AddZeroed((int32)offset);
+		uint8* dst = out.GetData();
+		FMemory::Memcpy(dst, &header, sizeof(header));
+		FMemory::Memcpy(dst + sizeof(header), table, sizeof(table));
+		for (uint32 i = 0; i < count; i++)
+		{
+			if (table[i].count)
+				FMemory::Memcpy(dst + table[i].offset, sections[i].data, table[i].stride * table[i].count);
+		}
+	}
+
+	bool MapFile::write(const GeneratedMap& map, const FString& path, uint64 key)
+	{
+		TArray<uint8> bytes;
+		serialize(map, bytes, key);
+		return FFileHelper::SaveArrayToFile(bytes, *path);
+	}
+
+	MapView::MapView()
+	{
+	}
+
+	MapView::~MapView()
+	{
+		close();
+	}
+
+	void MapView::close()
+	{
+		// region before the handle it came from
+		m_Region.Reset();
+		m_Handle.Reset();
+		m_Loaded.Empty();
+		m_Data = nullptr;
+		m_Size = 0;
+		m_Sections = nullptr;
+	}
+
+	bool MapView::open(const FString& path)
+	{
+		close();
+
+		IPlatformFile& platform = FPlatformFileManager::Get().GetPlatformFile();
+		m_Handle.Reset(platform.OpenMapped(*path));
+		if (m_Handle)
+		{
+			m_Region.Reset(m_Handle->MapRegion(0, m_Handle->GetFileSize()));
+			if (m_Region)
+			{
+				m_Data = m_Region->GetMappedPtr();
+				m_Size = m_Region->GetMappedSize();
+				if (validate())
+					return true;
+				close();
+				return false;
+			}
+			m_Handle.Reset();
+		}
+
+		if (!FFileHelper::LoadFileToArray(m_Loaded, *path, FILEREAD_Silent))
+			return false;
+		m_Data = m_Loaded.GetData();
+		m_Size = m_Loaded.Num();
+		if (validate())
+			return true;
+		close();
+		return false;
+	}
+
+	bool MapView::openMemory(const uint8* data, int64 size)
+	{
+		close();
+		m_Data = data;
+		m_Size = size;
+		if (validate())
+			return true;
+		close();
+		return false;
+	}
+
+	// header, table and every room index and hallway offset, so nothing
+	// read through the view leaves its arrays
+	bool MapView::validate()
+	{
+		const uint32 count = (uint32)MapSection::Count;
+		if (!m_Data || m_Size < (int64)(sizeof(MapFileHeader) + sizeof(MapFileSection) * count))
+			return false;
+		if (((UPTRINT)m_Data & (Align - 1)) != 0)
+			return false;
+
+		const MapFileHeader& h = header();
+		if (h.magic != MapFile::Magic || h.version != MapFile::Version || h.sectionCount != count || h.fileSize > (uint64)m_Size)
+			return false;
+
+		m_Sections = reinterpret_cast<const MapFileSection*>(m_Data + sizeof(MapFileHeader));
+		const uint32 strides[(uint32)MapSection::Count] = { 4, 4, 4, 4, 4, 1, 12, 4, 4, 1, 4, 8 };
+		for (uint32 i = 0; i < count; i++)
+		{
+			const MapFileSection& s = m_Sections[i];
+			if (s.id != i || s.stride != strides[i] || (s.offset & (Align - 1)) != 0)
+				return false;
+			if (s.count > (uint64)MAX_int32 || s.offset > h.fileSize || s.offset + s.stride * s.count > h.fileSize)
+				return false;
+		}
+
+		for (uint32 i = (uint32)MapSection::RoomCenterX; i <= (uint32)MapSection::RoomFlags; i++)
+		{
+			if (m_Sections[i].count != h.roomCount)
+				return false;
+		}
+		auto rows = [&](MapSection s) { return m_Sections[(uint32)s].count; };
+		if (rows(MapSection::Triangles) != h.triangleCount
+			|| rows(MapSection::EdgeFrom) != h.edgeCount
+			|| rows(MapSection::EdgeTo) != h.edgeCount
+			|| rows(MapSection::EdgeIsLoop) != h.edgeCount
+			|| rows(MapSection::HallwayOffsets) != (uint64)h.hallwayCount + 1)
+			return false;
+
+		// negative indices wrap to large ones and fail too
+		for (const std::array<int32, 3>& t : section<std::array<int32, 3>>(MapSection::Triangles))
+		{
+			if ((uint32)t[0] >= h.roomCount || (uint32)t[1] >= h.roomCount || (uint32)t[2] >= h.roomCount)
+				return false;
+		}
+		for (int32 room : section<int32>(MapSection::EdgeFrom))
+		{
+			if ((uint32)room >= h.roomCount)
+				return false;
+		}
+		for (int32 room : section<int32>(MapSection::EdgeTo))
+		{
+			if ((uint32)room >= h.roomCount)
+				return false;
+		}
+
+		const TArrayView<const uint32> offsets = section<uint32>(MapSection::HallwayOffsets);
+		for (int32 i = 1; i < offsets.Num(); i++)
+		{
+			if (offsets[i] < offsets[i - 1])
+				return false;
+		}
+		return offsets[offsets.Num() - 1] <= rows(MapSection::HallwayPoints);
+	}
+
+	TArrayView<const FVector2D> MapView::hallway(int32 index) const
+	{
+		const TArrayView<const uint32> offsets = section<uint32>(MapSection::HallwayOffsets);
+		const TArrayView<const FVector2D> points = section<FVector2D>(MapSection::HallwayPoints);
+		const uint32 begin = offsets[index];
+		const uint32 end = offsets[index + 1];
+		if (begin > end || end > (uint32)points.Num())
+			return TArrayView<const FVector2D>();
+		return TArrayView<const FVector2D>(points.GetData() + begin, (int32)(end - begin));
+	}
+
+	void MapView::toMap(GeneratedMap& out) const
+	{
+		const TArrayView<const float> cx = section<float>(MapSection::RoomCenterX);
+		const TArrayView<const float> cy = section<float>(MapSection::RoomCenterY);
+		const TArrayView<const float> ex = section<float>(MapSection::RoomExtentX);
+		const TArrayView<const float> ey = section<float>(MapSection::RoomExtentY);
+		const TArrayView<const int32> scale = section<int32>(MapSection::RoomScale);
+		const TArrayView<const uint8> flags = section<uint8>(MapSection::RoomFlags);
+		out.rooms.resize(roomCount());
+		for (int32 i = 0; i < roomCount(); i++)
+		{
+			MapRoom& r = out.rooms[i];
+			r.center = FVector2D(cx[i], cy[i]);
+			r.extent = FVector2D(ex[i], ey[i]);
+			r.scale = scale[i];
+			r.flags = flags[i];
+		}
+
+		const TArrayView<const std::array<int32, 3>> tris = section<std::array<int32, 3>>(MapSection::Triangles);
+		out.triangles.assign(tris.begin(), tris.end());
+
+		const TArrayView<const int32> from = section<int32>(MapSection::EdgeFrom);
+		const TArrayView<const int32> to = section<int32>(MapSection::EdgeTo);
+		const TArrayView<const uint8> loop = section<uint8>(MapSection::EdgeIsLoop);
+		out.edges.resize(edgeCount());
+		for (int32 i = 0; i < edgeCount(); i++)
+		{
+			out.edges[i] = { from[i], to[i] };
+		}
+		out.edgeIsLoop.assign(loop.begin(), loop.end());
+
+		out.hallways.resize(hallwayCount());
+		for (int32 i = 0; i < hallwayCount(); i++)
+		{
+			const TArrayView<const FVector2D> line = hallway(i);
+			out.hallways[i].assign(line.begin(), line.end());
+		}
+	}
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MapGenerator.h"
+#include "Containers/ArrayView.h"
+#include "Templates/UniquePtr.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+namespace Helpers {
+
+	// sections of a map file, in the order they are written
+	enum class MapSection : uint32
+	{
+		RoomCenterX = 0,	// float per room
+		RoomCenterY,
+		RoomExtentX,
+		RoomExtentY,
+		RoomScale,			// int32 per room
+		RoomFlags,			// uint8 per room
+		Triangles,			// 3 x int32 room indices
+		EdgeFrom,			// int32 per edge
+		EdgeTo,
+		EdgeIsLoop,			// uint8 per edge
+		HallwayOffsets,		// uint32, hallway count + 1 offsets into points
+		HallwayPoints,		// FVector2D
+		Count
+	};
+
+	struct MapFileSection
+	{
+		uint32 id;
+		uint32 stride;		// bytes per element
+		uint64 offset;		// from the start of the file, 16 byte aligned
+		uint64 count;
+	};
+
+	struct MapFileHeader
+	{
+		uint32 magic;
+		uint16 version;
+		uint16 sectionCount;
+		uint64 fileSize;
+		uint64 key;			// params hash of the map, 0 if unknown
+		uint32 roomCount;
+		uint32 triangleCount;
+		uint32 edgeCount;
+		uint32 hallwayCount;
+	};
+
+	// Flat little endian file: a header, a section table, then every array
+	// of the map back to back. Nothing needs parsing on load, the file is
+	// mapped and the sections are used in place.
+	class MapFile {
+
+	public:
+		static const uint32 Magic = 0x50414d50;	// "PMAP"
+		static const uint16 Version = 1;
+
+		static void serialize(const GeneratedMap& map, TArray<uint8>& out, uint64 key = 0);
+		static bool write(const GeneratedMap& map, const FString& path, uint64 key = 0);
+	};
+
+	// read only view over a map file, mapped when the platform can, read into memory otherwise
+	class MapView {
+
+	public:
+		MapView();
+		~MapView();
+
+		bool open(const FString& path);
+		// caller keeps the memory alive while the view is used
+		bool openMemory(const uint8* data, int64 size);
+		void close();
+
+		inline bool isOpen() const { return m_Data != nullptr; }
+		inline const MapFileHeader& header() const { return *reinterpret_cast<const MapFileHeader*>(m_Data); }
+		inline int32 roomCount() const { return (int32)header().roomCount; }
+		inline int32 edgeCount() const { return (int32)header().edgeCount; }
+		inline int32 hallwayCount() const { return (int32)header().hallwayCount; }
+
+		template<typename T>
+		TArrayView<const T> section(MapSection id) const
+		{
+			const MapFileSection& s = m_Sections[(uint32)id];
+			return TArrayView<const T>(reinterpret_cast<const T*>(m_Data + s.offset), (int32)s.count);
+		}
+
+		TArrayView<const FVector2D> hallway(int32 index) const;
+
+		// copy back into the vectors the generator uses
+		void toMap(GeneratedMap& out) const;
+
+	private:
+		bool validate();
+
+		TUniquePtr<IMappedFileHandle> m_Handle;
+		TUniquePtr<IMappedFileRegion> m_Region;
+		TArray<uint8> m_Loaded;
+
+		const uint8* m_Data = nullptr;
+		int64 m_Size = 0;
+		const MapFileSection* m_Sections = nullptr;
+	};
+}
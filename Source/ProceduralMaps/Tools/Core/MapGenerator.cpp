@@ -0,0 +1,506 @@
+#include "MapGenerator.h"
+#include "../DelTraingle/delaunay.h"
+#include "../MinSpTree/MinSpTree.h"
+#include "../Corridors/CorridorRouter.h"
+#include "../Grid/MapRasterizer.h"
+#include "HierarchicalGraph.h"
+#include "ProximityGraph.h"
+#include "MapArena.h"
+#include "MapStats.h"
+#include "MapEventLog.h"
+#include "MapHash.h"
+#include "../ExactFloat.h"
+#include "HAL/PlatformTime.h"
+#include <algorithm>
+#include <unordered_set>
+
+MAP_EXACT_FLOAT
+
+namespace Helpers {
+
+	namespace {
+		inline int64 cellKey(int32 x, int32 y)
+		{
+			return ((int64)x << 32) ^ (uint32)y;
+		}
+
+		// rooms sorted by cell, kept across iterations so its memory is reused
+		using CellList = MapVector<std::pair<int64, int32>>;
+
+		// calls func(i, j) once for every pair of rooms in the same or a neighbouring cell
+		template<typename Func>
+		void forEachNearPair(const std::vector<MapRoom>& rooms, float cell, CellList& cells, Func func)
+		{
+			cells.clear();
+			for (int32 i = 0; i < (int32)rooms.size(); i++)
+			{
+				const FIntPoint c(FMath::FloorToInt(rooms[i].center.X / cell), FMath::FloorToInt(rooms[i].center.Y / cell));
+				cells.push_back({ cellKey(c.X, c.Y), i });
+			}
+			std::sort(cells.begin(), cells.end());
+
+			for (int32 i = 0; i < (int32)rooms.size(); i++)
+			{
+				const FIntPoint c(FMath::FloorToInt(rooms[i].center.X / cell), FMath::FloorToInt(rooms[i].center.Y / cell));
+				for (int32 y = c.Y - 1; y <= c.Y + 1; y++)
+				{
+					for (int32 x = c.X - 1; x <= c.X + 1; x++)
+					{
+						const int64 key = cellKey(x, y);
+						auto it = std::lower_bound(cells.begin(), cells.end(), std::pair<int64, int32>(key, 0));
+						for (; it != cells.end() && it->first == key; ++it)
+						{
+							if (it->second > i)
+								func(i, it->second);
+						}
+					}
+				}
+			}
+		}
+
+		// takes the free grid point closest to 'p' in rings around it, 'ring' is how far it had to go
+		FIntPoint takeFreePoint(MapHashSet<int64>& taken, const FIntPoint& p, int32& ring)
+		{
+			for (ring = 0; ; ring++)
+			{
+				for (int32 y = p.Y - ring; y <= p.Y + ring; y++)
+				{
+					for (int32 x = p.X - ring; x <= p.X + ring; x++)
+					{
+						const bool onRing = FMath::Abs(x - p.X) == ring || FMath::Abs(y - p.Y) == ring;
+						if (onRing && taken.insert(cellKey(x, y)).second)
+							return FIntPoint(x, y);
+					}
+				}
+			}
+		}
+
+		// triangles point into 'points', so the offset is the room index
+		template<typename T>
+		void triangulatePoints(MapVector<dt::Vector2<T>>& points, std::vector<std::array<int32, 3>>& triangles,
+			MapMemory* mem)
+		{
+			dt::Delaunay<T> triangulation(mem);
+			const auto& res = triangulation.triangulate(points);
+			triangles.reserve(res.size());
+			const dt::Vector2<T>* base = points.data();
+			for (const auto& t : res)
+			{
+				triangles.push_back({ (int32)(t.a - base), (int32)(t.b - base), (int32)(t.c - base) });
+			}
+		}
+	}
+
+	void MapGenerator::spawnRooms(const MapParams& params, FRandomStream& stream, std::vector<MapRoom>& rooms)
+	{
+		MAP_SCOPE(STAT_MapSpawn);
+		rooms.clear();
+		rooms.reserve(params.totalRooms);
+		for (int32 i = 0; i < params.totalRooms; i++)
+		{
+			// same distribution as Generator::getRandomPointInCircle, but only
+			// multiplies and adds so every platform rolls the same point. The
+			// CRT's sin and cos are not the same everywhere
+			FVector2D p;
+			do
+			{
+				p = FVector2D(stream.FRand() * 2.f - 1.f, stream.FRand() * 2.f - 1.f);
+			} while (p.SizeSquared() > 1.f);
+
+			MapRoom room;
+			room.center = p * params.spawnRadius;
+			const int32 scaleX = stream.RandRange(4, params.roomRange);
+			const int32 scaleY = stream.RandRange(4, params.roomRange);
+			room.extent = FVector2D(scaleX * 50.f, scaleY * 50.f);
+			room.scale = scaleX + scaleY;
+			rooms.push_back(room);
+		}
+	}
+
+	// push overlapping rooms apart along the axis with the smaller overlap
+	int32 MapGenerator::separateRooms(std::vector<MapRoom>& rooms, int32 maxIterations, MapMemory* mem)
+	{
+		MAP_SCOPE(STAT_MapSeparate);
+		float maxExtent = 1.f;
+		for (const MapRoom& r : rooms)
+		{
+			maxExtent = FMath::Max(maxExtent, r.extent.GetMax());
+		}
+
+		CellList cells(mem);
+		cells.reserve(rooms.size());
+		int32 it = 0;
+		while (it < maxIterations)
+		{
+			MAP_SCOPE(STAT_MapSeparatePass);
+			it++;
+			bool moved = false;
+			forEachNearPair(rooms, maxExtent * 2.f, cells, [&](int32 i, int32 j)
+			{
+				MapRoom& a = rooms[i];
+				MapRoom& b = rooms[j];
+				const FVector2D d = b.center - a.center;
+				const float px = a.extent.X + b.extent.X - FMath::Abs(d.X);
+				const float py = a.extent.Y + b.extent.Y - FMath::Abs(d.Y);
+				if (px <= 0.f || py <= 0.f)
+					return;
+
+				// the extra unit stops rooms from sitting exactly on each other's edge
+				if (px < py)
+				{
+					const float s = (d.X > 0.f || (d.X == 0.f && i < j)) ? 1.f : -1.f;
+					a.center.X -= s * (px * 0.5f + 1.f);
+					b.center.X += s * (px * 0.5f + 1.f);
+				}
+				else
+				{
+					const float s = (d.Y > 0.f || (d.Y == 0.f && i < j)) ? 1.f : -1.f;
+					a.center.Y -= s * (py * 0.5f + 1.f);
+					b.center.Y += s * (py * 0.5f + 1.f);
+				}
+				moved = true;
+			});
+			MAP_EVENT(Verbose, SeparatePass, it, moved);
+
+			if (!moved)
+				break;
+		}
+		return it;
+	}
+
+	// same rules as AProceduralMapsCharacter::RunHighlightMainRooms, others are dropped
+	void MapGenerator::selectMainRooms(FRandomStream& stream, std::vector<MapRoom>& rooms)
+	{
+		MAP_SCOPE(STAT_MapSelect);
+		size_t kept = 0;
+		for (MapRoom& r : rooms)
+		{
+			bool keep;
+			if (r.scale > 14 && 1 == stream.RandRange(0, 3))
+				keep = true;
+			else
+				keep = stream.RandRange(0, 4) == 0;
+
+			if (keep)
+			{
+				r.flags |= Room_Main;
+				rooms[kept++] = r;
+			}
+		}
+		rooms.resize(kept);
+	}
+
+	int32 MapGenerator::distanceRooms(std::vector<MapRoom>& rooms, float spacing, int32 maxIterations, MapMemory* mem)
+	{
+		MAP_SCOPE(STAT_MapDistance);
+		CellList cells(mem);
+		cells.reserve(rooms.size());
+		int32 it = 0;
+		while (it < maxIterations)
+		{
+			MAP_SCOPE(STAT_MapDistancePass);
+			it++;
+			bool moved = false;
+			forEachNearPair(rooms, spacing, cells, [&](int32 i, int32 j)
+			{
+				MapRoom& a = rooms[i];
+				MapRoom& b = rooms[j];
+				FVector2D d = b.center - a.center;
+				const float dist = d.Size();
+				if (dist >= spacing)
+					return;
+
+				d = dist > KINDA_SMALL_NUMBER ? d / dist : FVector2D(1.f, 0.f);
+				const float push = (spacing - dist) * 0.5f + 1.f;
+				a.center -= d * push;
+				b.center += d * push;
+				moved = true;
+			});
+			MAP_EVENT(Verbose, DistancePass, it, moved);
+
+			if (!moved)
+				break;
+		}
+		return it;
+	}
+
+	void MapGenerator::triangulate(const std::vector<MapRoom>& rooms, std::vector<std::array<int32, 3>>& triangles,
+		MapMemory* mem, float snap)
+	{
+		MAP_SCOPE(STAT_MapTriangulate);
+		triangles.clear();
+		if (rooms.size() < 3)
+			return;
+
+		if (snap > 0.f)
+		{
+			MapVector<dt::Vector2<int32_t>> points(mem);
+			points.reserve(rooms.size());
+			// two rooms on one grid point would leave one of them out of the
+			// triangulation, so later ones move to the closest free point
+			MapHashSet<int64> taken(mem);
+			taken.reserve(rooms.size());
+			int32 nudged = 0;
+			int32 farthest = 0;
+			bool fits = true;
+			for (const MapRoom& r : rooms)
+			{
+				const double x = FMath::RoundToDouble(r.center.X / (double)snap);
+				const double y = FMath::RoundToDouble(r.center.Y / (double)snap);
+				fits = FMath::Abs(x) <= dt::MaxExactCoordinate && FMath::Abs(y) <= dt::MaxExactCoordinate;
+				if (!fits)
+					break;
+
+				int32 ring = 0;
+				const FIntPoint p = takeFreePoint(taken, FIntPoint((int32)x, (int32)y), ring);
+				if (ring > 0)
+				{
+					nudged++;
+					farthest = FMath::Max(farthest, ring);
+					fits = FMath::Abs(p.X) <= dt::MaxExactCoordinate && FMath::Abs(p.Y) <= dt::MaxExactCoordinate;
+					if (!fits)
+						break;
+				}
+				points.push_back(dt::Vector2<int32_t>(p.X, p.Y));
+			}
+			if (fits)
+			{
+				if (nudged > 0)
+					MAP_EVENT(Warning, SnapNudged, nudged, farthest, snap);
+				triangulatePoints(points, triangles, mem);
+				return;
+			}
+			UE_LOG(LogTemp, Warning, TEXT("Rooms span too many %.1f snap cells for exact triangulation, using doubles"), snap);
+		}
+
+		MapVector<dt::Vector2<double>> points(mem);
+		points.reserve(rooms.size());
+		for (const MapRoom& r : rooms)
+		{
+			points.push_back(dt::Vector2<double>(r.center.X, r.center.Y));
+		}
+		triangulatePoints(points, triangles, mem);
+	}
+
+	void MapGenerator::spanningTree(const std::vector<MapRoom>& rooms, const std::vector<std::array<int32, 3>>& triangles,
+		FRandomStream& stream, float loopChance, std::vector<std::pair<int32, int32>>& edges, std::vector<uint8>& isLoop,
+		MapMemory* mem)
+	{
+		MAP_SCOPE(STAT_MapSpanningTree);
+		edges.clear();
+		isLoop.clear();
+		if (rooms.size() == 2)
+		{
+			edges.push_back({ 0, 1 });
+			isLoop.push_back(0);
+			return;
+		}
+
+		// every triangle edge once
+		MapVector<std::pair<int32, int32>> unique(mem);
+		unique.reserve(triangles.size() * 3);
+		for (const auto& t : triangles)
+		{
+			for (int32 k = 0; k < 3; k++)
+			{
+				const int32 a = t[k];
+				const int32 b = t[(k + 1) % 3];
+				unique.push_back({ FMath::Min(a, b), FMath::Max(a, b) });
+			}
+		}
+		std::sort(unique.begin(), unique.end());
+		unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+
+		// room indices go straight through, two rooms on the same spot stay two rooms
+		MinSpTree Mst(mem);
+		Mst._costPairs.reserve(unique.size());
+		for (const auto& e : unique)
+		{
+			const FVector2D& a = rooms[e.first].center;
+			const FVector2D& b = rooms[e.second].center;
+			Mst._costPairs.push_back({ FVector2D::Distance(a, b), e });
+		}
+
+		const auto pairs = Mst.getNaturalCostPairs(stream, loopChance);
+		for (size_t i = 0; i < pairs.size(); i++)
+		{
+			edges.push_back(pairs[i]);
+			isLoop.push_back(Mst._isLoop[i]);
+		}
+	}
+
+	void MapGenerator::routeHallways(const std::vector<MapRoom>& rooms, const std::vector<std::pair<int32, int32>>& edges,
+		float cellSize, std::vector<std::vector<FVector2D>>& hallways)
+	{
+		MAP_SCOPE(STAT_MapHallways);
+		std::vector<FBox2D> boxes;
+		boxes.reserve(rooms.size());
+		for (const MapRoom& r : rooms)
+		{
+			boxes.push_back(r.box());
+		}
+
+		GridFrame frame;
+		const FIntPoint size = MapRasterizer::computeFrame(boxes, cellSize, 4, frame);
+		std::vector<FIntRect> rects;
+		rects.reserve(boxes.size());
+		for (const FBox2D& b : boxes)
+		{
+			rects.push_back(FIntRect(frame.toCell(b.Min), frame.toCell(b.Max)));
+		}
+
+		CorridorRouter router;
+		router.setRooms(size.X, size.Y, rects);
+		const std::vector<CorridorRoute> routes = router.routeAll(edges);
+
+		// lines are overwritten in place so their memory is reused
+		hallways.resize(routes.size());
+		for (size_t i = 0; i < routes.size(); i++)
+		{
+			std::vector<FVector2D>& line = hallways[i];
+			line.clear();
+			if (routes[i].ok)
+			{
+				for (const FIntPoint& c : routes[i].corners)
+				{
+					line.push_back(frame.toWorld(c));
+				}
+			}
+			else // plain L shape
+			{
+				const FVector2D a = rooms[edges[i].first].center;
+				const FVector2D b = rooms[edges[i].second].center;
+				line.push_back(a);
+				line.push_back(FVector2D(b.X, a.Y));
+				line.push_back(b);
+			}
+		}
+	}
+
+	void MapGenerator::connectRooms(const MapParams& params, const std::vector<MapRoom>& rooms, FRandomStream& stream,
+		GeneratedMap& out, MapStageTimes* times, MapMemory* mem)
+	{
+		const double start = FPlatformTime::Seconds();
+		if (params.roomsPerCluster > 0)
+		{
+			// districts use their own streams, 'stream' is left as it was
+			HierarchicalGraph::build(rooms, params.seed, params.roomsPerCluster, params.loopChance, params.snapSize,
+				out.triangles, out.edges, out.edgeIsLoop, times, mem);
+			return;
+		}
+
+		triangulate(rooms, out.triangles, mem, params.snapSize);
+		const double mid = FPlatformTime::Seconds();
+		if (params.graphMode == MapGraphMode::Spanning)
+			spanningTree(rooms, out.triangles, stream, params.loopChance, out.edges, out.edgeIsLoop, mem);
+		else
+			ProximityGraph::build(params, rooms, out.triangles, out.edges, out.edgeIsLoop);
+		if (times)
+		{
+			times->triangulate = mid - start;
+			times->spanningTree = FPlatformTime::Seconds() - mid;
+		}
+	}
+
+	GeneratedMap MapGenerator::generate(const MapParams& params, MapStageTimes* times, MapArena* arena)
+	{
+		GeneratedMap map;
+		generate(params, map, times, arena);
+		return map;
+	}
+
+	void MapGenerator::generate(const MapParams& params, GeneratedMap& map, MapStageTimes* times, MapArena* arena)
+	{
+		FRandomStream stream(params.seed);
+		MapStageTimes local;
+		MapStageTimes& t = times ? *times : local;
+		TUniquePtr<MapArena> ownArena;
+		if (!arena)
+		{
+			ownArena = MakeUnique<MapArena>();
+			arena = ownArena.Get();
+		}
+
+		const int32 blocks = arena->blockAllocations();
+		double start = FPlatformTime::Seconds();
+		auto lap = [&start](double& slot)
+		{
+			const double now = FPlatformTime::Seconds();
+			slot = now - start;
+			start = now;
+		};
+
+		spawnRooms(params, stream, map.rooms);
+		t.spawned = (int32)map.rooms.size();
+		lap(t.spawn);
+		t.separatePasses = separateRooms(map.rooms, 2000, arena);
+		lap(t.separate);
+		selectMainRooms(stream, map.rooms);
+		t.mainRooms = (int32)map.rooms.size();
+		lap(t.select);
+		t.distancePasses = distanceRooms(map.rooms, params.spacing, 2000, arena);
+		lap(t.distance);
+		connectRooms(params, map.rooms, stream, map, &t, arena);
+		t.triangles = (int32)map.triangles.size();
+		t.edges = (int32)map.edges.size();
+		start = FPlatformTime::Seconds();
+		if (params.routeHallways)
+			routeHallways(map.rooms, map.edges, params.cellSize, map.hallways);
+		else
+			map.hallways.clear();
+		lap(t.hallways);
+		t.hallwayPoints = 0;
+		for (const auto& line : map.hallways)
+		{
+			t.hallwayPoints += (int32)line.size();
+		}
+
+		// frees are ignored, so what is in use now is the peak of this map
+		t.arenaBytes = (int64)arena->used();
+		t.arenaBlocks = arena->blockAllocations() - blocks;
+		MAP_EVENT(Info, MapGenerated, params.seed, t.mainRooms, t.total() * 1000.0);
+		INC_DWORD_STAT(STAT_MapsGenerated);
+		INC_DWORD_STAT_BY(STAT_MapRoomsSpawned, t.spawned);
+		SET_MEMORY_STAT(STAT_MapArenaBytes, t.arenaBytes);
+
+		// nothing in the arena outlives the call
+		arena->reset();
+	}
+
+	uint64 MapGenerator::layoutHash(const GeneratedMap& map)
+	{
+		MapHasher k;
+		k.add((int32)map.rooms.size());
+		for (const MapRoom& r : map.rooms)
+		{
+			k.add(r.center);
+			k.add(r.extent);
+			k.add(r.scale);
+			k.add(r.flags);
+		}
+		k.add((int32)map.triangles.size());
+		for (const auto& t : map.triangles)
+		{
+			k.add(t[0]);
+			k.add(t[1]);
+			k.add(t[2]);
+		}
+		k.add((int32)map.edges.size());
+		for (size_t i = 0; i < map.edges.size(); i++)
+		{
+			k.add(map.edges[i].first);
+			k.add(map.edges[i].second);
+			k.add(map.edgeIsLoop[i]);
+		}
+		k.add((int32)map.hallways.size());
+		for (const auto& line : map.hallways)
+		{
+			k.add((int32)line.size());
+			for (const FVector2D& p : line)
+			{
+				k.add(p);
+			}
+		}
+		return k.h;
+	}
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+#include <vector>
+#include <array>
+#include <utility>
+#include "../MapMemory.h"
+
+namespace Helpers {
+
+	class MapArena;
+
+	// how hallway edges are picked from the triangulation, see ProximityGraph
+	enum class MapGraphMode : uint8
+	{
+		Spanning,		// MST plus a loopChance roll per leftover edge
+		Gabriel,
+		RelativeNeighbourhood,
+		BetaSkeleton,		// between the two above, by beta
+		Spanner,		// greedy, paths at most 'stretch' times the straight line
+	};
+
+	// everything that changes the generated layout
+	struct MapParams
+	{
+		int32 seed = 0;
+		int32 totalRooms = 150;		// m_TotalRoomsToSpawn
+		int32 roomRange = 10;		// max room scale, min is 4
+		float spawnRadius = 500.f;
+		float spacing = 1000.f;		// min distance between main rooms
+		float loopChance = 1.f / 9.f;	// chance to keep a non tree edge
+		float cellSize = 100.f;		// hallway grid
+		bool routeHallways = true;
+		int32 roomsPerCluster = 0;	// > 0 builds the graph per district, see HierarchicalGraph
+		float snapSize = 0.f;		// > 0 triangulates exactly on a grid this size, see triangulate
+		MapGraphMode graphMode = MapGraphMode::Spanning;	// flat graph only, districts always span
+		float beta = 1.5f;		// BetaSkeleton lune, 1 Gabriel .. 2 relative neighbourhood
+		float stretch = 2.f;		// Spanner
+	};
+
+	enum RoomFlags : uint8
+	{
+		Room_Main = 1,
+		Room_Portal = 2,	// chunk seam connector, not a real room
+		Room_Removed = 4,	// dropped by selection, its RoomStore id stays taken
+	};
+
+	struct MapRoom
+	{
+		FVector2D center;
+		FVector2D extent;	// half size
+		int32 scale = 0;	// scaleX + scaleY like ARoom::m_Scale
+		uint8 flags = 0;
+
+		FBox2D box() const { return FBox2D(center - extent, center + extent); }
+	};
+
+	struct GeneratedMap
+	{
+		std::vector<MapRoom> rooms;
+		std::vector<std::array<int32, 3>> triangles;	// room indices
+		std::vector<std::pair<int32, int32>> edges;	// mst + loop edges
+		std::vector<uint8> edgeIsLoop;
+		std::vector<std::vector<FVector2D>> hallways;	// one polyline per edge
+	};
+
+	// seconds spent in each stage of one generate call, and what each one produced
+	struct MapStageTimes
+	{
+		double spawn = 0.0;
+		double separate = 0.0;
+		double select = 0.0;
+		double distance = 0.0;
+		double triangulate = 0.0;
+		double spanningTree = 0.0;
+		double hallways = 0.0;
+
+		int32 spawned = 0;
+		int32 separatePasses = 0;
+		int32 mainRooms = 0;
+		int32 distancePasses = 0;
+		int32 triangles = 0;
+		int32 edges = 0;
+		int32 hallwayPoints = 0;
+		int64 arenaBytes = 0;	// scratch used by the map
+		int32 arenaBlocks = 0;	// heap blocks the arena had to add for it
+
+		double total() const { return spawn + separate + select + distance + triangulate + spanningTree + hallways; }
+	};
+
+	// Data only version of the Pro_States pipeline. The same params always
+	// give the same map, no actors or world needed.
+	class MapGenerator {
+
+	public:
+		// stage scratch comes from 'arena' and is rewound at the end, a local one is used when null
+		static GeneratedMap generate(const MapParams& params, MapStageTimes* times = nullptr, MapArena* arena = nullptr);
+		// same, reusing the capacity already in 'out'
+		static void generate(const MapParams& params, GeneratedMap& out, MapStageTimes* times = nullptr, MapArena* arena = nullptr);
+
+		// stages, usable on their own. 'mem' only holds scratch, outputs are plain vectors
+		static void spawnRooms(const MapParams& params, FRandomStream& stream, std::vector<MapRoom>& rooms);
+		// the two push-apart stages return the passes they ran
+		static int32 separateRooms(std::vector<MapRoom>& rooms, int32 maxIterations = 2000,
+			MapMemory* mem = MapMemory::heap());
+		static void selectMainRooms(FRandomStream& stream, std::vector<MapRoom>& rooms);
+		static int32 distanceRooms(std::vector<MapRoom>& rooms, float spacing, int32 maxIterations = 2000,
+			MapMemory* mem = MapMemory::heap());
+		// 'snap' > 0 rounds the centres to a grid that size and triangulates them with exact
+		// integer predicates, the same triangles on every platform. Rooms that round to a
+		// taken point move to the closest free one. Falls back to doubles when the snapped
+		// map is too big for them
+		static void triangulate(const std::vector<MapRoom>& rooms, std::vector<std::array<int32, 3>>& triangles,
+			MapMemory* mem = MapMemory::heap(), float snap = 0.f);
+		// triangulation + spanning tree, flat or per district depending on params
+		static void connectRooms(const MapParams& params, const std::vector<MapRoom>& rooms, FRandomStream& stream,
+			GeneratedMap& out, MapStageTimes* times = nullptr, MapMemory* mem = MapMemory::heap());
+		static void spanningTree(const std::vector<MapRoom>& rooms, const std::vector<std::array<int32, 3>>& triangles,
+			FRandomStream& stream, float loopChance, std::vector<std::pair<int32, int32>>& edges, std::vector<uint8>& isLoop,
+			MapMemory* mem = MapMemory::heap());
+		static void routeHallways(const std::vector<MapRoom>& rooms, const std::vector<std::pair<int32, int32>>& edges,
+			float cellSize, std::vector<std::vector<FVector2D>>& hallways);
+
+		// hash of everything in the map, equal on two machines only if they built the same layout
+		static uint64 layoutHash(const GeneratedMap& map);
+	};
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace Helpers {
+
+	// FNV-1a over the bytes of each value in the order they are added, little
+	// endian on every platform so hashes can be compared across machines
+	struct MapHasher
+	{
+		uint64 h = 0xcbf29ce484222325ull;
+
+		void add(uint32 v)
+		{
+			for (int32 i = 0; i < 4; i++)
+			{
+				h ^= (v >> (i * 8)) & 0xff;
+				h *= 0x100000001b3ull;
+			}
+		}
+		void add(int32 v) { add((uint32)v); }
+		void add(uint8 v) { add((uint32)v); }
+		// by bits, so 0.1f and 0.1000001f are different maps
+		void add(float v) { uint32 bits; FMemory::Memcpy(&bits, &v, 4); add(bits); }
+		void add(bool v) { add((uint32)(v ? 1 : 0)); }
+		void add(const FVector2D& v) { add(v.X); add(v.Y); }
+	};
+}
@@ -0,0 +1,178 @@
+#include "MapSelector.h"
+#include "MapArena.h"
+#include "GraphMetrics.h"
+#include "MapStats.h"
+#include "MapEventLog.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/PlatformMisc.h"
+#include <atomic>
+#include <memory>
+
+namespace Helpers {
+
+	namespace {
+		// everything one worker keeps between its candidates
+		struct Worker
+		{
+			MapArena arena;
+			GeneratedMap map;
+			GeneratedMap best;		// swapped with 'map' on a new best
+			RoomGraph graph;
+			RoomBfs bfs{ graph };
+			std::vector<int32> depth;
+			MapCandidate bestCandidate;
+			int32 bestIndex = INDEX_NONE;
+		};
+
+		void measure(const GeneratedMap& map, Worker& w, MapFitnessStats& stats)
+		{
+			const int32 n = (int32)map.rooms.size();
+			stats = MapFitnessStats();
+			stats.rooms = n;
+			stats.edges = (int32)map.edges.size();
+			for (uint8 loop : map.edgeIsLoop)
+			{
+				stats.loops += loop ? 1 : 0;
+			}
+			if (n == 0)
+				return;
+
+			w.graph.build(n, map.edges);
+			for (int32 r = 0; r < n; r++)
+			{
+				stats.deadEnds += w.graph.degree(r) == 1 ? 1 : 0;
+			}
+
+			// the room farthest from any room is an end of the diameter on a tree
+			w.bfs.run(0, w.depth, false);
+			int32 far = 0;
+			for (int32 r = 1; r < n; r++)
+			{
+				if (w.depth[r] > w.depth[far])
+					far = r;
+			}
+			stats.diameter = FMath::Max(w.bfs.run(far, w.depth, false), 0);
+
+			// rooms are apart by now, so their areas just add up
+			FBox2D bounds(ForceInit);
+			float area = 0.f;
+			for (const MapRoom& room : map.rooms)
+			{
+				bounds += room.box();
+				area += 4.f * room.extent.X * room.extent.Y;
+			}
+			const FVector2D size = bounds.GetSize();
+			stats.coverage = FMath::Clamp(area / FMath::Max(size.X * size.Y, 1.f), 0.f, 1.f);
+		}
+	}
+
+	float MapSelector::score(const MapFitnessStats& stats, const MapFitnessWeights& weights)
+	{
+		const float rooms = (float)FMath::Max(stats.rooms, 1);
+		return weights.diameter * stats.diameter / FMath::Max(rooms - 1.f, 1.f)
+			+ weights.loops * stats.loops / rooms
+			+ weights.deadEnds * stats.deadEnds / rooms
+			+ weights.coverage * stats.coverage;
+	}
+
+	MapCandidate MapSelector::select(const MapParams& params, const Options& options, const MapFitnessWeights& weights,
+		GeneratedMap& best, std::vector<MapCandidate>* scored)
+	{
+		return select(params, options, [&weights](const GeneratedMap&, const MapFitnessStats& stats)
+		{
+			return score(stats, weights);
+		}, best, scored);
+	}
+
+	MapCandidate MapSelector::select(const MapParams& params, const Options& options, Fitness fitness,
+		GeneratedMap& best, std::vector<MapCandidate>* scored)
+	{
+		MAP_SCOPE(STAT_MapCandidates);
+		const double start = FPlatformTime::Seconds();
+		const int32 count = FMath::Max(options.candidates, 1);
+		const int32 cores = options.threads > 0 ? options.threads : FPlatformMisc::NumberOfCoresIncludingHyperthreads();
+		const int32 workers = FMath::Clamp(cores, 1, count);
+
+		std::vector<MapCandidate> results(count);
+		std::vector<uint8> ran(count, 0);
+		std::vector<std::unique_ptr<Worker>> pool(workers);
+		std::atomic<int32> next{ 0 };
+		// earliest candidate that reached stopScore, nothing after it is started
+		std::atomic<int32> stopAt{ count };
+
+		ParallelFor(workers, [&](int32 t)
+		{
+			pool[t] = std::make_unique<Worker>();
+			Worker& w = *pool[t];
+			while (true)
+			{
+				const int32 i = next.fetch_add(1, std::memory_order_relaxed);
+				if (i >= count || i > stopAt.load(std::memory_order_relaxed))
+					break;
+
+				MapParams p = params;
+				p.seed = params.seed + i;
+				MapGenerator::generate(p, w.map, nullptr, &w.arena);
+
+				MapCandidate& c = results[i];
+				c.seed = p.seed;
+				measure(w.map, w, c.stats);
+				c.score = fitness(w.map, c.stats);
+				ran[i] = 1;
+
+				// ties go to the lower seed, like a run on one thread. Past the stop it can not win
+				if (i <= stopAt.load(std::memory_order_relaxed) && (w.bestIndex == INDEX_NONE || c.score > w.bestCandidate.score))
+				{
+					w.bestCandidate = c;
+					w.bestIndex = i;
+					std::swap(w.map, w.best);
+				}
+				if (c.score >= options.stopScore)
+				{
+					int32 at = stopAt.load(std::memory_order_relaxed);
+					while (i < at && !stopAt.compare_exchange_weak(at, i, std::memory_order_relaxed))
+					{
+					}
+				}
+			}
+		}, workers == 1);
+
+		// only candidates up to the stop can win, every one of them ran
+		const int32 last = FMath::Min(stopAt.load(), count - 1);
+		int32 bestIndex = INDEX_NONE;
+		for (int32 i = 0; i <= last; i++)
+		{
+			if (bestIndex == INDEX_NONE || results[i].score > results[bestIndex].score)
+				bestIndex = i;
+		}
+		bool found = false;
+		for (const auto& w : pool)
+		{
+			if (w && w->bestIndex == bestIndex)
+			{
+				std::swap(best, w->best);
+				found = true;
+			}
+		}
+		// its worker kept a later one that beat it before the stop moved back
+		if (!found)
+		{
+			MapParams p = params;
+			p.seed = results[bestIndex].seed;
+			MapGenerator::generate(p, best);
+		}
+
+		if (scored)
+		{
+			scored->clear();
+			for (int32 i = 0; i < count; i++)
+			{
+				if (ran[i])
+					scored->push_back(results[i]);
+			}
+		}
+		MAP_EVENT(Info, MapSelected, results[bestIndex].seed, last + 1, (FPlatformTime::Seconds() - start) * 1000.0);
+		return results[bestIndex];
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MapGenerator.h"
+
+namespace Helpers {
+
+	// what a fitness function gets to look at, filled once per candidate
+	struct MapFitnessStats
+	{
+		int32 rooms = 0;
+		int32 edges = 0;
+		int32 loops = 0;		// edges outside the spanning tree
+		int32 deadEnds = 0;		// rooms with one neighbour
+		int32 diameter = 0;		// hops, exact on a tree, a lower bound from two sweeps otherwise
+		float coverage = 0.f;		// room area over the area of their bounds, 0..1
+	};
+
+	// weights of the default score, every term is scaled to about 0..1 first
+	struct MapFitnessWeights
+	{
+		float diameter = -1.f;		// diameter / (rooms - 1), long thin maps score low
+		float loops = 1.f;		// loops / rooms
+		float deadEnds = -0.5f;		// dead ends / rooms
+		float coverage = 1.f;		// spread out maps score low
+	};
+
+	struct MapCandidate
+	{
+		int32 seed = 0;
+		float score = -MAX_flt;
+		MapFitnessStats stats;
+	};
+
+	// Generates candidate maps for a run of seeds on worker threads and keeps
+	// the best scoring one. Workers take the next seed off a shared counter,
+	// so a slow map never holds the others up, and keep their arena, map
+	// buffers and search scratch for every candidate they run. Once a
+	// candidate reaches 'stopScore' no later seed is started. The seeds before
+	// it always finish and the earliest seed that reached it wins, so the
+	// result does not depend on the thread count or timing.
+	class MapSelector {
+
+	public:
+		// called from the workers at the same time, must not touch shared state
+		using Fitness = TFunctionRef<float(const GeneratedMap&, const MapFitnessStats&)>;
+
+		struct Options
+		{
+			int32 candidates = 16;		// seeds params.seed .. params.seed + candidates - 1
+			int32 threads = 0;		// all cores when 0
+			float stopScore = MAX_flt;	// good enough, stop starting new seeds
+		};
+
+		// best of the candidates into 'best', every one that ran into 'scored' in seed order when given
+		static MapCandidate select(const MapParams& params, const Options& options, Fitness fitness,
+			GeneratedMap& best, std::vector<MapCandidate>* scored = nullptr);
+		// same, scored with 'weights'
+		static MapCandidate select(const MapParams& params, const Options& options, const MapFitnessWeights& weights,
+			GeneratedMap& best, std::vector<MapCandidate>* scored = nullptr);
+
+		static float score(const MapFitnessStats& stats, const MapFitnessWeights& weights);
+	};
+}
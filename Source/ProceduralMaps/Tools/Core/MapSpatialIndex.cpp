@@ -0,0 +1,226 @@
+#include "MapSpatialIndex.h"
+#include "Async/ParallelFor.h"
+#include <algorithm>
+
+namespace Helpers {
+
+	namespace {
+		// points per batch task
+		const int32 PointsPerTask = 1024;
+
+		// distance along a 2^16 x 2^16 Hilbert curve
+		uint32 hilbert(uint32 x, uint32 y)
+		{
+			uint32 d = 0;
+			for (uint32 s = 1u << 15; s > 0; s >>= 1)
+			{
+				const uint32 rx = (x & s) ? 1 : 0;
+				const uint32 ry = (y & s) ? 1 : 0;
+				d += s * s * ((3 * rx) ^ ry);
+				if (ry == 0)
+				{
+					if (rx == 1)
+					{
+						x = s - 1 - x;
+						y = s - 1 - y;
+					}
+					std::swap(x, y);
+				}
+			}
+			return d;
+		}
+	}
+
+	void MapSpatialIndex::clear()
+	{
+		m_Count = 0;
+		m_LevelEnds.clear();
+		m_MinX.clear();
+		m_MinY.clear();
+		m_MaxX.clear();
+		m_MaxY.clear();
+		m_Index.clear();
+	}
+
+	void MapSpatialIndex::build(const std::vector<FBox2D>& boxes)
+	{
+		clear();
+		m_Count = (int32)boxes.size();
+		if (m_Count == 0)
+			return;
+
+		FBox2D bounds(boxes[0].Min, boxes[0].Max);
+		for (const FBox2D& b : boxes)
+		{
+			bounds.Min.X = FMath::Min(bounds.Min.X, b.Min.X);
+			bounds.Min.Y = FMath::Min(bounds.Min.Y, b.Min.Y);
+			bounds.Max.X = FMath::Max(bounds.Max.X, b.Max.X);
+			bounds.Max.Y = FMath::Max(bounds.Max.Y, b.Max.Y);
+		}
+		const FVector2D size = bounds.Max - bounds.Min;
+		const float sx = size.X > 0.f ? 65535.f / size.X : 0.f;
+		const float sy = size.Y > 0.f ? 65535.f / size.Y : 0.f;
+
+		// leaves in curve order
+		std::vector<std::pair<uint32, int32>> order(m_Count);
+		for (int32 i = 0; i < m_Count; i++)
+		{
+			const FVector2D c = (boxes[i].Min + boxes[i].Max) * 0.5f;
+			order[i] = { hilbert((uint32)((c.X - bounds.Min.X) * sx), (uint32)((c.Y - bounds.Min.Y) * sy)), i };
+		}
+		std::sort(order.begin(), order.end());
+
+		int32 total = m_Count;
+		for (int32 n = m_Count; n > 1;)
+		{
+			n = FMath::DivideAndRoundUp(n, NodeSize);
+			total += n;
+		}
+		m_MinX.resize(total);
+		m_MinY.resize(total);
+		m_MaxX.resize(total);
+		m_MaxY.resize(total);
+		m_Index.resize(total);
+
+		for (int32 i = 0; i < m_Count; i++)
+		{
+			const FBox2D& b = boxes[order[i].second];
+			m_MinX[i] = b.Min.X;
+			m_MinY[i] = b.Min.Y;
+			m_MaxX[i] = b.Max.X;
+			m_MaxY[i] = b.Max.Y;
+			m_Index[i] = order[i].second;
+		}
+		m_LevelEnds.push_back(m_Count);
+
+		// every node bounds the next NodeSize entries of the level below
+		int32 first = 0;
+		int32 end = m_Count;
+		while (end - first > 1)
+		{
+			int32 pos = end;
+			for (int32 c = first; c < end; c += NodeSize)
+			{
+				const int32 last = FMath::Min(c + NodeSize, end);
+				float minX = m_MinX[c], minY = m_MinY[c], maxX = m_MaxX[c], maxY = m_MaxY[c];
+				for (int32 k = c + 1; k < last; k++)
+				{
+					minX = FMath::Min(minX, m_MinX[k]);
+					minY = FMath::Min(minY, m_MinY[k]);
+					maxX = FMath::Max(maxX, m_MaxX[k]);
+					maxY = FMath::Max(maxY, m_MaxY[k]);
+				}
+				m_MinX[pos] = minX;
+				m_MinY[pos] = minY;
+				m_MaxX[pos] = maxX;
+				m_MaxY[pos] = maxY;
+				m_Index[pos] = c;
+				pos++;
+			}
+			first = end;
+			end = pos;
+			m_LevelEnds.push_back(end);
+		}
+	}
+
+	template<typename Test, typename Visit>
+	void MapSpatialIndex::search(Test test, Visit visit) const
+	{
+		if (m_Count == 0)
+			return;
+
+		// node offset and its level, the root is the last entry. A level
+		// pushes at most NodeSize entries, 8 levels hold 2^32 items
+		int32 stack[NodeSize * 8][2];
+		int32 top = 0;
+		const int32 root = (int32)m_Index.size() - 1;
+		if (!test(root))
+			return;
+		if (root < m_Count)
+		{
+			visit(m_Index[root]);
+			return;
+		}
+		stack[top][0] = root;
+		stack[top][1] = (int32)m_LevelEnds.size() - 1;
+		top++;
+
+		while (top > 0)
+		{
+			top--;
+			const int32 node = stack[top][0];
+			const int32 level = stack[top][1];
+			const int32 first = m_Index[node];
+			const int32 last = FMath::Min(first + NodeSize, m_LevelEnds[level - 1]);
+			for (int32 c = first; c < last; c++)
+			{
+				if (!test(c))
+					continue;
+				if (level == 1)
+				{
+					if (!visit(m_Index[c]))
+						return;
+				}
+				else
+				{
+					stack[top][0] = c;
+					stack[top][1] = level - 1;
+					top++;
+				}
+			}
+		}
+	}
+
+	int32 MapSpatialIndex::findAt(const FVector2D& p) const
+	{
+		int32 found = INDEX_NONE;
+		search([&](int32 i) { return p.X >= m_MinX[i] && p.X <= m_MaxX[i] && p.Y >= m_MinY[i] && p.Y <= m_MaxY[i]; },
+			[&](int32 item) { found = item; return false; });
+		return found;
+	}
+
+	void MapSpatialIndex::queryPoint(const FVector2D& p, std::vector<int32>& items) const
+	{
+		items.clear();
+		search([&](int32 i) { return p.X >= m_MinX[i] && p.X <= m_MaxX[i] && p.Y >= m_MinY[i] && p.Y <= m_MaxY[i]; },
+			[&](int32 item) { items.push_back(item); return true; });
+	}
+
+	void MapSpatialIndex::queryBox(const FBox2D& box, std::vector<int32>& items) const
+	{
+		items.clear();
+		search([&](int32 i) { return box.Max.X >= m_MinX[i] && box.Min.X <= m_MaxX[i] && box.Max.Y >= m_MinY[i] && box.Min.Y <= m_MaxY[i]; },
+			[&](int32 item) { items.push_back(item); return true; });
+	}
+
+	void MapSpatialIndex::queryRadius(const FVector2D& center, float radius, std::vector<int32>& items) const
+	{
+		items.clear();
+		const float r2 = radius * radius;
+		search([&](int32 i)
+		{
+			const float dx = FMath::Max(FMath::Max(m_MinX[i] - center.X, center.X - m_MaxX[i]), 0.f);
+			const float dy = FMath::Max(FMath::Max(m_MinY[i] - center.Y, center.Y - m_MaxY[i]), 0.f);
+			return dx * dx + dy * dy <= r2;
+		},
+		[&](int32 item) { items.push_back(item); return true; });
+	}
+
+	void MapSpatialIndex::findAtBatch(const FVector2D* points, int32 count, int32* items) const
+	{
+		const int32 tasks = FMath::DivideAndRoundUp(count, PointsPerTask);
+		ParallelFor(tasks, [&](int32 t)
+		{
+			const int32 last = FMath::Min(count, (t + 1) * PointsPerTask);
+			for (int32 i = t * PointsPerTask; i < last; i++)
+			{
+				items[i] = findAt(points[i]);
+			}
+		}, tasks <= 1);
+	}
+
+	size_t MapSpatialIndex::memoryBytes() const
+	{
+		return m_Index.size() * (4 * sizeof(float) + sizeof(int32)) + m_LevelEnds.size() * sizeof(int32);
+	}
+}
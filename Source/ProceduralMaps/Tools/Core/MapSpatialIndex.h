@@ -0,0 +1,50 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <vector>
+
+namespace Helpers {
+
+	// Static packed Hilbert R-tree over rectangles, built once when a map is
+	// done. Items are sorted along a Hilbert curve through their centres and
+	// packed 'NodeSize' to a node, level by level, into flat arrays. Boxes are
+	// kept as separate min/max columns so a node test reads 4 contiguous runs.
+	// Items are the indices of the boxes given to build. Queries are read only
+	// and safe from any number of threads.
+	class MapSpatialIndex {
+
+	public:
+		static const int32 NodeSize = 16;
+
+		void build(const std::vector<FBox2D>& boxes);
+		void clear();
+
+		inline int32 num() const { return m_Count; }
+		inline bool empty() const { return m_Count == 0; }
+
+		// first item containing the point, INDEX_NONE when none does
+		int32 findAt(const FVector2D& p) const;
+		// every item containing the point / overlapping the box / within 'radius' of the centre
+		void queryPoint(const FVector2D& p, std::vector<int32>& items) const;
+		void queryBox(const FBox2D& box, std::vector<int32>& items) const;
+		void queryRadius(const FVector2D& center, float radius, std::vector<int32>& items) const;
+
+		// findAt for 'count' points, big batches are split over worker threads
+		void findAtBatch(const FVector2D* points, int32 count, int32* items) const;
+
+		size_t memoryBytes() const;
+
+	private:
+		// visits every leaf item whose box passes 'test', until 'visit' returns false
+		template<typename Test, typename Visit>
+		void search(Test test, Visit visit) const;
+
+		int32 m_Count = 0;
+		std::vector<int32> m_LevelEnds;	// end offset of each level, leaves first
+		std::vector<float> m_MinX;
+		std::vector<float> m_MinY;
+		std::vector<float> m_MaxX;
+		std::vector<float> m_MaxY;
+		std::vector<int32> m_Index;	// leaves: item, nodes: offset of the first child
+	};
+}
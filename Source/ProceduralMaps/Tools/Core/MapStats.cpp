@@ -0,0 +1,81 @@
+#include "MapStats.h"
+
+DEFINE_STAT(STAT_MapSpawn);
+DEFINE_STAT(STAT_MapSeparate);
+DEFINE_STAT(STAT_MapSeparatePass);
+DEFINE_STAT(STAT_MapSelect);
+DEFINE_STAT(STAT_MapDistance);
+DEFINE_STAT(STAT_MapDistancePass);
+DEFINE_STAT(STAT_MapTriangulate);
+DEFINE_STAT(STAT_MapSpanningTree);
+DEFINE_STAT(STAT_MapDistrict);
+DEFINE_STAT(STAT_MapHallways);
+DEFINE_STAT(STAT_MapGraphMetrics);
+DEFINE_STAT(STAT_MapFlowFields);
+DEFINE_STAT(STAT_MapCandidates);
+DEFINE_STAT(STAT_MapContent);
+DEFINE_STAT(STAT_MapsGenerated);
+DEFINE_STAT(STAT_MapRoomsSpawned);
+DEFINE_STAT(STAT_MapArenaBytes);
+
+namespace Helpers {
+
+	void MapStageSummary::addStage(Stage& stage, double seconds, int64 items)
+	{
+		stage.total += seconds;
+		stage.max = FMath::Max(stage.max, seconds);
+		stage.items += items;
+	}
+
+	void MapStageSummary::add(const MapStageTimes& t)
+	{
+		addStage(m_Spawn, t.spawn, t.spawned);
+		addStage(m_Separate, t.separate, t.separatePasses);
+		addStage(m_Select, t.select, t.mainRooms);
+		addStage(m_Distance, t.distance, t.distancePasses);
+		addStage(m_Triangulate, t.triangulate, t.triangles);
+		addStage(m_SpanningTree, t.spanningTree, t.edges);
+		addStage(m_Hallways, t.hallways, t.hallwayPoints);
+		m_ArenaBytes += t.arenaBytes;
+		m_ArenaPeak = FMath::Max<int64>(m_ArenaPeak, t.arenaBytes);
+		m_ArenaBlocks += t.arenaBlocks;
+		m_Maps++;
+	}
+
+	FString MapStageSummary::toString() const
+	{
+		const double n = FMath::Max(m_Maps, 1);
+		FString out = FString::Printf(TEXT("%d maps\n%-14s %10s %9s %9s %12s %10s\n"), m_Maps,
+			TEXT("stage"), TEXT("total ms"), TEXT("avg ms"), TEXT("max ms"), TEXT("items"), TEXT("items/map"));
+
+		auto line = [&](const TCHAR* name, const TCHAR* items, const Stage& s)
+		{
+			out += FString::Printf(TEXT("%-14s %10.1f %9.3f %9.3f %12lld %10.1f  %s\n"), name,
+				s.total * 1000.0, s.total * 1000.0 / n, s.max * 1000.0, s.items, s.items / n, items);
+		};
+		line(TEXT("spawn"), TEXT("rooms"), m_Spawn);
+		line(TEXT("separate"), TEXT("passes"), m_Separate);
+		line(TEXT("select"), TEXT("main rooms"), m_Select);
+		line(TEXT("distance"), TEXT("passes"), m_Distance);
+		line(TEXT("triangulate"), TEXT("triangles"), m_Triangulate);
+		line(TEXT("spanning tree"), TEXT("edges"), m_SpanningTree);
+		line(TEXT("hallways"), TEXT("points"), m_Hallways);
+
+		const double total = m_Spawn.total + m_Separate.total + m_Select.total + m_Distance.total
+			+ m_Triangulate.total + m_SpanningTree.total + m_Hallways.total;
+		out += FString::Printf(TEXT("%-14s %10.1f %9.3f\n"), TEXT("total"), total * 1000.0, total * 1000.0 / n);
+		out += FString::Printf(TEXT("arena: %.1f KB avg, %.1f KB peak, %lld heap blocks\n"),
+			m_ArenaBytes / n / 1024.0, m_ArenaPeak / 1024.0, m_ArenaBlocks);
+		return out;
+	}
+
+	void MapStageSummary::log() const
+	{
+		TArray<FString> lines;
+		toString().ParseIntoArrayLines(lines);
+		for (const FString& l : lines)
+		{
+			UE_LOG(LogTemp, Display, TEXT("%s"), *l);
+		}
+	}
+}
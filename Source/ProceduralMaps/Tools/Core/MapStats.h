@@ -0,0 +1,66 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "MapGenerator.h"
+
+// 'stat ProceduralMaps' in game, the same names show up as Insights events
+DECLARE_STATS_GROUP(TEXT("ProceduralMaps"), STATGROUP_ProceduralMaps, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spawn"), STAT_MapSpawn, STATGROUP_ProceduralMaps, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Separate"), STAT_MapSeparate, STATGROUP_ProceduralMaps, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Separate pass"), STAT_MapSeparatePass, STATGROUP_ProceduralMaps, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Select"), STAT_MapSelect, STATGROUP_ProceduralMaps, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Distance"), STAT_MapDistance, STATGROUP_ProceduralMaps, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Distance pass"), STAT_MapDistancePass, STATGROUP_ProceduralMaps, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Triangulate"), STAT_MapTriangulate, STATGROUP_ProceduralMaps, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spanning tree"), STAT_MapSpanningTree, STATGROUP_ProceduralMaps, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("District"), STAT_MapDistrict, STATGROUP_ProceduralMaps, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Hallways"), STAT_MapHallways, STATGROUP_ProceduralMaps, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Graph metrics"), STAT_MapGraphMetrics, STATGROUP_ProceduralMaps, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Flow fields"), STAT_MapFlowFields, STATGROUP_ProceduralMaps, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Candidates"), STAT_MapCandidates, STATGROUP_ProceduralMaps, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Room content"), STAT_MapContent, STATGROUP_ProceduralMaps, );
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Maps generated"), STAT_MapsGenerated, STATGROUP_ProceduralMaps, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Rooms spawned"), STAT_MapRoomsSpawned, STATGROUP_ProceduralMaps, );
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Arena per map"), STAT_MapArenaBytes, STATGROUP_ProceduralMaps, );
+
+// cycle counter and Insights event for one stage or pass, 'Stat' is one of the above
+#define MAP_SCOPE(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE(Stat)
+
+namespace Helpers {
+
+	// Totals over many generate calls for a report without the editor or
+	// Insights. Not thread safe, add results from one thread.
+	class MapStageSummary {
+
+	public:
+		void add(const MapStageTimes& times);
+
+		inline int32 maps() const { return m_Maps; }
+
+		// one line per stage with total/avg/max ms and items, then allocations
+		FString toString() const;
+		void log() const;
+
+	private:
+		struct Stage
+		{
+			double total = 0.0;
+			double max = 0.0;
+			int64 items = 0;
+		};
+
+		void addStage(Stage& stage, double seconds, int64 items);
+
+		Stage m_Spawn, m_Separate, m_Select, m_Distance, m_Triangulate, m_SpanningTree, m_Hallways;
+		int32 m_Maps = 0;
+		int64 m_ArenaBytes = 0;
+		int64 m_ArenaPeak = 0;
+		int64 m_ArenaBlocks = 0;
+	};
+}
@@ -0,0 +1,427 @@
+#include "MapStream.h"
+#include "MapArena.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Serialization/Archive.h"
+
+static_assert(PLATFORM_LITTLE_ENDIAN, "map streams are little endian");
+
+namespace Helpers {
+
+	namespace {
+		struct StreamHeader
+		{
+			uint32 magic;
+			uint32 version;
+		};
+
+		template<typename T>
+		void put(TArray<uint8>& out, const T* data, int32 count)
+		{
+			const int32 bytes = count * sizeof(T);
+			const int32 at = out.AddUninitialized(bytes);
+			if (bytes)
+				FMemory::Memcpy(out.GetData() + at, data, bytes);
+		}
+
+		// reads from a payload, any overrun marks the block broken
+		struct Cursor
+		{
+			const TArray<uint8>& in;
+			int32 at = 0;
+			bool ok = true;
+
+			template<typename T>
+			void get(T* data, int32 count)
+			{
+				const int64 bytes = (int64)count * sizeof(T);
+				if (!ok || count < 0 || at + bytes > in.Num())
+				{
+					ok = false;
+					return;
+				}
+				if (bytes)
+					FMemory::Memcpy(data, in.GetData() + at, bytes);
+				at += (int32)bytes;
+			}
+
+			// whether 'count' items of 'stride' bytes are left, asked before
+			// anything is sized by a count that came from the file
+			bool fits(int64 count, int64 stride)
+			{
+				ok = ok && count >= 0 && at + count * stride <= in.Num();
+				return ok;
+			}
+		};
+
+		inline int32 slot(MapBlockType type)
+		{
+			return (int32)type - (int32)MapBlockType::Rooms;
+		}
+	}
+
+	MapStreamWriter::MapStreamWriter()
+	{
+	}
+
+	MapStreamWriter::~MapStreamWriter()
+	{
+		close();
+	}
+
+	bool MapStreamWriter::open(const FString& path)
+	{
+		close();
+		m_Ar.Reset(IFileManager::Get().CreateFileWriter(*path));
+		if (!m_Ar)
+			return false;
+
+		StreamHeader header = { Magic, Version };
+		m_Ar->Serialize(&header, sizeof(header));
+		FMemory::Memzero(m_Written, sizeof(m_Written));
+		m_Pending = MapBlock();
+		m_Pending.hallwayOffsets.push_back(0);
+		return !m_Ar->IsError();
+	}
+
+	bool MapStreamWriter::close()
+	{
+		if (!m_Ar)
+			return false;
+
+		flush(MapBlockType::Rooms);
+		flush(MapBlockType::Triangles);
+		flush(MapBlockType::Edges);
+		flush(MapBlockType::Hallways);
+
+		m_Payload.Reset();
+		put(m_Payload, m_Written, 4);
+		writeBlock(MapBlockType::End, 0, 0, m_Payload);
+
+		const bool ok = !m_Ar->IsError() && m_Ar->Close();
+		m_Ar.Reset();
+		return ok;
+	}
+
+	void MapStreamWriter::addRoom(const MapRoom& room)
+	{
+		m_Pending.rooms.push_back(room);
+		if ((int32)m_Pending.rooms.size() >= BlockElements)
+			flush(MapBlockType::Rooms);
+	}
+
+	void MapStreamWriter::addTriangle(const std::array<int32, 3>& tri)
+	{
+		m_Pending.triangles.push_back(tri);
+		if ((int32)m_Pending.triangles.size() >= BlockElements)
+			flush(MapBlockType::Triangles);
+	}
+
+	void MapStreamWriter::addEdge(int32 from, int32 to, bool loop)
+	{
+		m_Pending.edges.push_back({ from, to });
+		m_Pending.edgeIsLoop.push_back(loop ? 1 : 0);
+		if ((int32)m_Pending.edges.size() >= BlockElements)
+			flush(MapBlockType::Edges);
+	}
+
+	// a hallway is never split, a very long one gets a block of its own
+	void MapStreamWriter::addHallway(const std::vector<FVector2D>& line)
+	{
+		if (m_Pending.points.size() + line.size() > (size_t)BlockElements && m_Pending.hallwayOffsets.size() > 1)
+			flush(MapBlockType::Hallways);
+
+		m_Pending.points.insert(m_Pending.points.end(), line.begin(), line.end());
+		m_Pending.hallwayOffsets.push_back((uint32)m_Pending.points.size());
+		if ((int32)m_Pending.hallwayOffsets.size() > BlockElements || (int32)m_Pending.points.size() >= BlockElements)
+			flush(MapBlockType::Hallways);
+	}
+
+	void MapStreamWriter::flush(MapBlockType type)
+	{
+		if (!m_Ar)
+			return;
+
+		MapBlock& p = m_Pending;
+		m_Payload.Reset();
+		int32 count = 0;
+		switch (type)
+		{
+		case MapBlockType::Rooms:
+		{
+			count = (int32)p.rooms.size();
+			if (count == 0)
+				return;
+			std::vector<float> f(count);
+			for (int32 field = 0; field < 4; field++)
+			{
+				for (int32 i = 0; i < count; i++)
+				{
+					const MapRoom& r = p.rooms[i];
+					f[i] = field == 0 ? r.center.X : field == 1 ? r.center.Y : field == 2 ? r.extent.X : r.extent.Y;
+				}
+				put(m_Payload, f.data(), count);
+			}
+			std::vector<int32> scale(count);
+			std::vector<uint8> flags(count);
+			for (int32 i = 0; i < count; i++)
+			{
+				scale[i] = p.rooms[i].scale;
+				flags[i] = p.rooms[i].flags;
+			}
+			put(m_Payload, scale.data(), count);
+			put(m_Payload, flags.data(), count);
+			p.rooms.clear();
+			break;
+		}
+		case MapBlockType::Triangles:
+			count = (int32)p.triangles.size();
+			if (count == 0)
+				return;
+			put(m_Payload, p.triangles.data(), count);
+			p.triangles.clear();
+			break;
+		case MapBlockType::Edges:
+		{
+			count = (int32)p.edges.size();
+			if (count == 0)
+				return;
+			std::vector<int32> from(count), to(count);
+			for (int32 i = 0; i < count; i++)
+			{
+				from[i] = p.edges[i].first;
+				to[i] = p.edges[i].second;
+			}
+			put(m_Payload, from.data(), count);
+			put(m_Payload, to.data(), count);
+			put(m_Payload, p.edgeIsLoop.data(), count);
+			p.edges.clear();
+			p.edgeIsLoop.clear();
+			break;
+		}
+		case MapBlockType::Hallways:
+			count = (int32)p.hallwayOffsets.size() - 1;
+			if (count <= 0)
+				return;
+			put(m_Payload, p.hallwayOffsets.data(), count + 1);
+			put(m_Payload, p.points.data(), (int32)p.points.size());
+			p.hallwayOffsets.assign(1, 0);
+			p.points.clear();
+			break;
+		default:
+			return;
+		}
+
+		uint64& written = m_Written[slot(type)];
+		writeBlock(type, count, written, m_Payload);
+		written += count;
+	}
+
+	void MapStreamWriter::writeBlock(MapBlockType type, uint32 count, uint64 first, const TArray<uint8>& payload)
+	{
+		MapBlockHeader header = { (uint32)type, count, first, (uint32)payload.Num(), 0 };
+		m_Ar->Serialize(&header, sizeof(header));
+		m_Ar->Serialize(const_cast<uint8*>(payload.GetData()), payload.Num());
+	}
+
+	bool MapStreamWriter::generateTo(const MapParams& params, const FString& path, MapStageTimes* times)
+	{
+		MapStreamWriter writer;
+		if (!writer.open(path))
+			return false;
+
+		MapStageTimes local;
+		MapStageTimes& t = times ? *times : local;
+		double start = FPlatformTime::Seconds();
+		auto lap = [&start](double& slot)
+		{
+			const double now = FPlatformTime::Seconds();
+			slot = now - start;
+			start = now;
+		};
+
+		FRandomStream stream(params.seed);
+		MapArena arena;
+		std::vector<MapRoom> rooms;
+		MapGenerator::spawnRooms(params, stream, rooms);
+		t.spawned = (int32)rooms.size();
+		lap(t.spawn);
+		t.separatePasses = MapGenerator::separateRooms(rooms, 2000, &arena);
+		lap(t.separate);
+		MapGenerator::selectMainRooms(stream, rooms);
+		t.mainRooms = (int32)rooms.size();
+		lap(t.select);
+		t.distancePasses = MapGenerator::distanceRooms(rooms, params.spacing, 2000, &arena);
+		lap(t.distance);
+		for (const MapRoom& r : rooms)
+			writer.addRoom(r);
+
+		GeneratedMap graph;
+		MapGenerator::connectRooms(params, rooms, stream, graph, &t, &arena);
+		t.triangles = (int32)graph.triangles.size();
+		t.edges = (int32)graph.edges.size();
+		for (const auto& tri : graph.triangles)
+			writer.addTriangle(tri);
+		// triangles are the biggest array and nothing after this needs them
+		std::vector<std::array<int32, 3>>().swap(graph.triangles);
+		start = FPlatformTime::Seconds();
+		const std::vector<std::pair<int32, int32>>& edges = graph.edges;
+		const std::vector<uint8>& isLoop = graph.edgeIsLoop;
+		for (size_t i = 0; i < edges.size(); i++)
+			writer.addEdge(edges[i].first, edges[i].second, isLoop[i] != 0);
+
+		t.hallwayPoints = 0;
+		if (params.routeHallways)
+		{
+			std::vector<std::vector<FVector2D>> hallways;
+			MapGenerator::routeHallways(rooms, edges, params.cellSize, hallways);
+			for (auto& line : hallways)
+			{
+				writer.addHallway(line);
+				t.hallwayPoints += (int32)line.size();
+				std::vector<FVector2D>().swap(line);
+			}
+		}
+		lap(t.hallways);
+		t.arenaBytes = (int64)arena.highWater();
+		t.arenaBlocks = arena.blockAllocations();
+
+		return writer.close();
+	}
+
+	MapStreamReader::MapStreamReader()
+	{
+	}
+
+	MapStreamReader::~MapStreamReader()
+	{
+		close();
+	}
+
+	bool MapStreamReader::open(const FString& path)
+	{
+		close();
+		m_Failed = false;
+		m_Ar.Reset(IFileManager::Get().CreateFileReader(*path));
+		if (!m_Ar)
+			return false;
+
+		StreamHeader header = {};
+		m_Ar->Serialize(&header, sizeof(header));
+		if (m_Ar->IsError() || header.magic != MapStreamWriter::Magic || header.version != MapStreamWriter::Version)
+		{
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	void MapStreamReader::close()
+	{
+		if (m_Ar)
+			m_Ar->Close();
+		m_Ar.Reset();
+	}
+
+	bool MapStreamReader::next(MapBlock& block)
+	{
+		if (!m_Ar || m_Failed)
+			return false;
+
+		MapBlockHeader header = {};
+		if (m_Ar->Tell() + (int64)sizeof(header) > m_Ar->TotalSize())
+		{
+			// ended without an End block, the writer did not finish
+			m_Failed = true;
+			return false;
+		}
+		m_Ar->Serialize(&header, sizeof(header));
+		if (m_Ar->IsError() || m_Ar->Tell() + (int64)header.bytes > m_Ar->TotalSize())
+		{
+			m_Failed = true;
+			return false;
+		}
+		m_Payload.SetNumUninitialized(header.bytes, false);
+		m_Ar->Serialize(m_Payload.GetData(), header.bytes);
+
+		block.type = (MapBlockType)header.type;
+		block.first = header.first;
+		// the count comes from the file, every case checks it against the payload before sizing anything
+		Cursor c{ m_Payload };
+		const int32 n = (int32)header.count;
+		c.ok = n >= 0;
+		switch (block.type)
+		{
+		case MapBlockType::Rooms:
+		{
+			if (!c.fits(n, 4 * sizeof(float) + sizeof(int32) + sizeof(uint8)))
+				break;
+			block.rooms.resize(n);
+			std::vector<float> f(n);
+			for (int32 field = 0; field < 4; field++)
+			{
+				c.get(f.data(), n);
+				for (int32 i = 0; c.ok && i < n; i++)
+				{
+					MapRoom& r = block.rooms[i];
+					(field == 0 ? r.center.X : field == 1 ? r.center.Y : field == 2 ? r.extent.X : r.extent.Y) = f[i];
+				}
+			}
+			std::vector<int32> scale(n);
+			std::vector<uint8> flags(n);
+			c.get(scale.data(), n);
+			c.get(flags.data(), n);
+			for (int32 i = 0; c.ok && i < n; i++)
+			{
+				block.rooms[i].scale = scale[i];
+				block.rooms[i].flags = flags[i];
+			}
+			break;
+		}
+		case MapBlockType::Triangles:
+			if (!c.fits(n, sizeof(std::array<int32, 3>)))
+				break;
+			block.triangles.resize(n);
+			c.get(block.triangles.data(), n);
+			break;
+		case MapBlockType::Edges:
+		{
+			if (!c.fits(n, 2 * sizeof(int32) + sizeof(uint8)))
+				break;
+			std::vector<int32> from(n), to(n);
+			c.get(from.data(), n);
+			c.get(to.data(), n);
+			block.edgeIsLoop.resize(n);
+			c.get(block.edgeIsLoop.data(), n);
+			block.edges.resize(n);
+			for (int32 i = 0; c.ok && i < n; i++)
+				block.edges[i] = { from[i], to[i] };
+			break;
+		}
+		case MapBlockType::Hallways:
+			if (!c.fits((int64)n + 1, sizeof(uint32)))
+				break;
+			block.hallwayOffsets.resize(n + 1);
+			c.get(block.hallwayOffsets.data(), n + 1);
+			if (c.fits(block.hallwayOffsets.back(), sizeof(FVector2D)))
+			{
+				const uint32 points = block.hallwayOffsets.back();
+				block.points.resize(points);
+				c.get(block.points.data(), (int32)points);
+				for (int32 i = 0; c.ok && i < n; i++)
+					c.ok = block.hallwayOffsets[i] <= block.hallwayOffsets[i + 1];
+			}
+			break;
+		case MapBlockType::End:
+			c.get(block.totals, 4);
+			m_Failed = !c.ok;
+			return false;
+		default:
+			c.ok = false;
+			break;
+		}
+
+		m_Failed = !c.ok;
+		return c.ok;
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MapGenerator.h"
+#include "Templates/UniquePtr.h"
+
+class FArchive;
+
+namespace Helpers {
+
+	enum class MapBlockType : uint32
+	{
+		Rooms = 1,
+		Triangles,
+		Edges,
+		Hallways,
+		End,		// totals, always the last block
+	};
+
+	struct MapBlockHeader
+	{
+		uint32 type;
+		uint32 count;		// elements in this block
+		uint64 first;		// index of the first element in the whole map
+		uint32 bytes;		// payload after this header
+		uint32 reserved;
+	};
+
+	// One decoded block, reused by the reader so memory stays at one block
+	struct MapBlock
+	{
+		MapBlockType type = MapBlockType::End;
+		uint64 first = 0;
+		std::vector<MapRoom> rooms;
+		std::vector<std::array<int32, 3>> triangles;
+		std::vector<std::pair<int32, int32>> edges;
+		std::vector<uint8> edgeIsLoop;
+		std::vector<uint32> hallwayOffsets;	// count + 1, into points
+		std::vector<FVector2D> points;
+		uint64 totals[4] = {};				// End block: rooms, triangles, edges, hallways
+	};
+
+	// Writes a map as a run of small blocks, each kind buffered on its own and
+	// flushed once BlockElements are in. Stages can hand over their output and
+	// free it right away, the writer never holds more than one block per kind.
+	// Same little endian layout as MapFile inside a block, rooms and edges SoA.
+	class MapStreamWriter {
+
+	public:
+		static const uint32 Magic = 0x42534d50;	// "PMSB"
+		static const uint32 Version = 1;
+		static const int32 BlockElements = 4096;
+
+		MapStreamWriter();
+		~MapStreamWriter();
+
+		bool open(const FString& path);
+		// flushes what is left and writes the End block
+		bool close();
+
+		void addRoom(const MapRoom& room);
+		void addTriangle(const std::array<int32, 3>& tri);
+		void addEdge(int32 from, int32 to, bool loop);
+		void addHallway(const std::vector<FVector2D>& line);
+
+		// runs the pipeline writing each stage as soon as it is done. Only the
+		// triangles are freed early, rooms, edges and routes are needed whole
+		// by the stages after them
+		static bool generateTo(const MapParams& params, const FString& path, MapStageTimes* times = nullptr);
+
+	private:
+		void flush(MapBlockType type);
+		void writeBlock(MapBlockType type, uint32 count, uint64 first, const TArray<uint8>& payload);
+
+		TUniquePtr<FArchive> m_Ar;
+		MapBlock m_Pending;		// one buffer per kind lives in here
+		uint64 m_Written[4] = {};
+		TArray<uint8> m_Payload;
+	};
+
+	// Reads a stream file one block at a time
+	class MapStreamReader {
+
+	public:
+		MapStreamReader();
+		~MapStreamReader();
+
+		bool open(const FString& path);
+		void close();
+
+		// false at the End block or on a broken file, see failed()
+		bool next(MapBlock& block);
+		inline bool failed() const { return m_Failed; }
+
+	private:
+		TUniquePtr<FArchive> m_Ar;
+		TArray<uint8> m_Payload;
+		bool m_Failed = false;
+	};
+}
@@ -0,0 +1,233 @@
+#include "MapVoronoi.h"
+#include "Async/ParallelFor.h"
+#include <algorithm>
+
+namespace Helpers {
+
+	namespace {
+		// bucket rows and columns stop growing past this
+		const int32 MaxBuckets = 1024;
+
+		// corners and, for each corner, what cut the side leaving it: a site or -1 for the bounds
+		struct Cell
+		{
+			std::vector<FVector2D> points;
+			std::vector<int32> sides;
+		};
+
+		// keeps the part of the convex cell where (p - mid) . normal <= 0
+		void clip(Cell& cell, Cell& out, const FVector2D& mid, const FVector2D& normal, int32 side)
+		{
+			out.points.clear();
+			out.sides.clear();
+			const int32 n = (int32)cell.points.size();
+			for (int32 k = 0; k < n; k++)
+			{
+				const FVector2D& a = cell.points[k];
+				const FVector2D& b = cell.points[(k + 1) % n];
+				const float da = FVector2D::DotProduct(a - mid, normal);
+				const float db = FVector2D::DotProduct(b - mid, normal);
+				if (da <= 0.f)
+				{
+					out.points.push_back(a);
+					out.sides.push_back(cell.sides[k]);
+				}
+				if ((da <= 0.f) != (db <= 0.f))
+				{
+					out.points.push_back(a + (b - a) * (da / (da - db)));
+					out.sides.push_back(da <= 0.f ? side : cell.sides[k]);
+				}
+			}
+			std::swap(cell, out);
+		}
+	}
+
+	void MapVoronoi::clear()
+	{
+		m_Sites.clear();
+		m_CellOffsets.assign(1, 0);
+		m_CellPoints.clear();
+		m_Adjacency = RoomGraph();
+		m_Columns = 0;
+		m_Rows = 0;
+		m_BucketOffsets.clear();
+		m_BucketCells.clear();
+	}
+
+	void MapVoronoi::build(const std::vector<FVector2D>& sites, const std::vector<std::array<int32, 3>>& triangles, const FBox2D& bounds)
+	{
+		clear();
+		m_Sites = sites;
+		m_Bounds = bounds;
+		const int32 n = (int32)sites.size();
+
+		// sites on top of an earlier one get no cell
+		std::vector<int32> order(n);
+		for (int32 i = 0; i < n; i++)
+		{
+			order[i] = i;
+		}
+		std::sort(order.begin(), order.end(), [&](int32 a, int32 b)
+		{
+			if (sites[a].X != sites[b].X)
+				return sites[a].X < sites[b].X;
+			if (sites[a].Y != sites[b].Y)
+				return sites[a].Y < sites[b].Y;
+			return a < b;
+		});
+		// the first one takes over the Delaunay edges of the rest
+		std::vector<int32> first(n);
+		for (int32 i = 0; i < n; i++)
+		{
+			first[order[i]] = i > 0 && sites[order[i]] == sites[order[i - 1]] ? first[order[i - 1]] : order[i];
+		}
+
+		std::vector<std::pair<int32, int32>> pairs;
+		pairs.reserve(triangles.size() * 3);
+		for (const auto& t : triangles)
+		{
+			pairs.push_back({ first[t[0]], first[t[1]] });
+			pairs.push_back({ first[t[1]], first[t[2]] });
+			pairs.push_back({ first[t[2]], first[t[0]] });
+		}
+		if (triangles.empty())
+		{
+			for (int32 i = 0; i < n; i++)
+			{
+				for (int32 j = i + 1; j < n; j++)
+				{
+					pairs.push_back({ first[i], first[j] });
+				}
+			}
+		}
+		RoomGraph delaunay;
+		delaunay.build(n, pairs);
+
+		// every cell on its own, only reading the sites
+		std::vector<Cell> cells(n);
+		ParallelFor(n, [&](int32 i)
+		{
+			Cell& cell = cells[i];
+			if (first[i] != i)
+				return;
+			cell.points = { bounds.Min, FVector2D(bounds.Max.X, bounds.Min.Y), bounds.Max, FVector2D(bounds.Min.X, bounds.Max.Y) };
+			cell.sides.assign(4, INDEX_NONE);
+			Cell scratch;
+			for (const int32* j = delaunay.begin(i); j != delaunay.end(i) && !cell.points.empty(); ++j)
+			{
+				clip(cell, scratch, (sites[i] + sites[*j]) * 0.5f, sites[*j] - sites[i], *j);
+			}
+		});
+
+		std::vector<std::pair<int32, int32>> shared;
+		m_CellOffsets.resize(n + 1);
+		for (int32 i = 0; i < n; i++)
+		{
+			m_CellPoints.insert(m_CellPoints.end(), cells[i].points.begin(), cells[i].points.end());
+			m_CellOffsets[i + 1] = (int32)m_CellPoints.size();
+			for (int32 side : cells[i].sides)
+			{
+				if (side != INDEX_NONE)
+					shared.push_back({ i, side });
+			}
+		}
+		m_Adjacency.build(n, shared);
+
+		// about one site per bucket
+		const FVector2D size = bounds.GetSize();
+		const float side = FMath::Sqrt(FMath::Max(size.X * size.Y, 1.f) / FMath::Max(n, 1));
+		m_Columns = FMath::Clamp(FMath::CeilToInt(size.X / side), 1, MaxBuckets);
+		m_Rows = FMath::Clamp(FMath::CeilToInt(size.Y / side), 1, MaxBuckets);
+		m_BucketSize = FVector2D(FMath::Max(size.X / m_Columns, KINDA_SMALL_NUMBER), FMath::Max(size.Y / m_Rows, KINDA_SMALL_NUMBER));
+
+		// counted first, then filled in place
+		auto bucketRange = [&](int32 i, FIntPoint& a, FIntPoint& b)
+		{
+			FBox2D box(ForceInit);
+			for (const FVector2D* p = cellBegin(i); p != cellEnd(i); ++p)
+			{
+				box += *p;
+			}
+			// rounding in the cuts never drops a bucket
+			box = box.ExpandBy(FMath::Min(m_BucketSize.X, m_BucketSize.Y) * 0.01f);
+			a.X = FMath::Clamp(FMath::FloorToInt((box.Min.X - bounds.Min.X) / m_BucketSize.X), 0, m_Columns - 1);
+			a.Y = FMath::Clamp(FMath::FloorToInt((box.Min.Y - bounds.Min.Y) / m_BucketSize.Y), 0, m_Rows - 1);
+			b.X = FMath::Clamp(FMath::FloorToInt((box.Max.X - bounds.Min.X) / m_BucketSize.X), 0, m_Columns - 1);
+			b.Y = FMath::Clamp(FMath::FloorToInt((box.Max.Y - bounds.Min.Y) / m_BucketSize.Y), 0, m_Rows - 1);
+		};
+		m_BucketOffsets.assign(m_Columns * m_Rows + 1, 0);
+		for (int32 pass = 0; pass < 2; pass++)
+		{
+			if (pass == 1)
+			{
+				for (int32 b = 0; b < m_Columns * m_Rows; b++)
+				{
+					m_BucketOffsets[b + 1] += m_BucketOffsets[b];
+				}
+				m_BucketCells.resize(m_BucketOffsets.back());
+			}
+			std::vector<int32> fill(m_BucketOffsets.begin(), m_BucketOffsets.end() - 1);
+			for (int32 i = 0; i < n; i++)
+			{
+				if (cellSize(i) == 0)
+					continue;
+				FIntPoint a, b;
+				bucketRange(i, a, b);
+				for (int32 y = a.Y; y <= b.Y; y++)
+				{
+					for (int32 x = a.X; x <= b.X; x++)
+					{
+						if (pass == 0)
+							m_BucketOffsets[y * m_Columns + x + 1]++;
+						else
+							m_BucketCells[fill[y * m_Columns + x]++] = i;
+					}
+				}
+			}
+		}
+	}
+
+	float MapVoronoi::cellArea(int32 i) const
+	{
+		float area = 0.f;
+		const int32 n = cellSize(i);
+		const FVector2D* p = cellBegin(i);
+		for (int32 k = 0; k < n; k++)
+		{
+			area += FVector2D::CrossProduct(p[k], p[(k + 1) % n]);
+		}
+		return area * 0.5f;
+	}
+
+	int32 MapVoronoi::findCell(const FVector2D& p) const
+	{
+		if (m_BucketOffsets.empty() || p.X < m_Bounds.Min.X || p.Y < m_Bounds.Min.Y || p.X > m_Bounds.Max.X || p.Y > m_Bounds.Max.Y)
+			return INDEX_NONE;
+
+		const int32 x = FMath::Min(FMath::FloorToInt((p.X - m_Bounds.Min.X) / m_BucketSize.X), m_Columns - 1);
+		const int32 y = FMath::Min(FMath::FloorToInt((p.Y - m_Bounds.Min.Y) / m_BucketSize.Y), m_Rows - 1);
+		const int32 b = y * m_Columns + x;
+
+		// a cell only ever grows by missing neighbours, so the nearest site is always a candidate
+		int32 best = INDEX_NONE;
+		float bestDist = MAX_flt;
+		for (int32 k = m_BucketOffsets[b]; k < m_BucketOffsets[b + 1]; k++)
+		{
+			const int32 c = m_BucketCells[k];
+			const float d = FVector2D::DistSquared(p, m_Sites[c]);
+			if (d < bestDist)
+			{
+				bestDist = d;
+				best = c;
+			}
+		}
+		return best;
+	}
+
+	size_t MapVoronoi::memoryBytes() const
+	{
+		return m_Sites.size() * sizeof(FVector2D) + m_CellOffsets.size() * sizeof(int32) + m_CellPoints.size() * sizeof(FVector2D)
+			+ (m_Adjacency.offsets.size() + m_Adjacency.adjacency.size()) * sizeof(int32)
+			+ (m_BucketOffsets.size() + m_BucketCells.size()) * sizeof(int32);
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GraphMetrics.h"
+#include <vector>
+#include <array>
+
+namespace Helpers {
+
+	// Voronoi regions of a set of sites, read off their Delaunay triangulation.
+	// Each cell starts as the bounds and is cut by the bisector with every
+	// Delaunay neighbour, so the work is linear in the triangles. Cells are
+	// convex, counter clockwise and clipped to the bounds. Two cells are
+	// adjacent when they share a side. Point lookup goes through a grid of
+	// buckets holding the cells that reach into each bucket.
+	class MapVoronoi {
+
+	public:
+		// 'triangles' index 'sites', every pair is taken as neighbours when there are none
+		void build(const std::vector<FVector2D>& sites, const std::vector<std::array<int32, 3>>& triangles, const FBox2D& bounds);
+		void clear();
+
+		inline int32 num() const { return (int32)m_Sites.size(); }
+		inline const FBox2D& bounds() const { return m_Bounds; }
+		inline const FVector2D& site(int32 i) const { return m_Sites[i]; }
+
+		// corners of cell i, empty for a duplicate site
+		inline int32 cellSize(int32 i) const { return m_CellOffsets[i + 1] - m_CellOffsets[i]; }
+		inline const FVector2D* cellBegin(int32 i) const { return m_CellPoints.data() + m_CellOffsets[i]; }
+		inline const FVector2D* cellEnd(int32 i) const { return m_CellPoints.data() + m_CellOffsets[i + 1]; }
+		float cellArea(int32 i) const;
+
+		// cells sharing a side, usable with RoomBfs
+		inline const RoomGraph& adjacency() const { return m_Adjacency; }
+
+		// cell holding the point, the nearest site. INDEX_NONE outside the bounds
+		int32 findCell(const FVector2D& p) const;
+
+		size_t memoryBytes() const;
+
+	private:
+		std::vector<FVector2D> m_Sites;
+		FBox2D m_Bounds;
+		std::vector<int32> m_CellOffsets;
+		std::vector<FVector2D> m_CellPoints;
+		RoomGraph m_Adjacency;
+
+		// lookup buckets in compressed rows
+		int32 m_Columns = 0;
+		int32 m_Rows = 0;
+		FVector2D m_BucketSize;
+		std::vector<int32> m_BucketOffsets;
+		std::vector<int32> m_BucketCells;
+	};
+}
@@ -0,0 +1,287 @@
+#include "ProximityGraph.h"
+#include "GraphMetrics.h"
+#include "MapStats.h"
+#include "../ExactFloat.h"
+#include <algorithm>
+#include <queue>
+#include <functional>
+
+MAP_EXACT_FLOAT
+
+namespace Helpers {
+
+	namespace {
+		struct Roots
+		{
+			std::vector<int32> parent;
+
+			explicit Roots(int32 n) : parent(n)
+			{
+				for (int32 i = 0; i < n; i++)
+				{
+					parent[i] = i;
+				}
+			}
+			int32 find(int32 x)
+			{
+				while (parent[x] != x)
+				{
+					parent[x] = parent[parent[x]];
+					x = parent[x];
+				}
+				return x;
+			}
+			// true if a and b were apart
+			bool join(int32 a, int32 b)
+			{
+				a = find(a);
+				b = find(b);
+				if (a == b)
+					return false;
+				parent[a] = b;
+				return true;
+			}
+		};
+
+		inline int64 sideKey(int32 a, int32 b)
+		{
+			return ((int64)FMath::Min(a, b) << 32) | (uint32)FMath::Max(a, b);
+		}
+
+		// squared distance from 'c' to the segment pq
+		inline float segmentDistSquared(const FVector2D& p, const FVector2D& q, const FVector2D& c)
+		{
+			const FVector2D d = q - p;
+			const float len2 = FVector2D::DotProduct(d, d);
+			const float t = len2 > 0.f ? FMath::Clamp(FVector2D::DotProduct(c - p, d) / len2, 0.f, 1.f) : 0.f;
+			return FVector2D::DistSquared(p + d * t, c);
+		}
+
+		inline float length(const std::vector<MapRoom>& rooms, const std::pair<int32, int32>& e)
+		{
+			return FVector2D::Distance(rooms[e.first].center, rooms[e.second].center);
+		}
+	}
+
+	void ProximityGraph::delaunayEdges(const std::vector<MapRoom>& rooms, const std::vector<std::array<int32, 3>>& triangles,
+		std::vector<std::pair<int32, int32>>& edges)
+	{
+		edges.clear();
+		edges.reserve(triangles.size() * 3);
+		for (const auto& t : triangles)
+		{
+			for (int32 k = 0; k < 3; k++)
+			{
+				const int32 a = t[k];
+				const int32 b = t[(k + 1) % 3];
+				edges.push_back({ FMath::Min(a, b), FMath::Max(a, b) });
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+		edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+		if (edges.empty() && rooms.size() == 2)
+			edges.push_back({ 0, 1 });
+
+		// ties by index so the order never depends on the sort
+		std::vector<std::pair<float, std::pair<int32, int32>>> sorted(edges.size());
+		for (size_t i = 0; i < edges.size(); i++)
+		{
+			sorted[i] = { length(rooms, edges[i]), edges[i] };
+		}
+		std::sort(sorted.begin(), sorted.end());
+		for (size_t i = 0; i < edges.size(); i++)
+		{
+			edges[i] = sorted[i].second;
+		}
+	}
+
+	void ProximityGraph::betaSkeleton(const std::vector<MapRoom>& rooms, const std::vector<std::array<int32, 3>>& triangles, float beta,
+		std::vector<std::pair<int32, int32>>& edges, std::vector<uint8>& isLoop)
+	{
+		beta = FMath::Clamp(beta, 1.f, 2.f);
+		std::vector<std::pair<int32, int32>> candidates;
+		delaunayEdges(rooms, triangles, candidates);
+
+		// every triangle side with the triangle across it
+		const int32 count = (int32)triangles.size();
+		std::vector<std::pair<int64, int32>> sides;
+		sides.reserve(count * 3);
+		for (int32 t = 0; t < count; t++)
+		{
+			for (int32 k = 0; k < 3; k++)
+			{
+				sides.push_back({ sideKey(triangles[t][k], triangles[t][(k + 1) % 3]), t * 3 + k });
+			}
+		}
+		std::sort(sides.begin(), sides.end());
+		std::vector<int32> across(count * 3, INDEX_NONE);
+		for (size_t i = 0; i + 1 < sides.size(); i++)
+		{
+			if (sides[i].first == sides[i + 1].first)
+			{
+				across[sides[i].second] = sides[i + 1].second / 3;
+				across[sides[i + 1].second] = sides[i].second / 3;
+			}
+		}
+		auto opposite = [&](int32 t, int32 p, int32 q)
+		{
+			const auto& tri = triangles[t];
+			return tri[0] != p && tri[0] != q ? tri[0] : (tri[1] != p && tri[1] != q ? tri[1] : tri[2]);
+		};
+
+		std::vector<int32> seen(count, INDEX_NONE);
+		std::vector<int32> open;
+		edges.clear();
+		for (int32 i = 0; i < (int32)candidates.size(); i++)
+		{
+			const int32 a = candidates[i].first;
+			const int32 b = candidates[i].second;
+			// the lune is where the two discs of radius beta * |ab| / 2 around these centres meet
+			const FVector2D& pa = rooms[a].center;
+			const FVector2D& pb = rooms[b].center;
+			const float r2 = FVector2D::DistSquared(pa, pb) * beta * beta * 0.25f;
+			const FVector2D ca = pa + (pb - pa) * (beta * 0.5f);
+			const FVector2D cb = pb + (pa - pb) * (beta * 0.5f);
+			auto inLune = [&](int32 c)
+			{
+				return FVector2D::DistSquared(rooms[c].center, ca) < r2 && FVector2D::DistSquared(rooms[c].center, cb) < r2;
+			};
+
+			// the rooms opposite ab decide the Gabriel graph on their own, and every
+			// lune holds the Gabriel disc, so edges that are not Gabriel stop here
+			bool empty = true;
+			open.clear();
+			auto side = std::lower_bound(sides.begin(), sides.end(), std::pair<int64, int32>(sideKey(a, b), 0));
+			for (; side != sides.end() && side->first == sideKey(a, b) && empty; ++side)
+			{
+				const int32 t = side->second / 3;
+				seen[t] = i;
+				open.push_back(t);
+				empty = !inLune(opposite(t, a, b));
+			}
+
+			// past that, the lune is convex, so a room in it is the corner of a triangle
+			// reached from ab over sides that cut into the lune. Only the triangles the
+			// lune overlaps are visited, not every room around the edge
+			while (beta > 1.f && empty && !open.empty())
+			{
+				const int32 t = open.back();
+				open.pop_back();
+				for (int32 k = 0; k < 3 && empty; k++)
+				{
+					const int32 next = across[t * 3 + k];
+					if (next == INDEX_NONE || seen[next] == i)
+						continue;
+					const int32 p = triangles[t][k];
+					const int32 q = triangles[t][(k + 1) % 3];
+					if (segmentDistSquared(rooms[p].center, rooms[q].center, ca) >= r2 || segmentDistSquared(rooms[p].center, rooms[q].center, cb) >= r2)
+						continue;
+					seen[next] = i;
+					open.push_back(next);
+					empty = !inLune(opposite(next, p, q));
+				}
+			}
+			if (empty)
+				edges.push_back(candidates[i]);
+		}
+
+		// shortest first, so an edge joining two parts is an MST edge
+		Roots roots((int32)rooms.size());
+		isLoop.resize(edges.size());
+		for (size_t i = 0; i < edges.size(); i++)
+		{
+			isLoop[i] = roots.join(edges[i].first, edges[i].second) ? 0 : 1;
+		}
+	}
+
+	void ProximityGraph::spanner(const std::vector<MapRoom>& rooms, const std::vector<std::array<int32, 3>>& triangles, float stretch,
+		std::vector<std::pair<int32, int32>>& edges, std::vector<uint8>& isLoop)
+	{
+		stretch = FMath::Max(stretch, 1.f);
+		std::vector<std::pair<int32, int32>> candidates;
+		delaunayEdges(rooms, triangles, candidates);
+
+		const int32 n = (int32)rooms.size();
+		std::vector<std::vector<std::pair<int32, float>>> graph(n);
+		std::vector<float> dist(n, MAX_flt);
+		std::vector<int32> touched;
+		using Entry = std::pair<float, int32>;
+		std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+
+		// Dijkstra from 'a' that gives up past 'limit'
+		auto within = [&](int32 a, int32 b, float limit)
+		{
+			for (int32 t : touched)
+			{
+				dist[t] = MAX_flt;
+			}
+			touched.clear();
+			open = decltype(open)();
+			dist[a] = 0.f;
+			touched.push_back(a);
+			open.push({ 0.f, a });
+			while (!open.empty())
+			{
+				const Entry top = open.top();
+				open.pop();
+				if (top.second == b)
+					return true;
+				if (top.first > dist[top.second])
+					continue;
+				for (const auto& next : graph[top.second])
+				{
+					const float d = top.first + next.second;
+					if (d <= limit && d < dist[next.first])
+					{
+						if (dist[next.first] == MAX_flt)
+							touched.push_back(next.first);
+						dist[next.first] = d;
+						open.push({ d, next.first });
+					}
+				}
+			}
+			return false;
+		};
+
+		edges.clear();
+		isLoop.clear();
+		Roots roots(n);
+		for (const auto& e : candidates)
+		{
+			const float len = length(rooms, e);
+			const bool apart = roots.find(e.first) != roots.find(e.second);
+			if (!apart && within(e.first, e.second, len * stretch))
+				continue;
+			roots.join(e.first, e.second);
+			graph[e.first].push_back({ e.second, len });
+			graph[e.second].push_back({ e.first, len });
+			edges.push_back(e);
+			isLoop.push_back(apart ? 0 : 1);
+		}
+	}
+
+	void ProximityGraph::build(const MapParams& params, const std::vector<MapRoom>& rooms, const std::vector<std::array<int32, 3>>& triangles,
+		std::vector<std::pair<int32, int32>>& edges, std::vector<uint8>& isLoop)
+	{
+		MAP_SCOPE(STAT_MapSpanningTree);
+		switch (params.graphMode)
+		{
+		case MapGraphMode::Gabriel:
+			betaSkeleton(rooms, triangles, 1.f, edges, isLoop);
+			break;
+		case MapGraphMode::RelativeNeighbourhood:
+			betaSkeleton(rooms, triangles, 2.f, edges, isLoop);
+			break;
+		case MapGraphMode::BetaSkeleton:
+			betaSkeleton(rooms, triangles, params.beta, edges, isLoop);
+			break;
+		case MapGraphMode::Spanner:
+			spanner(rooms, triangles, params.stretch, edges, isLoop);
+			break;
+		default:
+			edges.clear();
+			isLoop.clear();
+			break;
+		}
+	}
+}
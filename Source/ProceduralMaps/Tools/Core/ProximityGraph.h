@@ -0,0 +1,36 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MapGenerator.h"
+
+namespace Helpers {
+
+	// Hallway graphs read straight off the Delaunay edges, in place of the MST
+	// plus random loops. A beta skeleton keeps an edge when no other room sits
+	// in its lune, beta 1 is the Gabriel graph and beta 2 the relative
+	// neighbourhood graph. The rooms opposite the edge in its two Delaunay
+	// triangles settle the Gabriel test, wider lunes flood on to the triangles
+	// they overlap, so an edge costs the triangles its lune touches. The greedy
+	// spanner takes edges shortest first and skips one when the graph so far
+	// already has a path at most 'stretch' times its length.
+	// Every mode holds the MST, edges outside it come back flagged as loops.
+	// Edges are sorted shortest first.
+	class ProximityGraph {
+
+	public:
+		// 'params.graphMode' picks the graph, Spanning is MapGenerator::spanningTree's job
+		static void build(const MapParams& params, const std::vector<MapRoom>& rooms, const std::vector<std::array<int32, 3>>& triangles,
+			std::vector<std::pair<int32, int32>>& edges, std::vector<uint8>& isLoop);
+
+		// 'beta' is clamped to 1..2, past 2 the graph can fall apart
+		static void betaSkeleton(const std::vector<MapRoom>& rooms, const std::vector<std::array<int32, 3>>& triangles, float beta,
+			std::vector<std::pair<int32, int32>>& edges, std::vector<uint8>& isLoop);
+		// 'stretch' >= 1, path lengths are measured over the graph being built
+		static void spanner(const std::vector<MapRoom>& rooms, const std::vector<std::array<int32, 3>>& triangles, float stretch,
+			std::vector<std::pair<int32, int32>>& edges, std::vector<uint8>& isLoop);
+
+		// every triangle side once, shortest first
+		static void delaunayEdges(const std::vector<MapRoom>& rooms, const std::vector<std::array<int32, 3>>& triangles,
+			std::vector<std::pair<int32, int32>>& edges);
+	};
+}
@@ -0,0 +1,101 @@
+#include "RoomContent.h"
+#include "ChunkGenerator.h"
+#include "MapStats.h"
+#include "Async/ParallelFor.h"
+#include "Math/RandomStream.h"
+
+namespace Helpers {
+
+	namespace {
+		// rooms per task, most rooms only take a few dozen tries
+		const int32 RoomsPerTask = 16;
+		// density is per cell of this size
+		const float DensityCell = 100.f * 100.f;
+	}
+
+	uint32 RoomContentBuilder::roomSeed(int32 seed, int32 id)
+	{
+		return ChunkGenerator::hash((uint32)seed, (uint32)id, 0, 0x524d4354);
+	}
+
+	void RoomContentBuilder::populateRoom(const std::vector<ContentRule>& rules, const FBox2D& room, int32 id, uint8 role, int32 seed,
+		std::vector<ContentItem>& items)
+	{
+		FRandomStream stream((int32)roomSeed(seed, id));
+		const size_t first = items.size();
+		for (int32 r = 0; r < (int32)rules.size(); r++)
+		{
+			const ContentRule& rule = rules[r];
+			// a stream per rule, so a rule that places more or fewer items leaves the rolls of the next ones alone
+			FRandomStream ruleStream((int32)stream.GetUnsignedInt());
+			if (!(rule.roles & role))
+				continue;
+
+			const FVector2D lo = room.Min + FVector2D(rule.margin, rule.margin);
+			const FVector2D hi = room.Max - FVector2D(rule.margin, rule.margin);
+			if (lo.X > hi.X || lo.Y > hi.Y)
+				continue;
+
+			const float floor = (hi.X - lo.X) * (hi.Y - lo.Y) / DensityCell * rule.density;
+			const int32 count = FMath::Clamp(FMath::FloorToInt(floor + ruleStream.FRand()), rule.minCount, FMath::Max(rule.maxCount, rule.minCount));
+			const float spacing2 = rule.spacing * rule.spacing;
+			for (int32 k = 0; k < count; k++)
+			{
+				for (int32 t = 0; t < TriesPerItem; t++)
+				{
+					const FVector2D p(ruleStream.FRandRange(lo.X, hi.X), ruleStream.FRandRange(lo.Y, hi.Y));
+					bool free = true;
+					for (size_t i = first; i < items.size() && free; i++)
+					{
+						free = FVector2D::DistSquared(p, items[i].position) >= spacing2;
+					}
+					if (!free)
+						continue;
+
+					ContentItem item;
+					item.rule = r;
+					item.room = id;
+					item.position = p;
+					item.yaw = ruleStream.FRandRange(0.f, 360.f);
+					item.scale = ruleStream.FRandRange(rule.minScale, FMath::Max(rule.maxScale, rule.minScale));
+					items.push_back(item);
+					break;
+				}
+			}
+		}
+	}
+
+	void RoomContentBuilder::populate(const std::vector<ContentRule>& rules, const std::vector<FBox2D>& rooms, const std::vector<int32>& ids,
+		const std::vector<uint8>& roles, int32 seed, RoomContent& out)
+	{
+		MAP_SCOPE(STAT_MapContent);
+		const int32 n = (int32)rooms.size();
+		const int32 tasks = FMath::DivideAndRoundUp(n, RoomsPerTask);
+
+		// each task fills its own list, joined in room order after
+		std::vector<std::vector<ContentItem>> found(tasks);
+		std::vector<int32> counts(n, 0);
+		ParallelFor(tasks, [&](int32 t)
+		{
+			std::vector<ContentItem>& items = found[t];
+			for (int32 i = t * RoomsPerTask; i < FMath::Min(n, (t + 1) * RoomsPerTask); i++)
+			{
+				const size_t before = items.size();
+				populateRoom(rules, rooms[i], ids[i], roles[i], seed, items);
+				counts[i] = (int32)(items.size() - before);
+			}
+		});
+
+		out.offsets.assign(n + 1, 0);
+		for (int32 i = 0; i < n; i++)
+		{
+			out.offsets[i + 1] = out.offsets[i] + counts[i];
+		}
+		out.items.clear();
+		out.items.reserve(out.offsets[n]);
+		for (const auto& items : found)
+		{
+			out.items.insert(out.items.end(), items.begin(), items.end());
+		}
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <vector>
+
+namespace Helpers {
+
+	// what a room is to the game, rules pick rooms by these bits
+	enum ContentRoomRole : uint8
+	{
+		Content_Normal = 1,
+		Content_Start = 2,
+		Content_Boss = 4,
+		Content_Treasure = 8,
+		Content_AnyRoom = 15,
+	};
+
+	// one kind of prop, enemy or pickup
+	struct ContentRule
+	{
+		float density = 0.f;		// items per 100x100 of floor, rounded up or down by chance
+		int32 minCount = 0;
+		int32 maxCount = 8;
+		float margin = 50.f;		// kept free along the room's walls
+		float spacing = 100.f;		// min distance to anything already placed in the room
+		float minScale = 1.f;
+		float maxScale = 1.f;
+		uint8 roles = Content_AnyRoom;
+	};
+
+	struct ContentItem
+	{
+		int32 rule = 0;
+		int32 room = 0;		// id as given to populate
+		FVector2D position;
+		float yaw = 0.f;	// degrees
+		float scale = 1.f;
+	};
+
+	// items of every room in compressed rows, the items of the i-th room given to
+	// populate are items[offsets[i] .. offsets[i + 1]), in rule order
+	struct RoomContent
+	{
+		std::vector<int32> offsets;
+		std::vector<ContentItem> items;
+	};
+
+	// Decides what goes in each room. Every room draws from a stream seeded
+	// by the map seed and its id only, so a room gets the same contents no
+	// matter which other rooms there are, in what order, or on which thread
+	// it runs. Rooms are done in parallel. Items are placed by trying random
+	// spots that keep 'spacing' to what is already there, a rule that runs
+	// out of tries places fewer.
+	class RoomContentBuilder {
+
+	public:
+		static const int32 TriesPerItem = 16;
+
+		// 'ids' and 'roles' line up with 'rooms'
+		static void populate(const std::vector<ContentRule>& rules, const std::vector<FBox2D>& rooms, const std::vector<int32>& ids,
+			const std::vector<uint8>& roles, int32 seed, RoomContent& out);
+
+		// one room, appends to 'items'
+		static void populateRoom(const std::vector<ContentRule>& rules, const FBox2D& room, int32 id, uint8 role, int32 seed,
+			std::vector<ContentItem>& items);
+
+		static uint32 roomSeed(int32 seed, int32 id);
+	};
+}
@@ -0,0 +1,80 @@
+#include "RoomStore.h"
+
+namespace Helpers {
+
+	RoomId RoomStore::add(const FVector2D& center, const FVector2D& extent, int32 scale, uint8 flags)
+	{
+		const RoomId id = num();
+		m_X.push_back(center.X);
+		m_Y.push_back(center.Y);
+		m_HalfX.push_back(extent.X);
+		m_HalfY.push_back(extent.Y);
+		m_Scale.push_back(scale);
+		m_Flags.push_back(flags);
+		return id;
+	}
+
+	void RoomStore::clear()
+	{
+		m_X.clear();
+		m_Y.clear();
+		m_HalfX.clear();
+		m_HalfY.clear();
+		m_Scale.clear();
+		m_Flags.clear();
+	}
+
+	void RoomStore::reserve(int32 count)
+	{
+		m_X.reserve(count);
+		m_Y.reserve(count);
+		m_HalfX.reserve(count);
+		m_HalfY.reserve(count);
+		m_Scale.reserve(count);
+		m_Flags.reserve(count);
+	}
+
+	void RoomStore::select(uint8 flags, uint8 without, std::vector<RoomId>& ids) const
+	{
+		ids.clear();
+		for (RoomId id = 0; id < num(); id++)
+		{
+			if ((m_Flags[id] & flags) == flags && (m_Flags[id] & without) == 0)
+				ids.push_back(id);
+		}
+	}
+
+	void RoomStore::gather(const std::vector<RoomId>& ids, std::vector<MapRoom>& out) const
+	{
+		out.resize(ids.size());
+		for (size_t i = 0; i < ids.size(); i++)
+		{
+			const RoomId id = ids[i];
+			MapRoom& r = out[i];
+			r.center = center(id);
+			r.extent = extent(id);
+			r.scale = m_Scale[id];
+			r.flags = m_Flags[id];
+		}
+	}
+
+	void RoomStore::assign(const std::vector<MapRoom>& rooms)
+	{
+		clear();
+		reserve((int32)rooms.size());
+		for (const MapRoom& r : rooms)
+		{
+			add(r.center, r.extent, r.scale, r.flags);
+		}
+	}
+
+	void RoomSubset::build(const RoomStore& store, const std::vector<RoomId>& subset)
+	{
+		ids = subset;
+		slots.assign(store.num(), INDEX_NONE);
+		for (int32 i = 0; i < (int32)ids.size(); i++)
+		{
+			slots[ids[i]] = i;
+		}
+	}
+}
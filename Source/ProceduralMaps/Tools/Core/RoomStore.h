@@ -0,0 +1,66 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MapGenerator.h"
+#include <vector>
+
+namespace Helpers {
+
+	// index into a RoomStore, handed out in order and never reused
+	using RoomId = int32;
+
+	// Rooms as parallel arrays, one slot per id. A room is never removed,
+	// dropping it sets Room_Removed so every id handed out stays valid and
+	// anything indexed by id (actors, graph edges) needs no lookups.
+	class RoomStore {
+
+	public:
+		RoomId add(const FVector2D& center, const FVector2D& extent, int32 scale, uint8 flags = 0);
+		void clear();
+		void reserve(int32 count);
+
+		inline int32 num() const { return (int32)m_X.size(); }
+		inline bool isValid(RoomId id) const { return id >= 0 && id < num(); }
+
+		inline FVector2D center(RoomId id) const { return FVector2D(m_X[id], m_Y[id]); }
+		inline FVector2D extent(RoomId id) const { return FVector2D(m_HalfX[id], m_HalfY[id]); }
+		inline FBox2D box(RoomId id) const { return FBox2D(center(id) - extent(id), center(id) + extent(id)); }
+		inline int32 scale(RoomId id) const { return m_Scale[id]; }
+		inline uint8 flags(RoomId id) const { return m_Flags[id]; }
+		inline bool has(RoomId id, uint8 flag) const { return (m_Flags[id] & flag) != 0; }
+
+		inline void setCenter(RoomId id, const FVector2D& c) { m_X[id] = c.X; m_Y[id] = c.Y; }
+		inline void setFlag(RoomId id, uint8 flag, bool on = true) { m_Flags[id] = on ? (m_Flags[id] | flag) : (m_Flags[id] & ~flag); }
+
+		// ids with every bit of 'flags' and none of 'without', in id order
+		void select(uint8 flags, uint8 without, std::vector<RoomId>& ids) const;
+
+		// the rooms of 'ids' in the layout the MapGenerator stages take, out[i] is ids[i]
+		void gather(const std::vector<RoomId>& ids, std::vector<MapRoom>& out) const;
+		// replaces everything, the id of a room is its index in 'rooms'
+		void assign(const std::vector<MapRoom>& rooms);
+
+		// columns for loops over every room
+		inline const float* xs() const { return m_X.data(); }
+		inline const float* ys() const { return m_Y.data(); }
+
+	private:
+		std::vector<float> m_X;
+		std::vector<float> m_Y;
+		std::vector<float> m_HalfX;
+		std::vector<float> m_HalfY;
+		std::vector<int32> m_Scale;
+		std::vector<uint8> m_Flags;
+	};
+
+	// Maps results in store ids to the 0..n-1 slots of a gathered subset and
+	// back, for stages that want dense indices.
+	struct RoomSubset
+	{
+		std::vector<RoomId> ids;	// slot -> id
+		std::vector<int32> slots;	// id -> slot, INDEX_NONE when not in the subset
+
+		void build(const RoomStore& store, const std::vector<RoomId>& subset);
+		inline int32 slot(RoomId id) const { return id >= 0 && id < (int32)slots.size() ? slots[id] : INDEX_NONE; }
+	};
+}
@@ -0,0 +1,378 @@
+#include "CorridorRouter.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformMisc.h"
+#include "../ExactFloat.h"
+#include "../MapMemory.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+
+MAP_EXACT_FLOAT
+
+namespace Helpers {
+
+	namespace {
+		const int32 DirX[4] = { 1, -1, 0, 0 };
+		const int32 DirY[4] = { 0, 0, 1, -1 };
+		const int32 NoDir = 4;
+		// probes are short, wall stops keep the search complete without them
+		const int32 ProbeLength = 16;
+
+		inline bool isHorizontal(int32 dir) { return dir < 2; }
+		inline int32 opposite(int32 dir) { return dir ^ 1; }
+
+		inline bool inRect(const FIntRect& r, int32 x, int32 y)
+		{
+			return x >= r.Min.X && x <= r.Max.X && y >= r.Min.Y && y <= r.Max.Y;
+		}
+
+		struct Node
+		{
+			float f;
+			float g;
+			FIntPoint cell;
+			int32 dir;
+			bool operator>(const Node& o) const { return f > o.f; }
+		};
+	}
+
+	// open list and visited nodes, cleared for every route. Cleared containers
+	// keep their capacity and the pool keeps freed nodes, so after the first
+	// few routes a worker stops allocating
+	struct CorridorRouter::Scratch
+	{
+		MapPool pool;
+		MapVector<Node> open{ &pool };	// binary heap, smallest f first
+		MapHashMap<uint64, float> best{ &pool };
+		MapHashMap<uint64, uint64> parent{ &pool };
+		std::vector<FIntPoint> cells;
+
+		void clear()
+		{
+			open.clear();
+			best.clear();
+			parent.clear();
+			cells.clear();
+		}
+	};
+
+	// per search state shared by the jump calls
+	struct CorridorRouter::Query
+	{
+		const FIntRect* a;
+		const FIntRect* b;
+		FIntPoint goal;
+
+		const OccupancyGrid* rooms;
+		const OccupancyGrid* carved;
+
+		// rooms block everything except the two rooms being connected
+		inline bool passable(int32 x, int32 y) const
+		{
+			if (!rooms->inBounds(x, y))
+				return false;
+			return !rooms->get(x, y) || inRect(*a, x, y) || inRect(*b, x, y);
+		}
+	};
+
+	void CorridorRouter::setRooms(int32 width, int32 height, const std::vector<FIntRect>& rooms)
+	{
+		m_RoomRects = rooms;
+		m_Rooms.init(width, height);
+		m_Carved.init(width, height);
+		for (const FIntRect& r : rooms)
+		{
+			m_Rooms.fillRect(r.Min.X, r.Min.Y, r.Max.X, r.Max.Y);
+		}
+	}
+
+	// walk straight from 'from' until something makes the cell worth expanding
+	bool CorridorRouter::jump(const Query& q, FIntPoint from, int32 dir, bool probe, FIntPoint& out) const
+	{
+		const int32 dx = DirX[dir];
+		const int32 dy = DirY[dir];
+		int32 x = from.X;
+		int32 y = from.Y;
+		int32 steps = 0;
+
+		const int32 maxSteps = probe ? ProbeLength : INT32_MAX;
+
+		while (steps < maxSteps)
+		{
+			if (!q.passable(x + dx, y + dy))
+			{
+				// a wall ends the run, the last cell is still a valid place to turn
+				if (!probe && steps > 0)
+				{
+					out = FIntPoint(x, y);
+					return true;
+				}
+				return false;
+			}
+
+			// stop on the last cell before free and carved cells change, so every
+			// cell of a jump costs the same as the one it ends on. A probe only asks
+			// whether there is something to turn for, a change right away counts too
+			if ((steps > 0 || probe) && q.carved->get(x + dx, y + dy) != q.carved->get(x, y))
+			{
+				out = FIntPoint(x, y);
+				return true;
+			}
+
+			x += dx;
+			y += dy;
+			steps++;
+			out = FIntPoint(x, y);
+
+			if (out == q.goal)
+				return true;
+
+			if (isHorizontal(dir))
+			{
+				if (x == q.goal.X)
+					return true;
+				for (int32 py = -1; py <= 1; py += 2)
+				{
+					if (q.passable(x, y + py) && !q.passable(x - dx, y + py))
+						return true;
+				}
+			}
+			else
+			{
+				if (y == q.goal.Y)
+					return true;
+				for (int32 px = -1; px <= 1; px += 2)
+				{
+					if (q.passable(x + px, y) && !q.passable(x + px, y - dy))
+						return true;
+				}
+				// vertical runs stop wherever a short horizontal run would find something
+				FIntPoint tmp;
+				if (!probe && (jump(q, out, 0, true, tmp) || jump(q, out, 1, true, tmp)))
+					return true;
+			}
+		}
+		return false;
+	}
+
+	bool CorridorRouter::findPath(int32 roomA, int32 roomB, CorridorRoute& out) const
+	{
+		Scratch scratch;
+		return findPath(roomA, roomB, out, scratch);
+	}
+
+	bool CorridorRouter::findPath(int32 roomA, int32 roomB, CorridorRoute& out, Scratch& scratch) const
+	{
+		out.corners.clear();
+		out.ok = false;
+		if (roomA < 0 || roomB < 0 || roomA >= (int32)m_RoomRects.size() || roomB >= (int32)m_RoomRects.size())
+			return false;
+
+		Query q;
+		q.a = &m_RoomRects[roomA];
+		q.b = &m_RoomRects[roomB];
+		q.rooms = &m_Rooms;
+		q.carved = &m_Carved;
+		const FIntPoint start = (q.a->Min + q.a->Max) / 2;
+		q.goal = (q.b->Min + q.b->Max) / 2;
+
+		// a carved cell costs only reuseCost, so that is the most a cell can be
+		// counted for while the estimate stays below the real cost
+		const float weight = FMath::Min(1.f, m_Settings.reuseCost) * m_Settings.heuristicWeight;
+		auto heuristic = [&](const FIntPoint& c)
+		{
+			return (FMath::Abs(c.X - q.goal.X) + FMath::Abs(c.Y - q.goal.Y)) * weight;
+		};
+		// cell index and incoming direction
+		auto key = [&](const FIntPoint& c, int32 dir)
+		{
+			return (((uint64)c.Y * m_Rooms.width() + c.X) << 3) | (uint64)dir;
+		};
+
+		scratch.clear();
+		auto& open = scratch.open;
+		auto& best = scratch.best;
+		auto& parent = scratch.parent;
+		const std::greater<Node> later;
+
+		open.push_back({ heuristic(start), 0.f, start, NoDir });
+		best[key(start, NoDir)] = 0.f;
+
+		int32 expansions = 0;
+		while (!open.empty())
+		{
+			std::pop_heap(open.begin(), open.end(), later);
+			const Node n = open.back();
+			open.pop_back();
+			const uint64 nKey = key(n.cell, n.dir);
+			if (n.g > best[nKey])
+				continue;
+
+			if (n.cell == q.goal)
+			{
+				// rebuild and keep only the bends
+				std::vector<FIntPoint>& cells = scratch.cells;
+				uint64 k = nKey;
+				while (true)
+				{
+					const uint64 idx = k >> 3;
+					cells.push_back(FIntPoint((int32)(idx % m_Rooms.width()), (int32)(idx / m_Rooms.width())));
+					auto it = parent.find(k);
+					if (it == parent.end())
+						break;
+					k = it->second;
+				}
+				std::reverse(cells.begin(), cells.end());
+
+				for (size_t i = 0; i < cells.size(); i++)
+				{
+					if (i > 0 && i + 1 < cells.size())
+					{
+						const FIntPoint d0 = cells[i] - cells[i - 1];
+						const FIntPoint d1 = cells[i + 1] - cells[i];
+						const bool straight = (d0.X == 0) == (d1.X == 0);
+						if (straight)
+							continue;
+					}
+					out.corners.push_back(cells[i]);
+				}
+				out.ok = true;
+				return true;
+			}
+
+			if (++expansions > m_Settings.maxExpansions)
+				break;
+
+			for (int32 d = 0; d < 4; d++)
+			{
+				if (n.dir != NoDir && d == opposite(n.dir))
+					continue;
+
+				FIntPoint jp;
+				if (!jump(q, n.cell, d, false, jp))
+					continue;
+
+				const int32 steps = FMath::Abs(jp.X - n.cell.X) + FMath::Abs(jp.Y - n.cell.Y);
+				const float cellCost = m_Carved.get(jp.X, jp.Y) ? m_Settings.reuseCost : 1.f;
+				const float turn = (n.dir != NoDir && d != n.dir) ? m_Settings.turnPenalty : 0.f;
+				const float g = n.g + steps * cellCost + turn;
+
+				const uint64 jKey = key(jp, d);
+				auto it = best.find(jKey);
+				if (it != best.end() && it->second <= g)
+					continue;
+
+				best[jKey] = g;
+				parent[jKey] = nKey;
+				open.push_back({ g + heuristic(jp), g, jp, d });
+				std::push_heap(open.begin(), open.end(), later);
+			}
+		}
+		return false;
+	}
+
+	void CorridorRouter::forEachCell(const CorridorRoute& route, TFunctionRef<void(int32, int32)> func)
+	{
+		if (route.corners.empty())
+			return;
+
+		func(route.corners[0].X, route.corners[0].Y);
+		for (size_t i = 1; i < route.corners.size(); i++)
+		{
+			FIntPoint c = route.corners[i - 1];
+			const FIntPoint e = route.corners[i];
+			const FIntPoint step(FMath::Sign(e.X - c.X), FMath::Sign(e.Y - c.Y));
+			while (c != e)
+			{
+				c += step;
+				func(c.X, c.Y);
+			}
+		}
+	}
+
+	void CorridorRouter::carve(const CorridorRoute& route)
+	{
+		forEachCell(route, [&](int32 x, int32 y)
+		{
+			// room cells are never corridors
+			if (!m_Rooms.get(x, y))
+				m_Carved.set(x, y, true);
+		});
+	}
+
+	// Every round routes all pending edges in parallel against the corridors
+	// carved so far, then commits them in order. A route that runs alongside a
+	// corridor committed in the same round is sent to the next round, where it
+	// sees that corridor and can share it instead of doubling it.
+	std::vector<CorridorRoute> CorridorRouter::routeAll(const std::vector<std::pair<int32, int32>>& edges)
+	{
+		check(edges.size() <= (size_t)MAX_int32);
+		std::vector<CorridorRoute> results(edges.size());
+		std::vector<int32> pending(edges.size());
+		for (int32 i = 0; i < (int32)edges.size(); i++)
+		{
+			pending[i] = i;
+		}
+
+		// workers pull routes off a counter, each with its own search buffers for all rounds
+		const int32 workers = m_Settings.parallel ? FMath::Clamp(FPlatformMisc::NumberOfCoresIncludingHyperthreads(), 1, FMath::Max((int32)edges.size(), 1)) : 1;
+		std::vector<std::unique_ptr<Scratch>> scratch(workers);
+
+		OccupancyGrid roundMask;
+		for (int32 round = 0; round < m_Settings.maxRounds && !pending.empty(); round++)
+		{
+			std::atomic<int32> next{ 0 };
+			ParallelFor(workers, [&](int32 t)
+			{
+				if (!scratch[t])
+					scratch[t] = std::make_unique<Scratch>();
+				for (int32 i = next++; i < (int32)pending.size(); i = next++)
+				{
+					const int32 e = pending[i];
+					findPath(edges[e].first, edges[e].second, results[e], *scratch[t]);
+				}
+			}, workers == 1);
+
+			const bool lastRound = round == m_Settings.maxRounds - 1;
+			roundMask.init(m_Rooms.width(), m_Rooms.height());
+			std::vector<int32> deferred;
+
+			for (int32 e : pending)
+			{
+				const CorridorRoute& r = results[e];
+				if (!r.ok)
+					continue;
+
+				bool conflict = false;
+				if (!lastRound)
+				{
+					int32 run = 0;
+					forEachCell(r, [&](int32 x, int32 y)
+					{
+						const bool alongside = !roundMask.get(x, y) &&
+							(roundMask.get(x + 1, y) || roundMask.get(x - 1, y) || roundMask.get(x, y + 1) || roundMask.get(x, y - 1));
+						run = alongside ? run + 1 : 0;
+						if (run >= 3 && !m_Rooms.get(x, y))
+							conflict = true;
+					});
+				}
+
+				if (conflict)
+				{
+					deferred.push_back(e);
+					continue;
+				}
+
+				carve(r);
+				forEachCell(r, [&](int32 x, int32 y)
+				{
+					if (!m_Rooms.get(x, y))
+						roundMask.set(x, y, true);
+				});
+			}
+			pending.swap(deferred);
+		}
+		return results;
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "../Grid/OccupancyGrid.h"
+#include <vector>
+#include <utility>
+
+namespace Helpers {
+
+	struct RouterSettings
+	{
+		float turnPenalty = 4.f;	// extra cost for every bend
+		float reuseCost = 0.35f;	// cost of a cell that is already a corridor, free cells cost 1
+		float heuristicWeight = 1.f;	// 1 keeps routes optimal, more is faster but can miss cheaper routes
+		int32 maxRounds = 3;		// parallel rounds before the rest is committed as is
+		int32 maxExpansions = 200000;	// per route, gives up after this
+		bool parallel = true;
+	};
+
+	struct CorridorRoute
+	{
+		std::vector<FIntPoint> corners;	// start, every bend, goal
+		bool ok = false;
+	};
+
+	// Routes corridors between rooms over a bit grid of the room rectangles.
+	// A* with jump points: straight runs are skipped until a forced neighbour,
+	// the goal row/column, a wall or the last cell before free and carved cells
+	// change, so the cost along every jump is uniform and turn penalties stay exact.
+	class CorridorRouter {
+
+	public:
+		// rooms are inclusive cell rectangles, rasterized into the blocking grid
+		void setRooms(int32 width, int32 height, const std::vector<FIntRect>& rooms);
+
+		// edges are pairs of room indices, result is one route per edge
+		std::vector<CorridorRoute> routeAll(const std::vector<std::pair<int32, int32>>& edges);
+
+		// single route against the current carved corridors. routeAll keeps
+		// the search buffers of every worker over its routes, this one does not
+		bool findPath(int32 roomA, int32 roomB, CorridorRoute& out) const;
+
+		// mark a route as carved so later routes prefer to reuse it
+		void carve(const CorridorRoute& route);
+
+		const OccupancyGrid& rooms() const { return m_Rooms; }
+		const OccupancyGrid& carved() const { return m_Carved; }
+		static void forEachCell(const CorridorRoute& route, TFunctionRef<void(int32, int32)> func);
+
+		RouterSettings m_Settings;
+
+	private:
+		struct Query;
+		// search state kept by a worker between its routes
+		struct Scratch;
+
+		bool findPath(int32 roomA, int32 roomB, CorridorRoute& out, Scratch& scratch) const;
+		bool jump(const Query& q, FIntPoint from, int32 dir, bool probe, FIntPoint& out) const;
+
+		OccupancyGrid m_Rooms;
+		OccupancyGrid m_Carved;
+		std::vector<FIntRect> m_RoomRects;
+	};
+}
@@ -0,0 +1,423 @@
+#include "CorridorUnion.h"
+#include <algorithm>
+#include <map>
+
+namespace Helpers {
+
+	namespace {
+		struct Event
+		{
+			float x;
+			int32 y0, y1;	// elementary intervals [y0, y1] in the compressed y list
+			int32 dc, dr;	// corridor and room cover deltas
+		};
+
+		// cover counts over compressed y intervals. a = some interval is a
+		// corridor and not a room, b = same if a parent already counts as corridor
+		struct CoverTree
+		{
+			std::vector<int32> cntC, cntR;
+			std::vector<uint8> a, b;
+			int32 size = 0;
+
+			void init(int32 n)
+			{
+				size = n;
+				cntC.assign(4 * n, 0);
+				cntR.assign(4 * n, 0);
+				a.assign(4 * n, 0);
+				b.assign(4 * n, 0);
+				build(1, 0, n - 1);
+			}
+
+			void build(int32 node, int32 l, int32 r)
+			{
+				if (l < r)
+				{
+					const int32 m = (l + r) / 2;
+					build(node * 2, l, m);
+					build(node * 2 + 1, m + 1, r);
+				}
+				pull(node, l, r);
+			}
+
+			void pull(int32 node, int32 l, int32 r)
+			{
+				if (cntR[node] > 0)
+				{
+					a[node] = b[node] = 0;
+				}
+				else if (l == r)
+				{
+					b[node] = 1;
+					a[node] = cntC[node] > 0;
+				}
+				else
+				{
+					b[node] = b[node * 2] || b[node * 2 + 1];
+					a[node] = cntC[node] > 0 ? b[node] : (a[node * 2] || a[node * 2 + 1]);
+				}
+			}
+
+			void update(int32 node, int32 l, int32 r, int32 ql, int32 qr, int32 dc, int32 dr)
+			{
+				if (qr < l || r < ql)
+					return;
+				if (ql <= l && r <= qr)
+				{
+					cntC[node] += dc;
+					cntR[node] += dr;
+					pull(node, l, r);
+					return;
+				}
+				const int32 m = (l + r) / 2;
+				update(node * 2, l, m, ql, qr, dc, dr);
+				update(node * 2 + 1, m + 1, r, ql, qr, dc, dr);
+				pull(node, l, r);
+			}
+
+			// visible elementary intervals, only walks into subtrees that have one
+			void collect(int32 node, int32 l, int32 r, bool corridor, std::vector<int32>& out) const
+			{
+				if (cntR[node] > 0)
+					return;
+				corridor = corridor || cntC[node] > 0;
+				if (!(corridor ? b[node] : a[node]))
+					return;
+				if (l == r)
+				{
+					out.push_back(l);
+					return;
+				}
+				const int32 m = (l + r) / 2;
+				collect(node * 2, l, m, corridor, out);
+				collect(node * 2 + 1, m + 1, r, corridor, out);
+			}
+		};
+
+		struct OpenPiece
+		{
+			int32 y0, y1;
+			float startX;
+		};
+
+		struct Line
+		{
+			float at;		// y of horizontal, x of vertical lines
+			float lo, hi;
+			bool room;
+		};
+
+		// joins boxes that share a whole side, along x then y until nothing changes
+		void mergeTouching(std::vector<FBox2D>& boxes)
+		{
+			for (bool changed = true; changed; )
+			{
+				changed = false;
+				for (int32 axis = 0; axis < 2; axis++)
+				{
+					const int32 other = 1 - axis;
+					std::sort(boxes.begin(), boxes.end(), [axis, other](const FBox2D& l, const FBox2D& r)
+					{
+						if (l.Min[other] != r.Min[other]) return l.Min[other] < r.Min[other];
+						if (l.Max[other] != r.Max[other]) return l.Max[other] < r.Max[other];
+						return l.Min[axis] < r.Min[axis];
+					});
+					size_t w = 0;
+					for (size_t i = 0; i < boxes.size(); i++)
+					{
+						FBox2D& last = boxes[w > 0 ? w - 1 : 0];
+						if (w > 0 && last.Min[other] == boxes[i].Min[other] && last.Max[other] == boxes[i].Max[other]
+							&& last.Max[axis] == boxes[i].Min[axis])
+						{
+							last.Max[axis] = boxes[i].Max[axis];
+							changed = true;
+							continue;
+						}
+						boxes[w++] = boxes[i];
+					}
+					boxes.resize(w);
+				}
+			}
+		}
+
+		void addArms(CorridorJunction& j, const Line& h, const Line& v)
+		{
+			const FVector2D p = j.pos;
+			if (!h.room)
+			{
+				if (p.X < h.hi) j.arms |= 1;
+				if (p.X > h.lo) j.arms |= 2;
+			}
+			if (!v.room)
+			{
+				if (p.Y < v.hi) j.arms |= 4;
+				if (p.Y > v.lo) j.arms |= 8;
+			}
+		}
+	}
+
+	std::vector<FBox2D> CorridorUnion::unionMinus(const std::vector<FBox2D>& corridors, const std::vector<FBox2D>& rooms)
+	{
+		std::vector<FBox2D> pieces;
+
+		std::vector<float> ys;
+		ys.reserve((corridors.size() + rooms.size()) * 2);
+		for (const FBox2D& b : corridors) { ys.push_back(b.Min.Y); ys.push_back(b.Max.Y); }
+		for (const FBox2D& b : rooms) { ys.push_back(b.Min.Y); ys.push_back(b.Max.Y); }
+		std::sort(ys.begin(), ys.end());
+		ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+		if (ys.size() < 2)
+			return pieces;
+
+		auto yIndex = [&](float y)
+		{
+			return (int32)(std::lower_bound(ys.begin(), ys.end(), y) - ys.begin());
+		};
+
+		std::vector<Event> events;
+		events.reserve((corridors.size() + rooms.size()) * 2);
+		auto addBox = [&](const FBox2D& b, bool room)
+		{
+			if (b.Min.X >= b.Max.X || b.Min.Y >= b.Max.Y)
+				return;
+			const int32 y0 = yIndex(b.Min.Y);
+			const int32 y1 = yIndex(b.Max.Y) - 1;
+			events.push_back({ b.Min.X, y0, y1, room ? 0 : 1, room ? 1 : 0 });
+			events.push_back({ b.Max.X, y0, y1, room ? 0 : -1, room ? -1 : 0 });
+		};
+		for (const FBox2D& b : corridors) addBox(b, false);
+		for (const FBox2D& b : rooms) addBox(b, true);
+		std::sort(events.begin(), events.end(), [](const Event& l, const Event& r) { return l.x < r.x; });
+
+		CoverTree tree;
+		const int32 n = (int32)ys.size() - 1;
+		tree.init(n);
+
+		std::vector<OpenPiece> open;
+		std::vector<OpenPiece> next;
+		auto close = [&](const OpenPiece& p, float x)
+		{
+			pieces.push_back(FBox2D(FVector2D(p.startX, ys[p.y0]), FVector2D(x, ys[p.y1 + 1])));
+		};
+		std::vector<int32> leaves;
+
+		for (size_t i = 0; i < events.size(); )
+		{
+			const float x = events[i].x;
+			while (i < events.size() && events[i].x == x)
+			{
+				const Event& e = events[i++];
+				tree.update(1, 0, n - 1, e.y0, e.y1, e.dc, e.dr);
+			}
+
+			// covered intervals of the slab that starts here
+			leaves.clear();
+			if (i < events.size())
+				tree.collect(1, 0, n - 1, false, leaves);
+
+			// a piece keeps growing while the slab still covers all of it and the
+			// rest of the run around the pieces that go on is no more new pieces
+			// than would restart later. Otherwise the run starts over as one piece
+			next.clear();
+			size_t o = 0;
+			for (size_t k = 0; k < leaves.size(); )
+			{
+				size_t e = k;
+				while (e + 1 < leaves.size() && leaves[e + 1] == leaves[e] + 1)
+					e++;
+				const int32 r0 = leaves[k];
+				const int32 r1 = leaves[e];
+				k = e + 1;
+
+				for (; o < open.size() && open[o].y1 < r0; o++)
+				{
+					close(open[o], x);
+				}
+				size_t end = o;
+				int32 inside = 0, gaps = 0, from = r0;
+				for (; end < open.size() && open[end].y0 <= r1; end++)
+				{
+					const OpenPiece& p = open[end];
+					if (p.y0 < r0 || p.y1 > r1)
+						continue;
+					gaps += p.y0 > from ? 1 : 0;
+					from = p.y1 + 1;
+					inside++;
+				}
+				gaps += from <= r1 ? 1 : 0;
+				const bool grow = inside > 0 && gaps <= inside;
+
+				from = r0;
+				for (; o < end; o++)
+				{
+					const OpenPiece& p = open[o];
+					if (!grow || p.y0 < r0 || p.y1 > r1)
+					{
+						close(p, x);
+						continue;
+					}
+					if (p.y0 > from)
+						next.push_back({ from, p.y0 - 1, x });
+					next.push_back(p);
+					from = p.y1 + 1;
+				}
+				if (from <= r1)
+					next.push_back({ from, r1, x });
+			}
+			for (; o < open.size(); o++)
+			{
+				close(open[o], x);
+			}
+			open.swap(next);
+		}
+
+		// the sweep cuts where slabs change, join what lines up again
+		mergeTouching(pieces);
+		return pieces;
+	}
+
+	std::vector<CorridorJunction> CorridorUnion::findJunctions(const std::vector<std::vector<FVector2D>>& hallways,
+		const std::vector<FBox2D>& rooms)
+	{
+		std::vector<Line> horizontal, vertical;
+		for (const auto& line : hallways)
+		{
+			for (size_t i = 1; i < line.size(); i++)
+			{
+				const FVector2D a = line[i - 1];
+				const FVector2D b = line[i];
+				if (a.Y == b.Y && a.X != b.X)
+					horizontal.push_back({ a.Y, FMath::Min(a.X, b.X), FMath::Max(a.X, b.X), false });
+				else if (a.X == b.X && a.Y != b.Y)
+					vertical.push_back({ a.X, FMath::Min(a.Y, b.Y), FMath::Max(a.Y, b.Y), false });
+			}
+		}
+		for (const FBox2D& r : rooms)
+		{
+			horizontal.push_back({ r.Min.Y, r.Min.X, r.Max.X, true });
+			horizontal.push_back({ r.Max.Y, r.Min.X, r.Max.X, true });
+			vertical.push_back({ r.Min.X, r.Min.Y, r.Max.Y, true });
+			vertical.push_back({ r.Max.X, r.Min.Y, r.Max.Y, true });
+		}
+
+		// 0 = horizontal starts, 1 = vertical, 2 = horizontal ends, so touching ends count
+		struct SweepEvent { float x; int32 type; int32 line; };
+		std::vector<SweepEvent> events;
+		events.reserve(horizontal.size() * 2 + vertical.size());
+		for (int32 i = 0; i < (int32)horizontal.size(); i++)
+		{
+			events.push_back({ horizontal[i].lo, 0, i });
+			events.push_back({ horizontal[i].hi, 2, i });
+		}
+		for (int32 i = 0; i < (int32)vertical.size(); i++)
+		{
+			events.push_back({ vertical[i].at, 1, i });
+		}
+		std::sort(events.begin(), events.end(), [](const SweepEvent& l, const SweepEvent& r)
+		{
+			return l.x < r.x || (l.x == r.x && l.type < r.type);
+		});
+
+		TMap<FVector2D, CorridorJunction> points;
+		std::multimap<float, int32> active;
+		std::vector<std::multimap<float, int32>::iterator> handles(horizontal.size());
+
+		for (const SweepEvent& e : events)
+		{
+			if (e.type == 0)
+			{
+				handles[e.line] = active.emplace(horizontal[e.line].at, e.line);
+				continue;
+			}
+			if (e.type == 2)
+			{
+				active.erase(handles[e.line]);
+				continue;
+			}
+
+			const Line& v = vertical[e.line];
+			for (auto it = active.lower_bound(v.lo); it != active.end() && it->first <= v.hi; ++it)
+			{
+				const Line& h = horizontal[it->second];
+				if (h.room && v.room)
+					continue;
+
+				const FVector2D p(v.at, h.at);
+				CorridorJunction& j = points.FindOrAdd(p);
+				j.pos = p;
+				j.door = j.door || h.room || v.room;
+				addArms(j, h, v);
+			}
+		}
+
+		// rooms bucketed so points strictly inside one can be dropped
+		float cell = 1000.f;
+		if (!rooms.empty())
+		{
+			float total = 0.f;
+			for (const FBox2D& r : rooms)
+				total += (r.Max - r.Min).GetMax();
+			cell = FMath::Max(total / rooms.size(), 1.f);
+		}
+		TMap<FIntPoint, TArray<int32>> buckets;
+		for (int32 i = 0; i < (int32)rooms.size(); i++)
+		{
+			for (int32 y = FMath::FloorToInt(rooms[i].Min.Y / cell); y <= FMath::FloorToInt(rooms[i].Max.Y / cell); y++)
+				for (int32 x = FMath::FloorToInt(rooms[i].Min.X / cell); x <= FMath::FloorToInt(rooms[i].Max.X / cell); x++)
+					buckets.FindOrAdd(FIntPoint(x, y)).Add(i);
+		}
+		auto insideRoom = [&](const FVector2D& p)
+		{
+			const TArray<int32>* list = buckets.Find(FIntPoint(FMath::FloorToInt(p.X / cell), FMath::FloorToInt(p.Y / cell)));
+			if (!list)
+				return false;
+			for (int32 i : *list)
+			{
+				const FBox2D& r = rooms[i];
+				if (p.X > r.Min.X && p.X < r.Max.X && p.Y > r.Min.Y && p.Y < r.Max.Y)
+					return true;
+			}
+			return false;
+		};
+
+		std::vector<CorridorJunction> res;
+		for (const auto& kv : points)
+		{
+			const CorridorJunction& j = kv.Value;
+			if (j.arms == 0 || insideRoom(j.pos))
+				continue;
+			// a plain bend has two arms, a junction three or more
+			if (j.door || FPlatformMath::CountBits(j.arms) >= 3)
+				res.push_back(j);
+		}
+		return res;
+	}
+
+	std::vector<FBox2D> CorridorUnion::rects(const std::vector<FVector2D>& line, float width)
+	{
+		const FVector2D half(width * 0.5f, width * 0.5f);
+		std::vector<FBox2D> res;
+		for (size_t i = 1; i < line.size(); i++)
+		{
+			res.push_back(FBox2D(line[i - 1].ComponentMin(line[i]) - half, line[i - 1].ComponentMax(line[i]) + half));
+		}
+		return res;
+	}
+
+	CorridorLayout CorridorUnion::build(const std::vector<std::vector<FVector2D>>& hallways, float width,
+		const std::vector<FBox2D>& rooms)
+	{
+		std::vector<FBox2D> all;
+		for (const auto& line : hallways)
+		{
+			const std::vector<FBox2D> lineRects = rects(line, width);
+			all.insert(all.end(), lineRects.begin(), lineRects.end());
+		}
+
+		CorridorLayout layout;
+		layout.pieces = unionMinus(all, rooms);
+		layout.junctions = findJunctions(hallways, rooms);
+		return layout;
+	}
+}
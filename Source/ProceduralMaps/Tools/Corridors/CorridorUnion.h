@@ -0,0 +1,42 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <vector>
+
+namespace Helpers {
+
+	struct CorridorJunction
+	{
+		FVector2D pos;
+		uint8 arms = 0;		// +x, -x, +y, -y bits
+		bool door = false;	// hallway meets a room wall here
+	};
+
+	struct CorridorLayout
+	{
+		std::vector<FBox2D> pieces;		// non-overlapping, outside all rooms
+		std::vector<CorridorJunction> junctions;
+	};
+
+	// Unions all hallway rectangles and cuts out the rooms with one sweep over
+	// x, keeping corridor and room cover counts per y interval in a segment
+	// tree. Pieces grow across slabs while their y interval stays covered, so
+	// a hallway goes on past the side hallways that meet it, and pieces that
+	// share a whole side are joined after. Junctions come from a second sweep that
+	// intersects horizontal and vertical center lines and room walls.
+	class CorridorUnion {
+
+	public:
+		static CorridorLayout build(const std::vector<std::vector<FVector2D>>& hallways, float width,
+			const std::vector<FBox2D>& rooms);
+
+		// one rectangle per segment of a hallway, 'width' across
+		static std::vector<FBox2D> rects(const std::vector<FVector2D>& line, float width);
+
+		// just the union pieces for a set of rectangles
+		static std::vector<FBox2D> unionMinus(const std::vector<FBox2D>& corridors, const std::vector<FBox2D>& rooms);
+
+		static std::vector<CorridorJunction> findJunctions(const std::vector<std::vector<FVector2D>>& hallways,
+			const std::vector<FBox2D>& rooms);
+	};
+}
@@ -3,11 +3,16 @@
 namespace dt {
 
 template<typename T>
-const std::vector<typename Delaunay<T>::TriangleType>&
-Delaunay<T>::triangulate(std::vector<VertexType> &vertices)
+const Helpers::MapVector<typename Delaunay<T>::TriangleType>&
+Delaunay<T>::triangulate(const VertexType* vertices, std::size_t count)
 {
+	_triangles.clear();
+	_edges.clear();
+	if (count == 0)
+		return _triangles;
+
 	// Store the vertices locally
-	_vertices = vertices;
+	_vertices.assign(vertices, vertices + count);
 
 	// Determinate the super triangle
 	T minX = vertices[0].x;
@@ -15,7 +20,7 @@ Delaunay<T>::triangulate(std::vector<VertexType> &vertices)
 	T maxX = minX;
 	T maxY = minY;
 
-	for(std::size_t i = 0; i < vertices.size(); ++i)
+	for(std::size_t i = 0; i < count; ++i)
 	{
 		if (vertices[i].x < minX) minX = vertices[i].x;
 		if (vertices[i].y < minY) minY = vertices[i].y;
@@ -36,9 +41,11 @@ Delaunay<T>::triangulate(std::vector<VertexType> &vertices)
 	// Create a list of triangles, and add the supertriangle in it
 	_triangles.push_back(TriangleType(p1, p2, p3));
 
-	for(auto p = begin(vertices); p != end(vertices); p++)
+	// one polygon buffer for every vertex
+	Helpers::MapVector<EdgeType>& polygon = _polygon;
+	for(auto p = vertices; p != vertices + count; p++)
 	{
-		std::vector<EdgeType> polygon;
+		polygon.clear();
 
 		for(auto & t : _triangles)
 		{
@@ -71,7 +78,7 @@ Delaunay<T>::triangulate(std::vector<VertexType> &vertices)
 			return e.isBad;
 		}), end(polygon));
 
-		for(const auto e : polygon)
+		for(const auto& e : polygon)
 			_triangles.push_back(TriangleType(*e.v, *e.w, *p));
 
 	}
@@ -80,7 +87,8 @@ Delaunay<T>::triangulate(std::vector<VertexType> &vertices)
 		return t.containsVertex(p1) || t.containsVertex(p2) || t.containsVertex(p3);
 	}), end(_triangles));
 
-	for(const auto t : _triangles)
+	_edges.reserve(_triangles.size() * 3);
+	for(const auto& t : _triangles)
 	{
 		_edges.push_back(Edge<T>{*t.a, *t.b});
 		_edges.push_back(Edge<T>{*t.b, *t.c});
@@ -91,21 +99,21 @@ Delaunay<T>::triangulate(std::vector<VertexType> &vertices)
 }
 
 template<typename T>
-const std::vector<typename Delaunay<T>::TriangleType>&
+const Helpers::MapVector<typename Delaunay<T>::TriangleType>&
 Delaunay<T>::getTriangles() const
 {
 	return _triangles;
 }
 
 template<typename T>
-const std::vector<typename Delaunay<T>::EdgeType>&
+const Helpers::MapVector<typename Delaunay<T>::EdgeType>&
 Delaunay<T>::getEdges() const
 {
 	return _edges;
 }
 
 template<typename T>
-const std::vector<typename Delaunay<T>::VertexType>&
+const Helpers::MapVector<typename Delaunay<T>::VertexType>&
 Delaunay<T>::getVertices() const
 {
 	return _vertices;
@@ -113,5 +121,6 @@ Delaunay<T>::getVertices() const
 
 template class Delaunay<float>;
 template class Delaunay<double>;
+template class Delaunay<int32_t>;
 
 } // namespace dt
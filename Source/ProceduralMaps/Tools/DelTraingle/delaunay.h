@@ -4,12 +4,19 @@
 #include "vector2.h"
 #include "edge.h"
 #include "triangle.h"
+#include "../MapMemory.h"
 
 #include <vector>
 #include <algorithm>
 
 namespace dt {
 
+// Delaunay<int32_t> triangulates with exact integer predicates and no
+// tolerance anywhere, so it gives the same triangles on every platform and
+// build. Its input must stay within +-MaxExactCoordinate so the super
+// triangle still fits the predicates.
+constexpr int32_t MaxExactCoordinate = 1 << 23;
+
 template<typename T>
 class Delaunay
 {
@@ -18,23 +25,31 @@ class Delaunay
 	using EdgeType = Edge<Type>;
 	using TriangleType = Triangle<Type>;
 
-	static_assert(std::is_floating_point<Delaunay<T>::Type>::value,
-		"Type must be floating-point");
+	static_assert(std::is_floating_point<Delaunay<T>::Type>::value || std::is_same<Delaunay<T>::Type, int32_t>::value,
+		"Type must be floating-point or int32_t");
 
-	std::vector<TriangleType> _triangles;
-	std::vector<EdgeType> _edges;
-	std::vector<VertexType> _vertices;
+	// all storage comes from the resource given on construction
+	Helpers::MapVector<TriangleType> _triangles;
+	Helpers::MapVector<EdgeType> _edges;
+	Helpers::MapVector<VertexType> _vertices;
+	Helpers::MapVector<EdgeType> _polygon;
 
 public:
 
-	Delaunay() = default;
+	explicit Delaunay(Helpers::MapMemory* mem = Helpers::MapMemory::heap())
+		: _triangles(mem), _edges(mem), _vertices(mem), _polygon(mem) {}
 	Delaunay(const Delaunay&) = delete;
 	Delaunay(Delaunay&&) = delete;
 
-	const std::vector<TriangleType>& triangulate(std::vector<VertexType> &vertices);
-	const std::vector<TriangleType>& getTriangles() const;
-	const std::vector<EdgeType>& getEdges() const;
-	const std::vector<VertexType>& getVertices() const;
+	template<typename Alloc>
+	const Helpers::MapVector<TriangleType>& triangulate(std::vector<VertexType, Alloc> &vertices)
+	{
+		return triangulate(vertices.data(), vertices.size());
+	}
+	const Helpers::MapVector<TriangleType>& triangulate(const VertexType* vertices, std::size_t count);
+	const Helpers::MapVector<TriangleType>& getTriangles() const;
+	const Helpers::MapVector<EdgeType>& getEdges() const;
+	const Helpers::MapVector<VertexType>& getVertices() const;
 
 	Delaunay& operator=(const Delaunay&) = delete;
 	Delaunay& operator=(Delaunay&&) = delete;
@@ -24,5 +24,6 @@ operator <<(std::ostream &str, const Edge<U> &e)
 
 template struct Edge<float>;
 template struct Edge<double>;
+template struct Edge<int32_t>;
 
 } // namespace dt
@@ -27,8 +27,8 @@ struct Edge
 	const VertexType *w;
 	bool isBad = false;
 
-	static_assert(std::is_floating_point<Edge<T>::Type>::value,
-		"Type must be floating-point");
+	static_assert(std::is_floating_point<Edge<T>::Type>::value || std::is_same<Edge<T>::Type, int32_t>::value,
+		"Type must be floating-point or int32_t");
 };
 
 template<typename T>
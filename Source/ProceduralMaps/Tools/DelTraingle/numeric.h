@@ -4,6 +4,7 @@
 #include <math.h>
 #include <limits>
 #include <type_traits>
+#include <cstdint>
 
 namespace dt {
 
@@ -27,6 +28,84 @@ almost_equal(T x, T y, int ulp=2)
 	    	|| fabs(x-y) < std::numeric_limits<double>::min();
 }
 
+/**
+ * @brief integer coordinates are exact, equal means equal
+ */
+template<class T>
+typename std::enable_if<std::is_integral<T>::value, bool>::type
+almost_equal(T x, T y, int ulp=2)
+{
+	return x == y;
+}
+
+/**
+ * @brief signed 128 bit value, just enough for the exact predicates below
+ * without relying on a compiler specific __int128
+ */
+struct Int128
+{
+	uint64_t lo;
+	uint64_t hi;	// two's complement with lo
+
+	Int128 operator+(const Int128 &v) const
+	{
+		const uint64_t l = lo + v.lo;
+		return Int128{ l, hi + v.hi + (l < lo ? 1 : 0) };
+	}
+	Int128 operator-() const
+	{
+		return Int128{ ~lo + 1, ~hi + (lo == 0 ? 1 : 0) };
+	}
+	Int128 operator-(const Int128 &v) const { return *this + -v; }
+
+	int sign() const
+	{
+		if (hi >> 63)
+			return -1;
+		return (hi | lo) ? 1 : 0;
+	}
+
+	static Int128 mul(int64_t a, int64_t b)
+	{
+		const uint64_t ua = a < 0 ? 0 - (uint64_t)a : (uint64_t)a;
+		const uint64_t ub = b < 0 ? 0 - (uint64_t)b : (uint64_t)b;
+		const uint64_t a0 = ua & 0xffffffffu, a1 = ua >> 32;
+		const uint64_t b0 = ub & 0xffffffffu, b1 = ub >> 32;
+		const uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+		const uint64_t mid = (p00 >> 32) + (p01 & 0xffffffffu) + (p10 & 0xffffffffu);
+		const Int128 r{ (p00 & 0xffffffffu) | (mid << 32), p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32) };
+		return (a < 0) != (b < 0) ? -r : r;
+	}
+};
+
+/**
+ * @brief twice the signed area of abc, > 0 when counter clockwise.
+ * Exact while every coordinate difference fits in 31 bits
+ */
+inline int64_t orient2d(int64_t ax, int64_t ay, int64_t bx, int64_t by, int64_t cx, int64_t cy)
+{
+	return (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+}
+
+/**
+ * @brief sign of the in-circle determinant, > 0 when d is strictly inside the
+ * circle through a counter clockwise abc. Exact while every coordinate
+ * difference fits in 30 bits
+ */
+inline int incircle(int64_t ax, int64_t ay, int64_t bx, int64_t by, int64_t cx, int64_t cy, int64_t dx, int64_t dy)
+{
+	const int64_t adx = ax - dx, ady = ay - dy;
+	const int64_t bdx = bx - dx, bdy = by - dy;
+	const int64_t cdx = cx - dx, cdy = cy - dy;
+	const int64_t al = adx * adx + ady * ady;
+	const int64_t bl = bdx * bdx + bdy * bdy;
+	const int64_t cl = cdx * cdx + cdy * cdy;
+	const Int128 det = Int128::mul(al, bdx * cdy - cdx * bdy)
+		+ Int128::mul(bl, cdx * ady - adx * cdy)
+		+ Int128::mul(cl, adx * bdy - bdx * ady);
+	return det.sign();
+}
+
 } // namespace dt
 
 #endif
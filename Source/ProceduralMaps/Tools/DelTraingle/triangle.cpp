@@ -39,6 +39,16 @@ Triangle<T>::circumCircleContains(const VertexType &v) const
 	return dist <= circum_radius;
 }
 
+template<>
+bool
+Triangle<int32_t>::circumCircleContains(const VertexType &v) const
+{
+	// points on the circle count as outside, so duplicates and cocircular
+	// points leave the triangle alone
+	const int side = incircle(a->x, a->y, b->x, b->y, c->x, c->y, v.x, v.y);
+	return orient2d(a->x, a->y, b->x, b->y, c->x, c->y) > 0 ? side > 0 : side < 0;
+}
+
 template<typename T>
 bool
 Triangle<T>::operator ==(const Triangle &t) const
@@ -60,5 +70,6 @@ operator <<(std::ostream &str, const Triangle<U> &t)
 
 template struct Triangle<float>;
 template struct Triangle<double>;
+template struct Triangle<int32_t>;
 
 } // namespace dt
@@ -34,12 +34,16 @@ struct Triangle
 	const VertexType *c;
 	bool isBad = false;
 
-	static_assert(std::is_floating_point<Triangle<T>::Type>::value,
-		"Type must be floating-point");
+	static_assert(std::is_floating_point<Triangle<T>::Type>::value || std::is_same<Triangle<T>::Type, int32_t>::value,
+		"Type must be floating-point or int32_t");
 	
 	
 };
 
+// integer triangles use the exact in-circle test
+template<>
+bool Triangle<int32_t>::circumCircleContains(const VertexType &v) const;
+
 template<typename T>
 bool almost_equal(const Triangle<T> &t1, const Triangle<T> &t2)
 {
@@ -53,5 +53,6 @@ operator <<(std::ostream &str, const Vector2<U> &v)
 
 template struct Vector2<float>;
 template struct Vector2<double>;
+template struct Vector2<int32_t>;
 
 } // namespace dt
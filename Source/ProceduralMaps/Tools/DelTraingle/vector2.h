@@ -6,7 +6,6 @@
 #include <iostream>
 #include <cmath>
 #include <type_traits>
-#include "Math/Vector.h"
 
 namespace dt {
 
@@ -28,13 +27,12 @@ struct Vector2
 	bool operator ==(const Vector2<T> &v) const;
 	template<typename U>
 	friend std::ostream &operator <<(std::ostream &str, const Vector2<U> &v);
-	FVector2D vec() const{	return FVector2D((T)x, (T)y); }
 
 	T x;
 	T y;
 
-	static_assert(std::is_floating_point<Vector2<T>::Type>::value,
-		"Type must be floating-point");
+	static_assert(std::is_floating_point<Vector2<T>::Type>::value || std::is_same<Vector2<T>::Type, int32_t>::value,
+		"Type must be floating-point or int32_t");
 
 	
 };
@@ -0,0 +1,14 @@
+#pragma once
+
+// Put after the includes of a file whose floats end up in the layout. A fused
+// multiply add rounds once where a multiply and an add round twice, so a
+// compiler that fuses them for one platform builds another map
+#if defined(__clang__)
+#define MAP_EXACT_FLOAT _Pragma("clang fp contract(off)")
+#elif defined(_MSC_VER)
+#define MAP_EXACT_FLOAT __pragma(fp_contract(off))
+#elif defined(__GNUC__)
+#define MAP_EXACT_FLOAT _Pragma("GCC optimize(\"fp-contract=off\")")
+#else
+#define MAP_EXACT_FLOAT
+#endif
@@ -0,0 +1,151 @@
+#include "FlowField.h"
+#include "Async/ParallelFor.h"
+
+namespace Helpers {
+
+	namespace {
+		const int32 DX[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+		const int32 DY[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+		// straight steps are tried first so ties give straight paths
+		const uint8 Order[8] = { 0, 2, 4, 6, 1, 3, 5, 7 };
+
+		const int32 RowsPerTask = 32;
+
+		inline bool canStep(const OccupancyGrid& open, int32 x, int32 y, uint8 dir)
+		{
+			const int32 nx = x + DX[dir];
+			const int32 ny = y + DY[dir];
+			if (!open.get(nx, ny))
+				return false;
+			// diagonals only between two open cells
+			return (dir & 1) == 0 || (open.get(nx, y) && open.get(x, ny));
+		}
+
+		inline int32 cost(uint8 dir)
+		{
+			return (dir & 1) ? FlowField::DiagonalCost : FlowField::StraightCost;
+		}
+	}
+
+	FIntPoint FlowField::offset(uint8 dir)
+	{
+		return dir < 8 ? FIntPoint(DX[dir], DY[dir]) : FIntPoint(0, 0);
+	}
+
+	void FlowField::build(const OccupancyGrid& open, const std::vector<FIntPoint>& targets)
+	{
+		m_Width = open.width();
+		m_Height = open.height();
+		m_RowBytes = (m_Width + 1) / 2;
+		const size_t count = (size_t)m_Width * m_Height;
+
+		// Dial's algorithm, a step costs at most 7 so 8 rotating buckets hold every pending distance
+		std::vector<uint32> dist(count, MAX_uint32);
+		std::vector<int32> buckets[8];
+		int64 pending = 0;
+		for (const FIntPoint& t : targets)
+		{
+			if (!open.get(t.X, t.Y))
+				continue;
+			const int32 c = t.Y * m_Width + t.X;
+			if (dist[c] == 0)
+				continue;
+			dist[c] = 0;
+			buckets[0].push_back(c);
+			pending++;
+		}
+		for (uint32 current = 0; pending > 0; current++)
+		{
+			// pushes land at least 5 buckets ahead, never in this one
+			std::vector<int32>& bucket = buckets[current & 7];
+			for (int32 c : bucket)
+			{
+				pending--;
+				if (dist[c] != current)
+					continue;
+				const int32 x = c % m_Width;
+				const int32 y = c / m_Width;
+				for (uint8 d = 0; d < 8; d++)
+				{
+					if (!canStep(open, x, y, d))
+						continue;
+					const int32 n = c + DY[d] * m_Width + DX[d];
+					const uint32 nd = current + cost(d);
+					if (nd < dist[n])
+					{
+						dist[n] = nd;
+						buckets[nd & 7].push_back(n);
+						pending++;
+					}
+				}
+			}
+			bucket.clear();
+		}
+
+		// every cell points at the neighbour its distance came from
+		m_Dirs.assign((size_t)m_RowBytes * m_Height, 0xff);
+		m_Dist.assign(count, (uint16)Unreachable);
+		ParallelFor(FMath::DivideAndRoundUp(m_Height, RowsPerTask), [&](int32 task)
+		{
+			const int32 last = FMath::Min(m_Height, (task + 1) * RowsPerTask);
+			for (int32 y = task * RowsPerTask; y < last; y++)
+			{
+				for (int32 x = 0; x < m_Width; x++)
+				{
+					const int32 c = y * m_Width + x;
+					if (dist[c] == MAX_uint32)
+						continue;
+
+					uint8 dir = Dir_Target;
+					if (dist[c] > 0)
+					{
+						uint32 best = MAX_uint32;
+						for (uint8 d : Order)
+						{
+							if (!canStep(open, x, y, d))
+								continue;
+							const uint32 via = dist[c + DY[d] * m_Width + DX[d]];
+							if (via != MAX_uint32 && via + cost(d) < best)
+							{
+								best = via + cost(d);
+								dir = d;
+							}
+						}
+					}
+					uint8& b = m_Dirs[(size_t)y * m_RowBytes + (x >> 1)];
+					b = (x & 1) ? ((b & 0x0f) | (dir << 4)) : ((b & 0xf0) | dir);
+					m_Dist[c] = (uint16)FMath::Min(dist[c], (uint32)Unreachable - 1);
+				}
+			}
+		});
+	}
+
+	void FlowField::buildAll(const OccupancyGrid& open, const std::vector<std::vector<FIntPoint>>& targets, std::vector<FlowField>& fields)
+	{
+		fields.resize(targets.size());
+		ParallelFor((int32)targets.size(), [&](int32 i)
+		{
+			fields[i].build(open, targets[i]);
+		});
+	}
+
+	FIntPoint FlowField::step(const FIntPoint& c) const
+	{
+		return c + offset(direction(c.X, c.Y));
+	}
+
+	float FlowField::distance(int32 x, int32 y) const
+	{
+		if (!inBounds(x, y))
+			return -1.f;
+		const uint16 d = m_Dist[(size_t)y * m_Width + x];
+		return d == Unreachable ? -1.f : (float)d / StraightCost;
+	}
+
+	FVector2D FlowField::nextWaypoint(const GridFrame& frame, const FVector2D& p) const
+	{
+		const FIntPoint c = frame.toCell(p);
+		const uint8 dir = direction(c.X, c.Y);
+		return dir < 8 ? frame.toWorld(c + offset(dir)) : p;
+	}
+}
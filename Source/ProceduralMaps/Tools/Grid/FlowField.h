@@ -0,0 +1,60 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OccupancyGrid.h"
+#include <vector>
+
+namespace Helpers {
+
+	// Distance from every open cell of a grid to the nearest of a set of
+	// target cells, and the direction of the first step on that path. Cells
+	// have 8 neighbours with 5/7 chamfer costs, a diagonal step needs both
+	// cells beside it open so paths never cut wall corners. Kept as a 4 bit
+	// direction and a 16 bit distance per cell. Distances saturate on very
+	// long paths, directions stay exact.
+	class FlowField {
+
+	public:
+		// directions 0..7 go counter clockwise from +X, then these two
+		static const uint8 Dir_Target = 8;
+		static const uint8 Dir_None = 15;	// closed cell or no path
+		static const uint16 Unreachable = 0xffff;
+		static const int32 StraightCost = 5;
+		static const int32 DiagonalCost = 7;
+
+		// targets on closed cells or off the grid are skipped
+		void build(const OccupancyGrid& open, const std::vector<FIntPoint>& targets);
+		// one field per target set over the same grid, built in parallel
+		static void buildAll(const OccupancyGrid& open, const std::vector<std::vector<FIntPoint>>& targets, std::vector<FlowField>& fields);
+
+		inline int32 width() const { return m_Width; }
+		inline int32 height() const { return m_Height; }
+		inline bool inBounds(int32 x, int32 y) const { return x >= 0 && y >= 0 && x < m_Width && y < m_Height; }
+
+		inline uint8 direction(int32 x, int32 y) const
+		{
+			if (!inBounds(x, y))
+				return Dir_None;
+			const uint8 b = m_Dirs[(size_t)y * m_RowBytes + (x >> 1)];
+			return (x & 1) ? (b >> 4) : (b & 15);
+		}
+		inline bool reachable(int32 x, int32 y) const { return direction(x, y) != Dir_None; }
+
+		// next cell toward the nearest target, the cell itself at a target or without a path
+		FIntPoint step(const FIntPoint& c) const;
+		// in cells, a diagonal step counts 1.4. -1 without a path
+		float distance(int32 x, int32 y) const;
+		// centre of the next cell in world space, 'p' itself at a target or without a path
+		FVector2D nextWaypoint(const GridFrame& frame, const FVector2D& p) const;
+
+		static FIntPoint offset(uint8 dir);
+		size_t memoryBytes() const { return m_Dirs.size() + m_Dist.size() * sizeof(uint16); }
+
+	private:
+		int32 m_Width = 0;
+		int32 m_Height = 0;
+		int32 m_RowBytes = 0;		// rows start on a byte, so row tasks share nothing
+		std::vector<uint8> m_Dirs;	// two cells a byte, even x in the low nibble
+		std::vector<uint16> m_Dist;	// chamfer units
+	};
+}
@@ -0,0 +1,72 @@
+#include "MapRasterizer.h"
+
+namespace Helpers {
+
+	FIntPoint MapRasterizer::computeFrame(const std::vector<FBox2D>& rooms, float cellSize, int32 margin, GridFrame& outFrame)
+	{
+		FVector2D lo(FLT_MAX, FLT_MAX), hi(-FLT_MAX, -FLT_MAX);
+		for (const FBox2D& b : rooms)
+		{
+			lo = lo.ComponentMin(b.Min);
+			hi = hi.ComponentMax(b.Max);
+		}
+		if (rooms.empty())
+			lo = hi = FVector2D::ZeroVector;
+
+		outFrame.cellSize = cellSize;
+		outFrame.origin = lo - FVector2D(margin * cellSize, margin * cellSize);
+		return outFrame.toCell(hi) + FIntPoint(margin + 1, margin + 1);
+	}
+
+	void MapRasterizer::rasterizeRooms(OccupancyGrid& grid, const GridFrame& frame, const std::vector<FBox2D>& rooms)
+	{
+		for (const FBox2D& b : rooms)
+		{
+			const FIntPoint lo = frame.toCell(b.Min);
+			const FIntPoint hi = frame.toCell(b.Max);
+			grid.fillRect(lo.X, lo.Y, hi.X, hi.Y);
+		}
+	}
+
+	void MapRasterizer::rasterizeHallways(OccupancyGrid& grid, const GridFrame& frame,
+		const std::vector<std::vector<FVector2D>>& hallways, float width)
+	{
+		const float half = width * 0.5f;
+		for (const auto& line : hallways)
+		{
+			for (size_t i = 1; i < line.size(); i++)
+			{
+				const FVector2D a = line[i - 1];
+				const FVector2D b = line[i];
+
+				// hallways are axis aligned, anything else is stamped along its length
+				if (a.X == b.X || a.Y == b.Y)
+				{
+					const FIntPoint lo = frame.toCell(a.ComponentMin(b) - FVector2D(half, half));
+					const FIntPoint hi = frame.toCell(a.ComponentMax(b) + FVector2D(half, half));
+					grid.fillRect(lo.X, lo.Y, hi.X, hi.Y);
+					continue;
+				}
+
+				const int32 steps = FMath::CeilToInt(FVector2D::Distance(a, b) / (frame.cellSize * 0.5f));
+				for (int32 s = 0; s <= steps; s++)
+				{
+					const FVector2D p = a + (b - a) * ((float)s / steps);
+					const FIntPoint lo = frame.toCell(p - FVector2D(half, half));
+					const FIntPoint hi = frame.toCell(p + FVector2D(half, half));
+					grid.fillRect(lo.X, lo.Y, hi.X, hi.Y);
+				}
+			}
+		}
+	}
+
+	FIntPoint MapRasterizer::rasterize(OccupancyGrid& grid, GridFrame& outFrame, const std::vector<FBox2D>& rooms,
+		const std::vector<std::vector<FVector2D>>& hallways, float cellSize, float hallwayWidth)
+	{
+		const FIntPoint size = computeFrame(rooms, cellSize, 4, outFrame);
+		grid.init(size.X, size.Y);
+		rasterizeRooms(grid, outFrame, rooms);
+		rasterizeHallways(grid, outFrame, hallways, hallwayWidth);
+		return size;
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OccupancyGrid.h"
+#include <vector>
+
+namespace Helpers {
+
+	// turns the final layout into an occupancy grid, rooms and hallways set
+	class MapRasterizer {
+
+	public:
+		// frame and size that cover all rooms plus a margin in cells
+		static FIntPoint computeFrame(const std::vector<FBox2D>& rooms, float cellSize, int32 margin, GridFrame& outFrame);
+
+		// any set of boxes, rooms or merged hallway pieces
+		static void rasterizeRooms(OccupancyGrid& grid, const GridFrame& frame, const std::vector<FBox2D>& rooms);
+
+		// hallway polylines, each segment stamped 'width' world units wide
+		static void rasterizeHallways(OccupancyGrid& grid, const GridFrame& frame,
+			const std::vector<std::vector<FVector2D>>& hallways, float width);
+
+		// frame + rooms + hallways in one go
+		static FIntPoint rasterize(OccupancyGrid& grid, GridFrame& outFrame, const std::vector<FBox2D>& rooms,
+			const std::vector<std::vector<FVector2D>>& hallways, float cellSize, float hallwayWidth);
+	};
+}
@@ -0,0 +1,219 @@
+#include "OccupancyGrid.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#include <emmintrin.h>
+#define GRID_SSE2 1
+#else
+#define GRID_SSE2 0
+#endif
+
+namespace Helpers {
+
+	namespace {
+		const uint64 ColumnFirst = 0x0101010101010101ull;
+		const uint64 ColumnLast = 0x8080808080808080ull;
+
+		// OR the same mask into a run of tiles, two at a time where we can
+		void orSpan(uint64* dst, int32 count, uint64 mask)
+		{
+			int32 i = 0;
+#if GRID_SSE2
+			const __m128i m = _mm_set1_epi64x((long long)mask);
+			for (; i + 2 <= count; i += 2)
+			{
+				__m128i v = _mm_loadu_si128((const __m128i*)(dst + i));
+				_mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(v, m));
+			}
+#endif
+			for (; i < count; i++)
+			{
+				dst[i] |= mask;
+			}
+		}
+
+		inline int32 lowestBit(uint64 v)
+		{
+			return FPlatformMath::CountBits((v & (~v + 1)) - 1);
+		}
+	}
+
+	void OccupancyGrid::init(int32 width, int32 height)
+	{
+		m_Width = FMath::Max(width, 0);
+		m_Height = FMath::Max(height, 0);
+		m_TilesX = (m_Width + TileSize - 1) >> TileBits;
+		m_TilesY = (m_Height + TileSize - 1) >> TileBits;
+		m_Tiles.assign((size_t)m_TilesX * m_TilesY, 0ull);
+	}
+
+	void OccupancyGrid::clear()
+	{
+		std::fill(m_Tiles.begin(), m_Tiles.end(), 0ull);
+	}
+
+	bool OccupancyGrid::clipRect(int32& x0, int32& y0, int32& x1, int32& y1) const
+	{
+		x0 = FMath::Max(x0, 0);
+		y0 = FMath::Max(y0, 0);
+		x1 = FMath::Min(x1, m_Width - 1);
+		y1 = FMath::Min(y1, m_Height - 1);
+		return x0 <= x1 && y0 <= y1;
+	}
+
+	uint64 OccupancyGrid::tileMask(int32 tx, int32 ty, int32 x0, int32 y0, int32 x1, int32 y1) const
+	{
+		const int32 cx0 = FMath::Max(x0 - (tx << TileBits), 0);
+		const int32 cx1 = FMath::Min(x1 - (tx << TileBits), TileSize - 1);
+		const int32 ry0 = FMath::Max(y0 - (ty << TileBits), 0);
+		const int32 ry1 = FMath::Min(y1 - (ty << TileBits), TileSize - 1);
+
+		// columns as one byte repeated on every row, then cut to the rows
+		const uint64 columns = (uint64)((0xFFu << cx0) & (0xFFu >> (7 - cx1)) & 0xFFu) * ColumnFirst;
+		const uint64 rowsHi = ry1 == 7 ? ~0ull : ((1ull << ((ry1 + 1) * 8)) - 1);
+		const uint64 rowsLo = ~((1ull << (ry0 * 8)) - 1);
+		return columns & rowsHi & rowsLo;
+	}
+
+	void OccupancyGrid::fillRect(int32 x0, int32 y0, int32 x1, int32 y1)
+	{
+		if (!clipRect(x0, y0, x1, y1))
+			return;
+
+		const int32 tx0 = x0 >> TileBits;
+		const int32 tx1 = x1 >> TileBits;
+		const int32 ty0 = y0 >> TileBits;
+		const int32 ty1 = y1 >> TileBits;
+
+		for (int32 ty = ty0; ty <= ty1; ty++)
+		{
+			uint64* row = &m_Tiles[(size_t)ty * m_TilesX];
+			row[tx0] |= tileMask(tx0, ty, x0, y0, x1, y1);
+			if (tx1 == tx0)
+				continue;
+
+			// every tile between the two ends gets the same mask
+			if (tx1 - tx0 > 1)
+				orSpan(row + tx0 + 1, tx1 - tx0 - 1, tileMask(tx0 + 1, ty, x0, y0, x1, y1));
+			row[tx1] |= tileMask(tx1, ty, x0, y0, x1, y1);
+		}
+	}
+
+	bool OccupancyGrid::anyInRect(int32 x0, int32 y0, int32 x1, int32 y1) const
+	{
+		if (!clipRect(x0, y0, x1, y1))
+			return false;
+
+		for (int32 ty = y0 >> TileBits; ty <= (y1 >> TileBits); ty++)
+		{
+			for (int32 tx = x0 >> TileBits; tx <= (x1 >> TileBits); tx++)
+			{
+				if (tile(tx, ty) & tileMask(tx, ty, x0, y0, x1, y1))
+					return true;
+			}
+		}
+		return false;
+	}
+
+	int64 OccupancyGrid::countInRect(int32 x0, int32 y0, int32 x1, int32 y1) const
+	{
+		if (!clipRect(x0, y0, x1, y1))
+			return 0;
+
+		int64 count = 0;
+		for (int32 ty = y0 >> TileBits; ty <= (y1 >> TileBits); ty++)
+		{
+			for (int32 tx = x0 >> TileBits; tx <= (x1 >> TileBits); tx++)
+			{
+				count += FPlatformMath::CountBits(tile(tx, ty) & tileMask(tx, ty, x0, y0, x1, y1));
+			}
+		}
+		return count;
+	}
+
+	// Fills a tile at a time: the region grows inside the tile with shifts until
+	// it stops changing, then the cells on each tile border seed the neighbour.
+	int64 OccupancyGrid::floodFill(FIntPoint seed, OccupancyGrid& visited) const
+	{
+		if (visited.m_Tiles.size() != m_Tiles.size())
+			visited.init(m_Width, m_Height);
+		if (!get(seed.X, seed.Y) || visited.get(seed.X, seed.Y))
+			return 0;
+
+		struct Pending { int32 tx, ty; uint64 seeds; };
+		std::vector<Pending> stack;
+		stack.push_back({ seed.X >> TileBits, seed.Y >> TileBits, 1ull << bitIndex(seed.X, seed.Y) });
+
+		int64 count = 0;
+		while (!stack.empty())
+		{
+			const Pending p = stack.back();
+			stack.pop_back();
+
+			const size_t idx = (size_t)p.ty * m_TilesX + p.tx;
+			const uint64 open = m_Tiles[idx] & ~visited.m_Tiles[idx];
+			uint64 region = p.seeds & open;
+			if (!region)
+				continue;
+
+			while (true)
+			{
+				uint64 grown = region
+					| ((region << 1) & ~ColumnFirst)
+					| ((region >> 1) & ~ColumnLast)
+					| (region << 8)
+					| (region >> 8);
+				grown &= open;
+				if (grown == region)
+					break;
+				region = grown;
+			}
+
+			visited.m_Tiles[idx] |= region;
+			count += FPlatformMath::CountBits(region);
+
+			// last column -> first column of the right tile and so on
+			if (p.tx + 1 < m_TilesX && (region & ColumnLast))
+				stack.push_back({ p.tx + 1, p.ty, (region & ColumnLast) >> 7 });
+			if (p.tx > 0 && (region & ColumnFirst))
+				stack.push_back({ p.tx - 1, p.ty, (region & ColumnFirst) << 7 });
+			if (p.ty + 1 < m_TilesY && (region >> 56))
+				stack.push_back({ p.tx, p.ty + 1, region >> 56 });
+			if (p.ty > 0 && (region & 0xFFull))
+				stack.push_back({ p.tx, p.ty - 1, region << 56 });
+		}
+		return count;
+	}
+
+	bool OccupancyGrid::isConnected(FIntPoint a, FIntPoint b) const
+	{
+		if (!get(a.X, a.Y) || !get(b.X, b.Y))
+			return false;
+
+		OccupancyGrid visited;
+		floodFill(a, visited);
+		return visited.get(b.X, b.Y);
+	}
+
+	int32 OccupancyGrid::countComponents() const
+	{
+		OccupancyGrid visited;
+		visited.init(m_Width, m_Height);
+
+		int32 components = 0;
+		for (int32 ty = 0; ty < m_TilesY; ty++)
+		{
+			for (int32 tx = 0; tx < m_TilesX; tx++)
+			{
+				const size_t idx = (size_t)ty * m_TilesX + tx;
+				uint64 open;
+				while ((open = m_Tiles[idx] & ~visited.m_Tiles[idx]) != 0)
+				{
+					const int32 bit = lowestBit(open);
+					floodFill(FIntPoint((tx << TileBits) + (bit & 7), (ty << TileBits) + (bit >> 3)), visited);
+					components++;
+				}
+			}
+		}
+		return components;
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <vector>
+
+namespace Helpers {
+
+	// maps world XY to grid cells
+	struct GridFrame
+	{
+		FVector2D origin = FVector2D::ZeroVector;
+		float cellSize = 100.f;
+
+		FIntPoint toCell(const FVector2D& p) const
+		{
+			return FIntPoint(FMath::FloorToInt((p.X - origin.X) / cellSize), FMath::FloorToInt((p.Y - origin.Y) / cellSize));
+		}
+		// center of a cell in world space
+		FVector2D toWorld(const FIntPoint& c) const
+		{
+			return FVector2D(origin.X + (c.X + 0.5f) * cellSize, origin.Y + (c.Y + 0.5f) * cellSize);
+		}
+	};
+
+	// 1 bit per cell stored in 8x8 tiles, one uint64 per tile with a byte per
+	// row. Neighbouring rows share a word, so rectangle fills, area queries and
+	// flood fills work on whole tiles at a time. 16k x 16k cells is 32 MB.
+	class OccupancyGrid {
+
+	public:
+		static const int32 TileBits = 3;
+		static const int32 TileSize = 1 << TileBits;
+
+		void init(int32 width, int32 height);
+		void clear();
+
+		inline int32 width() const { return m_Width; }
+		inline int32 height() const { return m_Height; }
+		inline int32 tilesX() const { return m_TilesX; }
+		inline int32 tilesY() const { return m_TilesY; }
+		inline bool inBounds(int32 x, int32 y) const { return x >= 0 && y >= 0 && x < m_Width && y < m_Height; }
+
+		inline bool get(int32 x, int32 y) const
+		{
+			return inBounds(x, y) && (m_Tiles[tileIndex(x, y)] >> bitIndex(x, y)) & 1ull;
+		}
+		inline void set(int32 x, int32 y, bool state)
+		{
+			if (!inBounds(x, y))
+				return;
+			uint64& t = m_Tiles[tileIndex(x, y)];
+			const uint64 bit = 1ull << bitIndex(x, y);
+			t = state ? (t | bit) : (t & ~bit);
+		}
+
+		// inclusive cell rectangles, clipped to the grid
+		void fillRect(int32 x0, int32 y0, int32 x1, int32 y1);
+		bool anyInRect(int32 x0, int32 y0, int32 x1, int32 y1) const;
+		int64 countInRect(int32 x0, int32 y0, int32 x1, int32 y1) const;
+
+		// 4-connected flood fill over set cells, marks the region in visited
+		// (initialized to the same size when empty). Returns the cell count
+		int64 floodFill(FIntPoint seed, OccupancyGrid& visited) const;
+		bool isConnected(FIntPoint a, FIntPoint b) const;
+		int32 countComponents() const;
+
+		inline uint64 tile(int32 tx, int32 ty) const { return m_Tiles[(size_t)ty * m_TilesX + tx]; }
+		size_t memoryBytes() const { return m_Tiles.size() * sizeof(uint64); }
+
+	private:
+		inline size_t tileIndex(int32 x, int32 y) const { return (size_t)(y >> TileBits) * m_TilesX + (x >> TileBits); }
+		inline int32 bitIndex(int32 x, int32 y) const { return ((y & (TileSize - 1)) << TileBits) | (x & (TileSize - 1)); }
+
+		// mask of one tile covered by the clipped rectangle
+		uint64 tileMask(int32 tx, int32 ty, int32 x0, int32 y0, int32 x1, int32 y1) const;
+		bool clipRect(int32& x0, int32& y0, int32& x1, int32& y1) const;
+
+		int32 m_Width = 0;
+		int32 m_Height = 0;
+		int32 m_TilesX = 0;
+		int32 m_TilesY = 0;
+		std::vector<uint64> m_Tiles;
+	};
+}
@@ -0,0 +1,298 @@
+#include "HallwayMeshBuilder.h"
+#include "../Grid/MapRasterizer.h"
+#include <algorithm>
+#include <iterator>
+
+namespace Helpers {
+
+	namespace {
+		const int32 N = HallwayMeshBuilder::ChunkCells;
+
+		// row major, the order cell lists are kept in
+		bool cellLess(const FIntPoint& l, const FIntPoint& r)
+		{
+			return l.Y < r.Y || (l.Y == r.Y && l.X < r.X);
+		}
+
+		// shares vertices of one section by a small integer key
+		struct SectionWriter
+		{
+			HallwaySection& out;
+			TMap<uint32, int32> welded;
+
+			int32 vertex(uint32 key, const FVector& pos, const FVector& normal, const FVector2D& uv)
+			{
+				if (int32* found = welded.Find(key))
+					return *found;
+				const int32 idx = out.vertices.Add(pos);
+				out.normals.Add(normal);
+				out.uvs.Add(uv);
+				welded.Add(key, idx);
+				return idx;
+			}
+
+			// corners in order around the quad, flipped so it faces 'normal'
+			void quad(const int32 v[4], const FVector& normal)
+			{
+				const FVector& p0 = out.vertices[v[0]];
+				const FVector& p1 = out.vertices[v[1]];
+				const FVector& p2 = out.vertices[v[2]];
+				// same face normal convention as the procedural mesh tangent code
+				const bool flip = FVector::DotProduct((p1 - p2) ^ (p0 - p2), normal) < 0.f;
+				if (!flip)
+				{
+					out.triangles.Append({ v[0], v[1], v[2], v[0], v[2], v[3] });
+				}
+				else
+				{
+					out.triangles.Append({ v[0], v[2], v[1], v[0], v[3], v[2] });
+				}
+			}
+		};
+	}
+
+	void HallwayMeshBuilder::init(const GridFrame& frame, int32 width, int32 height, const std::vector<FBox2D>& rooms)
+	{
+		m_Frame = frame;
+		m_Rooms.init(width, height);
+		MapRasterizer::rasterizeRooms(m_Rooms, m_Frame, rooms);
+		m_Chunks.Reset();
+		m_Dirty.Reset();
+		m_HallwayCells.clear();
+	}
+
+	std::vector<FIntPoint> HallwayMeshBuilder::toCells(const std::vector<FBox2D>& rects) const
+	{
+		// cells with their center in [Min, Max), where the rectangles of a bend overlap a cell is kept once
+		std::vector<FIntPoint> cells;
+		const float size = m_Frame.cellSize;
+		for (const FBox2D& b : rects)
+		{
+			const int32 x0 = FMath::CeilToInt((b.Min.X - m_Frame.origin.X) / size - 0.5f);
+			const int32 x1 = FMath::CeilToInt((b.Max.X - m_Frame.origin.X) / size - 0.5f);
+			const int32 y0 = FMath::CeilToInt((b.Min.Y - m_Frame.origin.Y) / size - 0.5f);
+			const int32 y1 = FMath::CeilToInt((b.Max.Y - m_Frame.origin.Y) / size - 0.5f);
+			for (int32 y = y0; y < y1; y++)
+			{
+				for (int32 x = x0; x < x1; x++)
+				{
+					cells.push_back(FIntPoint(x, y));
+				}
+			}
+		}
+		std::sort(cells.begin(), cells.end(), cellLess);
+		cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+		return cells;
+	}
+
+	void HallwayMeshBuilder::stamp(const std::vector<FIntPoint>& cells, int32 delta)
+	{
+		for (const FIntPoint& c : cells)
+		{
+			if (!m_Rooms.inBounds(c.X, c.Y))
+				continue;
+
+			const FIntPoint key(c.X / N, c.Y / N);
+			Chunk* chunk = m_Chunks.Find(key);
+			if (!chunk)
+			{
+				chunk = &m_Chunks.Add(key);
+				FMemory::Memzero(chunk->counts);
+			}
+			int32& count = chunk->counts[(c.Y % N) * N + (c.X % N)];
+			count += delta;
+			// only cells a hallway stamped before are ever taken away
+			check(count >= 0);
+			m_Dirty.Add(key);
+		}
+	}
+
+	void HallwayMeshBuilder::setHallways(const std::vector<std::vector<FBox2D>>& hallways)
+	{
+		m_Chunks.Reset();
+		m_HallwayCells.clear();
+		for (const auto& rects : hallways)
+		{
+			m_HallwayCells.push_back(toCells(rects));
+			stamp(m_HallwayCells.back(), 1);
+		}
+	}
+
+	void HallwayMeshBuilder::setHallway(int32 index, const std::vector<FBox2D>& rects)
+	{
+		if (index < 0)
+			return;
+		if (index >= (int32)m_HallwayCells.size())
+			m_HallwayCells.resize(index + 1);
+
+		std::vector<FIntPoint> cells = toCells(rects);
+		std::vector<FIntPoint>& old = m_HallwayCells[index];
+
+		// both lists are sorted, walk them together and stamp only the difference
+		std::vector<FIntPoint> gone, added;
+		std::set_difference(old.begin(), old.end(), cells.begin(), cells.end(), std::back_inserter(gone), cellLess);
+		std::set_difference(cells.begin(), cells.end(), old.begin(), old.end(), std::back_inserter(added), cellLess);
+		stamp(gone, -1);
+		stamp(added, 1);
+		old.swap(cells);
+	}
+
+	std::vector<FIntPoint> HallwayMeshBuilder::takeDirtyChunks()
+	{
+		// walls look one cell across chunk borders, so neighbours rebuild too
+		TSet<FIntPoint> all;
+		for (const FIntPoint& c : m_Dirty)
+		{
+			all.Add(c);
+			all.Add(c + FIntPoint(1, 0));
+			all.Add(c + FIntPoint(-1, 0));
+			all.Add(c + FIntPoint(0, 1));
+			all.Add(c + FIntPoint(0, -1));
+		}
+		m_Dirty.Reset();
+
+		std::vector<FIntPoint> res;
+		for (const FIntPoint& c : all)
+		{
+			if (c.X >= 0 && c.Y >= 0)
+				res.push_back(c);
+		}
+		return res;
+	}
+
+	bool HallwayMeshBuilder::isHallway(int32 x, int32 y) const
+	{
+		if (!m_Rooms.inBounds(x, y))
+			return false;
+		const Chunk* chunk = m_Chunks.Find(FIntPoint(x / N, y / N));
+		return chunk && chunk->counts[(y % N) * N + (x % N)] > 0;
+	}
+
+	void HallwayMeshBuilder::buildChunk(const FIntPoint& chunk, HallwaySection& out) const
+	{
+		out.chunk = chunk;
+		out.vertices.Reset();
+		out.triangles.Reset();
+		out.normals.Reset();
+		out.uvs.Reset();
+		if (!m_Chunks.Contains(chunk))
+			return;
+
+		const int32 baseX = chunk.X * N;
+		const int32 baseY = chunk.Y * N;
+		const float size = m_Frame.cellSize;
+		const float top = m_FloorZ + m_WallHeight;
+
+		bool mask[N * N];
+		for (int32 y = 0; y < N; y++)
+		{
+			for (int32 x = 0; x < N; x++)
+			{
+				mask[y * N + x] = isHallway(baseX + x, baseY + y) && !m_Rooms.get(baseX + x, baseY + y);
+			}
+		}
+
+		SectionWriter w{ out };
+		auto corner = [&](int32 lx, int32 ly, float z)
+		{
+			return FVector(m_Frame.origin.X + (baseX + lx) * size, m_Frame.origin.Y + (baseY + ly) * size, z);
+		};
+
+		// floors, greedy rectangles
+		bool used[N * N] = {};
+		for (int32 y = 0; y < N; y++)
+		{
+			for (int32 x = 0; x < N; x++)
+			{
+				if (!mask[y * N + x] || used[y * N + x])
+					continue;
+
+				int32 x1 = x;
+				while (x1 + 1 < N && mask[y * N + x1 + 1] && !used[y * N + x1 + 1])
+					x1++;
+
+				int32 y1 = y;
+				for (bool grow = true; grow && y1 + 1 < N; )
+				{
+					for (int32 i = x; i <= x1; i++)
+					{
+						if (!mask[(y1 + 1) * N + i] || used[(y1 + 1) * N + i])
+						{
+							grow = false;
+							break;
+						}
+					}
+					if (grow)
+						y1++;
+				}
+
+				for (int32 j = y; j <= y1; j++)
+				{
+					for (int32 i = x; i <= x1; i++)
+					{
+						used[j * N + i] = true;
+					}
+				}
+
+				const int32 cx[4] = { x, x1 + 1, x1 + 1, x };
+				const int32 cy[4] = { y, y, y1 + 1, y1 + 1 };
+				int32 v[4];
+				for (int32 k = 0; k < 4; k++)
+				{
+					const FVector p = corner(cx[k], cy[k], m_FloorZ);
+					v[k] = w.vertex((uint32)(cy[k] * (N + 1) + cx[k]), p, FVector::UpVector, FVector2D(p.X, p.Y) / 100.f);
+				}
+				w.quad(v, FVector::UpVector);
+			}
+		}
+
+		// walls, merged runs along each side that faces solid ground.
+		// Keys start after the floor corners, one block per side and height
+		auto wallKey = [](int32 d, int32 high, int32 lx, int32 ly)
+		{
+			return (uint32)((((d * 2 + high) * (N + 1) + ly) * (N + 1) + lx) + (N + 1) * (N + 1));
+		};
+		const FIntPoint dirs[4] = { FIntPoint(1, 0), FIntPoint(-1, 0), FIntPoint(0, 1), FIntPoint(0, -1) };
+		for (int32 d = 0; d < 4; d++)
+		{
+			const FIntPoint dir = dirs[d];
+			const bool alongY = dir.X != 0;
+			const FVector normal(-dir.X, -dir.Y, 0.f);
+
+			for (int32 line = 0; line < N; line++)
+			{
+				int32 runStart = -1;
+				for (int32 i = 0; i <= N; i++)
+				{
+					bool wall = false;
+					if (i < N)
+					{
+						const int32 x = alongY ? line : i;
+						const int32 y = alongY ? i : line;
+						wall = mask[y * N + x] && !isOpen(baseX + x + dir.X, baseY + y + dir.Y);
+					}
+					if (wall && runStart < 0)
+						runStart = i;
+					if (wall || runStart < 0)
+						continue;
+
+					// the wall sits on the far edge of the cell in 'dir'
+					const int32 edge = line + (dir.X + dir.Y > 0 ? 1 : 0);
+					const int32 ax = alongY ? edge : runStart;
+					const int32 ay = alongY ? runStart : edge;
+					const int32 bx = alongY ? edge : i;
+					const int32 by = alongY ? i : edge;
+					const float length = (i - runStart) * size / 100.f;
+
+					int32 v[4];
+					v[0] = w.vertex(wallKey(d, 0, ax, ay), corner(ax, ay, m_FloorZ), normal, FVector2D(0.f, 0.f));
+					v[1] = w.vertex(wallKey(d, 0, bx, by), corner(bx, by, m_FloorZ), normal, FVector2D(length, 0.f));
+					v[2] = w.vertex(wallKey(d, 1, bx, by), corner(bx, by, top), normal, FVector2D(length, m_WallHeight / 100.f));
+					v[3] = w.vertex(wallKey(d, 1, ax, ay), corner(ax, ay, top), normal, FVector2D(0.f, m_WallHeight / 100.f));
+					w.quad(v, normal);
+					runStart = -1;
+				}
+			}
+		}
+	}
+}
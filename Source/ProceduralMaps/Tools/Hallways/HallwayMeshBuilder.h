@@ -0,0 +1,64 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "../Grid/OccupancyGrid.h"
+#include <vector>
+
+namespace Helpers {
+
+	// geometry of one chunk, ready for a procedural mesh section
+	struct HallwaySection
+	{
+		FIntPoint chunk;
+		TArray<FVector> vertices;
+		TArray<int32> triangles;
+		TArray<FVector> normals;
+		TArray<FVector2D> uvs;
+	};
+
+	// Builds floor and wall geometry for hallways. The rectangles of every
+	// hallway are stamped into grid cells (one cell = hallway width, a cell goes
+	// to the rectangles its center is in) and room cells are left open, so the
+	// floor covers the same cells as the CorridorUnion pieces and straight runs
+	// and junctions merge by construction. The grid is split into chunks and each
+	// chunk becomes one section: floors are greedy merged rectangles, walls are
+	// merged runs along cell borders that face neither a hallway nor a room,
+	// and vertices are shared inside a section.
+	class HallwayMeshBuilder {
+
+	public:
+		static const int32 ChunkCells = 32;
+
+		float m_WallHeight = 300.f;
+		float m_FloorZ = 0.f;
+
+		// frame cell size is the hallway width, rooms are left open
+		void init(const GridFrame& frame, int32 width, int32 height, const std::vector<FBox2D>& rooms);
+
+		// one list of rectangles per hallway, see CorridorUnion::rects
+		void setHallways(const std::vector<std::vector<FBox2D>>& hallways);
+		// replace one hallway, only chunks with its cells that came or went get dirty
+		void setHallway(int32 index, const std::vector<FBox2D>& rects);
+
+		std::vector<FIntPoint> takeDirtyChunks();
+		// read only, safe to call for many chunks in parallel
+		void buildChunk(const FIntPoint& chunk, HallwaySection& out) const;
+
+	private:
+		struct Chunk
+		{
+			int32 counts[ChunkCells * ChunkCells];	// hallways covering each cell, any number of them
+		};
+
+		void stamp(const std::vector<FIntPoint>& cells, int32 delta);
+		std::vector<FIntPoint> toCells(const std::vector<FBox2D>& rects) const;
+		bool isHallway(int32 x, int32 y) const;
+		inline bool isOpen(int32 x, int32 y) const { return isHallway(x, y) || m_Rooms.get(x, y); }
+
+		GridFrame m_Frame;
+		OccupancyGrid m_Rooms;
+		TMap<FIntPoint, Chunk> m_Chunks;
+		TSet<FIntPoint> m_Dirty;
+		std::vector<std::vector<FIntPoint>> m_HallwayCells;	// sorted, what each hallway stamped
+	};
+}
@@ -0,0 +1,52 @@
+#include "MapMemory.h"
+
+namespace Helpers {
+
+	MapPool::~MapPool()
+	{
+		for (void* chunk : m_Chunks)
+		{
+			FMemory::Free(chunk);
+		}
+	}
+
+	void* MapPool::allocate(size_t bytes, size_t alignment)
+	{
+		if (!pooled(bytes, alignment))
+			return FMemory::Malloc(bytes, (uint32)alignment);
+
+		const int32 c = sizeClass(bytes);
+		if (void* p = m_Free[c])
+		{
+			m_Free[c] = *(void**)p;
+			return p;
+		}
+
+		const size_t size = (c + 1) * Granularity;
+		if (m_Left < size)
+		{
+			// what is left of the old chunk is dropped
+			m_Next = (uint8*)FMemory::Malloc(ChunkBytes, Granularity);
+			m_Chunks.push_back(m_Next);
+			m_Left = ChunkBytes;
+		}
+		void* p = m_Next;
+		m_Next += size;
+		m_Left -= size;
+		return p;
+	}
+
+	void MapPool::deallocate(void* p, size_t bytes, size_t alignment)
+	{
+		if (!pooled(bytes, alignment))
+		{
+			FMemory::Free(p);
+			return;
+		}
+
+		// the block's first bytes hold the next free one
+		const int32 c = sizeClass(bytes);
+		*(void**)p = m_Free[c];
+		m_Free[c] = p;
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+
+namespace Helpers {
+
+	// Where the scratch of a generation stage gets its memory from, see MapArena.
+	// Own interface rather than std::pmr, whose <memory_resource> is missing
+	// from the libc++ of some of the engine's toolchains.
+	class MapMemory {
+
+	public:
+		virtual ~MapMemory() {}
+
+		virtual void* allocate(size_t bytes, size_t alignment) = 0;
+		virtual void deallocate(void* p, size_t bytes, size_t alignment) = 0;
+
+		// plain FMemory, the default everywhere a MapMemory is taken
+		static MapMemory* heap()
+		{
+			struct Heap : MapMemory
+			{
+				virtual void* allocate(size_t bytes, size_t alignment) override { return FMemory::Malloc(bytes, (uint32)alignment); }
+				virtual void deallocate(void* p, size_t bytes, size_t alignment) override { FMemory::Free(p); }
+			};
+			static Heap instance;
+			return &instance;
+		}
+	};
+
+	// Free lists per size for scratch that is freed and taken again, like the
+	// nodes of a hash map that is cleared between searches. Freed memory goes
+	// back to its list, chunks are only given back when the pool dies.
+	// Not thread safe, use one per worker.
+	class MapPool : public MapMemory {
+
+	public:
+		MapPool() {}
+		~MapPool();
+
+		MapPool(const MapPool&) = delete;
+		MapPool& operator=(const MapPool&) = delete;
+
+		virtual void* allocate(size_t bytes, size_t alignment) override;
+		virtual void deallocate(void* p, size_t bytes, size_t alignment) override;
+
+	private:
+		// sizes are rounded up to this, bigger ones go straight to the heap
+		static const size_t Granularity = 16;
+		static const size_t MaxPooled = 512;
+		static const size_t ChunkBytes = 64 << 10;
+
+		static bool pooled(size_t bytes, size_t alignment) { return bytes <= MaxPooled && alignment <= Granularity; }
+		static int32 sizeClass(size_t bytes) { return (int32)((FMath::Max<size_t>(bytes, 1) + Granularity - 1) / Granularity) - 1; }
+
+		void* m_Free[MaxPooled / Granularity] = {};
+		std::vector<void*> m_Chunks;
+		uint8* m_Next = nullptr;
+		size_t m_Left = 0;
+	};
+
+	// Standard allocator over a MapMemory. Like std::pmr a copied container
+	// goes back to the heap, so nothing copied out of a stage points into
+	// memory that is rewound after it.
+	template<typename T>
+	struct MapAllocator
+	{
+		using value_type = T;
+
+		MapMemory* mem;
+
+		MapAllocator(MapMemory* inMem = MapMemory::heap()) noexcept : mem(inMem) {}
+		template<typename U>
+		MapAllocator(const MapAllocator<U>& other) noexcept : mem(other.mem) {}
+
+		T* allocate(size_t n) { return (T*)mem->allocate(n * sizeof(T), alignof(T)); }
+		void deallocate(T* p, size_t n) { mem->deallocate(p, n * sizeof(T), alignof(T)); }
+
+		MapAllocator select_on_container_copy_construction() const { return MapAllocator(); }
+
+		template<typename U>
+		bool operator==(const MapAllocator<U>& other) const { return mem == other.mem; }
+		template<typename U>
+		bool operator!=(const MapAllocator<U>& other) const { return mem != other.mem; }
+	};
+
+	template<typename T>
+	using MapVector = std::vector<T, MapAllocator<T>>;
+	template<typename T>
+	using MapHashSet = std::unordered_set<T, std::hash<T>, std::equal_to<T>, MapAllocator<T>>;
+	template<typename K, typename V>
+	using MapHashMap = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>, MapAllocator<std::pair<const K, V>>>;
+}
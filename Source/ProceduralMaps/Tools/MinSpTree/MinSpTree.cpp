@@ -1,16 +1,22 @@
 #include "MinSpTree.h"
-#include "Math/Vector.h"
-#include "Containers/Map.h"
+#include "Math/RandomStream.h"
+
+MinSpTree::MinSpTree(Helpers::MapMemory* mem)
+    : _costPairs(mem)
+    , _isLoop(mem)
+    , _root(mem)
+{
+}
 
 // Kruskal's algorithm Minimum Spanning tree
-vector<pair<FVector2D, FVector2D>> MinSpTree::getMinCostPairs()
+Helpers::MapVector<pair<int, int>> MinSpTree::getMinCostPairs()
 {
     _size = _costPairs.size(); 
     fillRootMap();
-    FVector2D a, b;
+    int a, b;
     float cost = 0.f;
-    vector<pair<FVector2D, FVector2D>> res;
-    for (auto p : _costPairs)
+    Helpers::MapVector<pair<int, int>> res(_costPairs.get_allocator());
+    for (const auto& p : _costPairs)
     {
         a = p.second.first;
         b = p.second.second;
@@ -27,29 +33,27 @@ vector<pair<FVector2D, FVector2D>> MinSpTree::getMinCostPairs()
 }
 
 // add pair
-void MinSpTree::addPair(FVector2D a, FVector2D b)
+void MinSpTree::addPair(int a, int b)
 {
-    FVector2D aR = getRoot(a);
-    FVector2D bR = getRoot(b);
-    _rootMap[aR] = _rootMap[bR];
+    _root[getRoot(a)] = getRoot(b);
 }
 
 void MinSpTree::clear()
 {
     _size = 0;
     _minCost = 0;
-    _rootMap.Reset();
+    _root.clear();
 }
 
 // adding some circular edges
-vector<pair<FVector2D, FVector2D>> MinSpTree::getNaturalCostPairs()
+Helpers::MapVector<pair<int, int>> MinSpTree::getNaturalCostPairs()
 {
     _size = _costPairs.size();
     fillRootMap();
-    FVector2D a, b;
+    int a, b;
     float cost = 0.f;
-    vector<pair<FVector2D, FVector2D>> res;
-    for (auto p : _costPairs)
+    Helpers::MapVector<pair<int, int>> res(_costPairs.get_allocator());
+    for (const auto& p : _costPairs)
     {
         a = p.second.first;
         b = p.second.second;
@@ -70,28 +74,58 @@ vector<pair<FVector2D, FVector2D>> MinSpTree::getNaturalCostPairs()
     return res;
 }
 
+// seeded version, edges are taken cheapest first. Equal costs go by room ids,
+// so every standard library sorts them the same way
+Helpers::MapVector<pair<int, int>> MinSpTree::getNaturalCostPairs(FRandomStream& stream, float loopChance)
+{
+    sort(_costPairs.begin(), _costPairs.end());
+    _size = _costPairs.size();
+    fillRootMap();
+    _isLoop.clear();
+    Helpers::MapVector<pair<int, int>> res(_costPairs.get_allocator());
+    for (const auto& p : _costPairs)
+    {
+        const int a = p.second.first;
+        const int b = p.second.second;
+        // check if roots are creating a cycle
+        if (getRoot(a) != getRoot(b))
+        {
+            _minCost += p.first;
+            res.push_back({ a,b });
+            _isLoop.push_back(0);
+            addPair(a, b);
+        }
+        else if (stream.FRand() < loopChance)
+        {
+            res.push_back({ a,b });
+            _isLoop.push_back(1);
+        }
+    }
+    return res;
+}
+
 // finds the root
-FVector2D MinSpTree::getRoot(FVector2D val)
+int MinSpTree::getRoot(int id)
 {
-    while (_rootMap[val] != val)
+    while (_root[id] != id)
     {
-        _rootMap[val] = _rootMap[_rootMap[val]];
-        val = _rootMap[val];
-        
+        _root[id] = _root[_root[id]];
+        id = _root[id];
     }
-    return val;
+    return id;
 }
 
 void MinSpTree::fillRootMap()
 {
-    // fil rootmap
-    for (auto p : _costPairs)
+    // every id its own root, sized by the largest id in the pairs
+    int count = 0;
+    for (const auto& p : _costPairs)
+    {
+        count = max(count, max(p.second.first, p.second.second) + 1);
+    }
+    _root.resize(count);
+    for (int i = 0; i < count; i++)
     {
-        auto pair = p.second;
-        _rootMap.Add(pair.first, pair.first);
-        _rootMap.Add(pair.second, pair.second);
+        _root[i] = i;
     }
 }
-
-
-
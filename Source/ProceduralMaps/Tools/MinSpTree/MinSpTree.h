@@ -3,31 +3,39 @@
 #include <vector>
 #include <utility>
 #include <algorithm>
+#include "../MapMemory.h"
 
 using namespace std;
 
-struct FVector2D;
+struct FRandomStream;
 
+// Kruskal over room ids, ids are small and dense so the roots are a plain array
 class MinSpTree {
 
 
 public:
-    vector<pair<FVector2D, FVector2D>> getMinCostPairs();
+    // pairs, results and the roots all use 'mem'
+    explicit MinSpTree(Helpers::MapMemory* mem = Helpers::MapMemory::heap());
+
+    Helpers::MapVector<pair<int, int>> getMinCostPairs();
     inline float getCost() { return _minCost; };
-    FVector2D getRoot(FVector2D val);
+    int getRoot(int id);
     void fillRootMap();
-    void addPair(FVector2D a, FVector2D b);
+    void addPair(int a, int b);
     void clear();
 
     // custom for real dungeon graph and adding more pairs
-    vector<pair<FVector2D, FVector2D>> getNaturalCostPairs();
+    Helpers::MapVector<pair<int, int>> getNaturalCostPairs();
+    // same with a seeded stream, fills _isLoop for every returned pair
+    Helpers::MapVector<pair<int, int>> getNaturalCostPairs(FRandomStream& stream, float loopChance);
 
 public:
-    vector<pair<float, pair<FVector2D, FVector2D>>> _costPairs;
+    Helpers::MapVector<pair<float, pair<int, int>>> _costPairs;
+    Helpers::MapVector<uint8> _isLoop;
 private:
-    TMap<FVector2D, FVector2D> _rootMap;
-    float _minCost;
-    int _size;
+    Helpers::MapVector<int> _root;
+    float _minCost = 0.f;
+    int _size = 0;
 };
 
 /*
@@ -16,4 +16,25 @@ enum class Pro_States : uint8
 	DrawMinSpanTree = 5  UMETA(DisplayName = "Draw Minimum Spanning Tree"),
 	DrawHallWays = 6  UMETA(DisplayName = "Draw Hallways"),
 	None = 7
-};
\ No newline at end of file
+};
+
+// what the AI flow fields of a finished map lead to
+UENUM(BlueprintType)
+enum class EMapGoal : uint8
+{
+	Start = 0  UMETA(DisplayName = "Start room"),
+	Boss = 1  UMETA(DisplayName = "Boss room"),
+	Treasure = 2  UMETA(DisplayName = "Nearest treasure room"),
+	Count = 3  UMETA(Hidden)
+};
+
+// how hallways are picked from the triangles, mirrors Helpers::MapGraphMode
+UENUM(BlueprintType)
+enum class EMapGraphMode : uint8
+{
+	Spanning = 0  UMETA(DisplayName = "Spanning tree and random loops"),
+	Gabriel = 1  UMETA(DisplayName = "Gabriel graph"),
+	RelativeNeighbourhood = 2  UMETA(DisplayName = "Relative neighbourhood graph"),
+	BetaSkeleton = 3  UMETA(DisplayName = "Beta skeleton"),
+	Spanner = 4  UMETA(DisplayName = "Greedy spanner")
+};